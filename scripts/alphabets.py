@@ -6,6 +6,7 @@ import sys
 
 #Use this script if you want get all unique symbols from all alphabets.
 #This unique symbols need for math parser.
+#Run with option --table to get lookup table of symbols for C++ (save it to src/app/container/alphabets.h).
 #Example:
 # ցЀĆЈVӧĎАғΕĖӅИқΝĞơРңњΥĦШҫ̆جگĮаҳѕεشԶиһνԾрυلՆӝшËՎҔPÓՖXӛӟŞӣզhëծpóӞնxßվāŁЃֆĉЋCŬđҐГΒęҘЛΚŘġҠУGاհЫدԱҰгβطԹõлκKՁÀуςهՉÈыvیՑÐSOřӘћաőcӐթèkàѓżűðsķչøӥӔĀփїІĈЎґĐΗЖҙĘȚ
 # ΟОҡĠآΧЦتЮұİزηжԸغοоÁՀقχцÉՈيюÑՐђӋіәťӆўáŠĺѐfөըnñŰӤӨӹոľЁրăЉŭċБӸēłΔҖЙŤěΜӜDСձģΤӰЩīņحҮбưԳصδHйԻŇμӲӴсՃمτƠщՋєLQŹՓŕÖYśÞaգĽæiŽիӓîqճöyջþĂօЄӦĊЌΑĒДҗјΙȘĚМΡéĵĢФūӚΩبĪЬүќ
@@ -95,6 +96,47 @@ GERMAN_ALPHABET, NORWEGIAN_ALPHABET, OSETIAN_ALPHABET, POLISH_ALPHABET, PORTUGUE
 TUVIN_ALPHABET, TURKISH_ALPHABET, UDMURT_ALPHABET, UZBEK_ALPHABET, UKRAINIAN_ALPHABET, FARSI_ALPHABET, PHILIPPINES_ALPHABET, FINNISH_ALPHABET, FRENCH_ALPHABET, HAKASS_ALPHABET,HANTY_ALPHABET,
 BOSNIAN_ALPHABET, CROATIAN_ALPHABET, CZECH_ALPHABET, CHUVASH_ALPHABET, SWEDISH_ALPHABET, ESPERANTO_ALPHABET, ESTONIAN_ALPHABET, YAKUTIAN_ALPHABET, MONTENEGRIN_ALPHABET)
 
-L = list(SYMBOLS)
-print ''.join(L)
+def print_table(symbols):
+    """Print two-level lookup table of symbols: index of bitmap for high byte and bitmaps of low byte."""
+    blocks = [[0, 0, 0, 0]]
+    index = []
+    for high in range(256):
+        bits = [0, 0, 0, 0]
+        for symbol in symbols:
+            code = ord(symbol)
+            if code >> 8 == high:
+                low = code & 0xFF
+                bits[low >> 6] |= 1 << (low & 63)
+        if bits not in blocks:
+            blocks.append(bits)
+        index.append(blocks.index(bits))
+
+    print '// This file was generated by scripts/alphabets.py --table. Don\'t edit it manually.'
+    print ''
+    print '#ifndef ALPHABETS_H'
+    print '#define ALPHABETS_H'
+    print ''
+    print '#include <QtGlobal>'
+    print ''
+    print '// Index of bitmap in alphabetBlocks for high byte of UTF-16 code unit.'
+    print 'static const quint8 alphabetIndex[256] = {'
+    for row in range(0, 256, 32):
+        print '    ' + ', '.join(str(i) for i in index[row:row + 32]) + ','
+    print '};'
+    print ''
+    print '// Bitmaps of low byte of UTF-16 code unit.'
+    print 'static const quint64 alphabetBlocks[%d][4] = {' % len(blocks)
+    for bits in blocks:
+        words = ['Q_UINT64_C(0x%016x)' % b for b in bits]
+        print '    {' + ', '.join(words[:2]) + ','
+        print '     ' + ', '.join(words[2:]) + '},'
+    print '};'
+    print ''
+    print '#endif // ALPHABETS_H'
+
+if len(sys.argv) > 1 and sys.argv[1] == '--table':
+    print_table(SYMBOLS)
+else:
+    L = list(SYMBOLS)
+    print ''.join(L)
 
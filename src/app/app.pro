@@ -11,7 +11,7 @@ include(../../Valentina.pri)
 
 # Here we don't see "network" library, but, i think, "printsupport" depend on this library, so we still need this
 # library in installer.
-QT       += core gui widgets xml svg printsupport xmlpatterns
+QT       += core gui widgets xml svg printsupport xmlpatterns concurrent
 
 # We want create executable file
 TEMPLATE = app
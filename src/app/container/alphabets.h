@@ -0,0 +1,42 @@
+// This file was generated by scripts/alphabets.py --table. Don't edit it manually.
+
+#ifndef ALPHABETS_H
+#define ALPHABETS_H
+
+#include <QtGlobal>
+
+// Index of bitmap in alphabetBlocks for high byte of UTF-16 code unit.
+static const quint8 alphabetIndex[256] = {
+    1, 2, 3, 4, 5, 6, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 0,
+};
+
+// Bitmaps of low byte of UTF-16 code unit.
+static const quint64 alphabetBlocks[9][4] = {
+    {Q_UINT64_C(0x0000000000000000), Q_UINT64_C(0x0000000000000000),
+     Q_UINT64_C(0x0000000000000000), Q_UINT64_C(0x0000000000000000)},
+    {Q_UINT64_C(0x0000000000000000), Q_UINT64_C(0x07fffffe07fffffe),
+     Q_UINT64_C(0x0000000000000000), Q_UINT64_C(0x757feff7f57feff7)},
+    {Q_UINT64_C(0x7ef3ccffffffffff), Q_UINT64_C(0x7e0ffc33ff3301fe),
+     Q_UINT64_C(0x0001800300008000), Q_UINT64_C(0x0000000000000000)},
+    {Q_UINT64_C(0x000000000f000000), Q_UINT64_C(0x0000000002000000),
+     Q_UINT64_C(0x0000000000000000), Q_UINT64_C(0x0000000000000000)},
+    {Q_UINT64_C(0x0000000000000140), Q_UINT64_C(0x0000000000000000),
+     Q_UINT64_C(0xfffe03fbfffe0000), Q_UINT64_C(0x00000000000003ff)},
+    {Q_UINT64_C(0xffffffffffffffff), Q_UINT64_C(0x00000000ffffffff),
+     Q_UINT64_C(0x0ccfcc3f0fff0000), Q_UINT64_C(0x033fcffcff3f1860)},
+    {Q_UINT64_C(0xfffe000000000000), Q_UINT64_C(0xfffffffe007fffff),
+     Q_UINT64_C(0x00000000000000ff), Q_UINT64_C(0x0000000000000000)},
+    {Q_UINT64_C(0x07fffd8e00000000), Q_UINT64_C(0x40000000000005fe),
+     Q_UINT64_C(0x0000820001000040), Q_UINT64_C(0x0000000000001000)},
+    {Q_UINT64_C(0x0000000000000000), Q_UINT64_C(0x0000000000000000),
+     Q_UINT64_C(0x0000000000000000), Q_UINT64_C(0x0000020000000000)},
+};
+
+#endif // ALPHABETS_H
@@ -29,28 +29,64 @@
 #include "calculator.h"
 #include <QDebug>
 #include <QSettings>
+#include <QThread>
+#include <QThreadStorage>
 #include "../core/vapplication.h"
 #include "vcontainer.h"
+#include "alphabets.h"
 
 using namespace qmu;
 
+QCache<QString, Calculator::CompiledFormula> Calculator::formulaCache(4096);
+QMutex Calculator::cacheMutex;
+qint64 Calculator::cacheHits = 0;
+qint64 Calculator::cacheMisses = 0;
+const int Calculator::jitThreshold = 16;
+
+/**
+ * @brief The CalculatorPool class keep calculators of one thread ready for reuse.
+ */
+class CalculatorPool
+{
+public:
+    CalculatorPool() : calculators() {}
+    ~CalculatorPool() { qDeleteAll(calculators); }
+    QVector<Calculator *> calculators;
+private:
+    Q_DISABLE_COPY(CalculatorPool)
+};
+
+static QThreadStorage<CalculatorPool *> calculatorPool;
+
+/**
+ * @brief The CalculatorLane struct keep values of formulas for lane (size and height) that current thread grades.
+ */
+struct CalculatorLane
+{
+    CalculatorLane() : values(nullptr), lane(0) {}
+    const QHash<QString, QVector<qreal> > *values;
+    int lane;
+};
+
+static QThreadStorage<CalculatorLane *> calculatorLane;
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief Calculator class constructor. Make easy initialization math parser.
  *
  * This constructor hide initialization variables, operators, character sets.
  * Use this constuctor for evaluation formula. All formulas must be converted to internal look.
+ * Usually you don't need create calculator for evaluation, use static method EvalFormula(data, formula) instead.
  * Example:
  *
  * const QString formula = qApp->FormulaFromUser(edit->text());
- * Calculator *cal = new Calculator(data);
- * const qreal result = cal->EvalFormula(formula);
- * delete cal;
+ * const qreal result = Calculator::EvalFormula(data, formula);
  *
  * @param data pointer to a variable container.
  */
 Calculator::Calculator(const VContainer *data)
-    :QmuParser(), vVarVal(nullptr), data(data)
+    :QmuParser(), vVarVal(new qreal[2]), data(data), jitStack(), dagValues(), gradedValues(), unbound(),
+      unboundValue(0), laneSizes(), laneHeights(), laneValues(), lanesPure(true)
 {
     InitCharacterSets();
     setAllowSubexpressions(false);//Only one expression per time
@@ -75,7 +111,8 @@ Calculator::Calculator(const VContainer *data)
  * @param fromUser true if we parse formula from user
  */
 Calculator::Calculator(const QString &formula, bool fromUser)
-    :QmuParser(), vVarVal(nullptr), data(nullptr)
+    :QmuParser(), vVarVal(nullptr), data(nullptr), jitStack(), dagValues(), gradedValues(), unbound(),
+      unboundValue(0), laneSizes(), laneHeights(), laneValues(), lanesPure(true)
 {
     InitCharacterSets();
     setAllowSubexpressions(false);//Only one expression per time
@@ -101,84 +138,670 @@ Calculator::~Calculator()
  */
 qreal Calculator::EvalFormula(const QString &formula)
 {
-    SetVarFactory(AddVariable, this);
     SetSepForEval();//Reset separators options
 
+    qreal result = 0;
+    if (EvalCompiled(formula, result))
+    {
+        return result;
+    }
+
+    // Variables are bound to values from container while parser builds bytecode, so one pass is enough.
+    ClearVar();
+    SetVarFactory(BindVariable, this);
     SetExpr(formula);
 
-    qreal result = 0;
     result = Eval();
+    CacheFormula(formula);
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief EvalFormula calculate formula with calculator from pool of current thread.
+ *
+ * Calculator is created only first time, after that it is reset for each formula. Variables and expression are cleared,
+ * but callbacks and character sets stay. All formulas must be converted to internal look.
+ * If current thread grades lane and formula was evaluated for all lanes in bulk (see SetThreadLane()) value is taken
+ * from there.
+ * @param data pointer to a variable container.
+ * @param formula string of formula.
+ * @return value of formula.
+ */
+qreal Calculator::EvalFormula(const VContainer *data, const QString &formula)
+{
+    if (calculatorLane.hasLocalData() && calculatorLane.localData()->values != nullptr)
+    {
+        const CalculatorLane *lane = calculatorLane.localData();
+        QHash<QString, QVector<qreal> >::const_iterator it = lane->values->constFind(formula);
+        if (it != lane->values->constEnd())
+        {
+            return it.value().at(lane->lane);
+        }
+    }
+
+    Calculator *cal = TakeFromPool(data);
+    qreal result = 0;
+    try
+    {
+        result = cal->EvalFormula(formula);
+    }
+    catch (...)
+    {
+        ReturnToPool(cal);
+        throw;
+    }
+    ReturnToPool(cal);
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CompileFormula check formula and put it to the cache of compiled formulas without evaluation for pattern.
+ *
+ * Names that don't exist in container yet (points, lines and curves of tools not parsed yet) are accepted and
+ * returned, caller decides if some tool will create them. Formula is cached only if all its variables exist, otherwise
+ * tool will compile it when evaluates. Can be called from any thread.
+ * @param data pointer to a variable container.
+ * @param formula string of formula in internal look.
+ * @return names of variables that don't exist in container by position in formula.
+ * @throw QmuParserError if formula has error.
+ */
+QMap<int, QString> Calculator::CompileFormula(const VContainer *data, const QString &formula)
+{
+    Calculator *cal = TakeFromPool(data);
+    QMap<int, QString> unbound;
+    try
+    {
+        unbound = cal->Compile(formula);
+    }
+    catch (...)
+    {
+        ReturnToPool(cal);
+        throw;
+    }
+    ReturnToPool(cal);
+    return unbound;
+}
 
-    QMap<int, QString> tokens = this->GetTokens();
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief EvalSensitivity calculate partial derivatives of formula with calculator from pool of current thread.
+ *
+ * Derivatives are calculated only by measurements, increments, size and height, other variables don't change with
+ * gradation.
+ * @param data pointer to a variable container.
+ * @param formula string of formula in internal look.
+ * @return derivatives by handle of variable name (see VNameTable).
+ * @throw QmuParserError if formula has error.
+ */
+QMap<quint32, qreal> Calculator::EvalSensitivity(const VContainer *data, const QString &formula)
+{
+    Calculator *cal = TakeFromPool(data);
+    QMap<quint32, qreal> result;
+    try
+    {
+        result = cal->Sensitivity(formula);
+    }
+    catch (...)
+    {
+        ReturnToPool(cal);
+        throw;
+    }
+    ReturnToPool(cal);
+    return result;
+}
 
-    // Remove "-" from tokens list if exist. If don't do that unary minus operation will broken.
-    RemoveAll(tokens, "-");
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief EvalDual calculate formula with its gradient by size and height with calculator from pool of current thread.
+ *
+ * Gradient is grade rule of formula: how much value changes for one unit of size (Grad[0]) and height (Grad[1]).
+ * Gradient is zero for pattern with individual measurements.
+ * @param data pointer to a variable container.
+ * @param formula string of formula in internal look.
+ * @return value and gradient of formula.
+ * @throw QmuParserError if formula has error.
+ */
+qmu::QmuDual Calculator::EvalDual(const VContainer *data, const QString &formula)
+{
+    Calculator *cal = TakeFromPool(data);
+    qmu::QmuDual result;
+    try
+    {
+        result = cal->Dual(formula);
+    }
+    catch (...)
+    {
+        ReturnToPool(cal);
+        throw;
+    }
+    ReturnToPool(cal);
+    return result;
+}
 
-    if (tokens.isEmpty())
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief EvalLanes calculate formula for many combinations of size and height (lanes) at once.
+ *
+ * Measurements and increments get array of graded values, one for each lane, and parser evaluates bytecode for all
+ * lanes in bulk. Only formulas that depend just on measurements, increments, size and height can be evaluated this way,
+ * values of other variables are different in each lane.
+ * @param data pointer to a variable container.
+ * @param formula string of formula in internal look.
+ * @param sizes size of each lane in pattern units.
+ * @param heights height of each lane in pattern units.
+ * @return value of formula for each lane or empty vector if formula uses other variables.
+ * @throw QmuParserError if formula has error.
+ */
+QVector<qreal> Calculator::EvalLanes(const VContainer *data, const QString &formula, const QVector<qreal> &sizes,
+                                     const QVector<qreal> &heights)
+{
+    SCASSERT(sizes.size() == heights.size());
+    Calculator *cal = TakeFromPool(data);
+    QVector<qreal> result;
+    try
     {
-        return result;
+        result = cal->Lanes(formula, sizes, heights);
+    }
+    catch (...)
+    {
+        ReturnToPool(cal);
+        throw;
+    }
+    ReturnToPool(cal);
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SetThreadLane make EvalFormula() on current thread take values of formulas from bulk evaluation.
+ * @param values values of formulas for all lanes (see EvalLanes()). Must live until ClearThreadLane().
+ * @param lane index of lane that current thread grades.
+ */
+void Calculator::SetThreadLane(const QHash<QString, QVector<qreal> > *values, int lane)
+{
+    if (calculatorLane.hasLocalData() == false)
+    {
+        calculatorLane.setLocalData(new CalculatorLane());
+    }
+    calculatorLane.localData()->values = values;
+    calculatorLane.localData()->lane = lane;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ClearThreadLane stop taking values of formulas from bulk evaluation on current thread.
+ */
+void Calculator::ClearThreadLane()
+{
+    if (calculatorLane.hasLocalData())
+    {
+        calculatorLane.localData()->values = nullptr;
     }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief FormulaCacheHits return how many times formula was evaluated from compiled formulas cache.
+ */
+qint64 Calculator::FormulaCacheHits()
+{
+    QMutexLocker locker(&cacheMutex);
+    return cacheHits;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief FormulaCacheMisses return how many times formula was parsed from string.
+ */
+qint64 Calculator::FormulaCacheMisses()
+{
+    QMutexLocker locker(&cacheMutex);
+    return cacheMisses;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ClearFormulaCache remove all compiled formulas, nodes of expression graph and reset counters.
+ */
+void Calculator::ClearFormulaCache()
+{
+    QMutexLocker locker(&cacheMutex);
+    formulaCache.clear();
+    VFormulaDag::Clear();
+    cacheHits = 0;
+    cacheMisses = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief TakeFromPool take calculator from pool of current thread.
+ *
+ * Pool can be empty if evaluation was called while another one is not finished yet, then new calculator is created.
+ * @param data pointer to a variable container.
+ * @return calculator. Must be returned by ReturnToPool().
+ */
+Calculator *Calculator::TakeFromPool(const VContainer *data)
+{
+    if (calculatorPool.hasLocalData() == false)
+    {
+        calculatorPool.setLocalData(new CalculatorPool());
+    }
+    QVector<Calculator *> &calculators = calculatorPool.localData()->calculators;
+
+    Calculator *cal = calculators.isEmpty() ? new Calculator(data) : calculators.takeLast();
+    cal->data = data;
+    return cal;
+}
 
-    // Add variables
-    InitVariables(data, tokens, formula);
-    return Eval();
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ReturnToPool return calculator to pool of current thread.
+ * @param cal calculator taken by TakeFromPool().
+ */
+void Calculator::ReturnToPool(Calculator *cal)
+{
+    SCASSERT(cal != nullptr);
+    calculatorPool.localData()->calculators.append(cal);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void Calculator::InitVariables(const VContainer *data, const QMap<int, QString> &tokens, const QString &formula)
+/**
+ * @brief Compile parse formula and cache its bytecode if all variables are bound to container.
+ * @param formula string of formula in internal look.
+ * @return names of variables that don't exist in container by position in formula (see GetTokens()).
+ */
+QMap<int, QString> Calculator::Compile(const QString &formula)
 {
-    if (qApp->patternType() == MeasurementsType::Standard)
     {
-        vVarVal = new qreal[2];
+        QMutexLocker locker(&cacheMutex);
+        if (formulaCache.contains(formula))
+        {
+            return QMap<int, QString>();// Only formulas without unbound variables are cached
+        }
     }
 
-    const QHash<QString, QSharedPointer<VInternalVariable> > *vars = data->DataVariables();
+    SetSepForEval();
+    ClearVar();
+    unbound.clear();
+    SetVarFactory(CompileVariable, this);
+    SetExpr(formula);
+    Eval();// Parser creates bytecode only when evaluates
+
+    if (unbound.isEmpty())
+    {
+        CacheFormula(formula);
+        return QMap<int, QString>();
+    }
 
-    QMap<int, QString>::const_iterator i = tokens.constBegin();
-    while (i != tokens.constEnd())
+    QMap<int, QString> positions;
+    const QMap<int, QString> tokens = GetTokens();
+    for (QMap<int, QString>::const_iterator it = tokens.constBegin(); it != tokens.constEnd(); ++it)
     {
-        bool found = false;
-        if (vars->contains(i.value()))
+        if (unbound.contains(it.value()))
         {
-            QSharedPointer<VInternalVariable> var = vars->value(i.value());
-            if ((qApp->patternType() == MeasurementsType::Standard) &&
-                (var->GetType() == VarType::Measurement || var->GetType() == VarType::Increment))
+            positions.insert(it.key(), it.value());
+        }
+    }
+    return positions;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Sensitivity differentiate formula by each graded variable.
+ *
+ * Bytecode of derivative is generated symbolically and evaluated instead of formula. If formula has function without
+ * derivative rule (min, max, if-then-else) parser's numerical derivative is used.
+ * @param formula string of formula in internal look.
+ * @return derivatives by handle of variable name.
+ */
+QMap<quint32, qreal> Calculator::Sensitivity(const QString &formula)
+{
+    SetSepForEval();
+    ClearVar();
+    SetVarFactory(BindVariable, this);
+    SetExpr(formula);
+    Eval();// Parser creates bytecode only when evaluates
+
+    const qmu::QmuParserByteCode byteCode = GetByteCode();
+    const int numResults = GetNumResults();
+
+    QMap<quint32, qreal> sensitivity;
+    const varmap_type vars = GetVar();
+    for (varmap_type::const_iterator it = vars.begin(); it != vars.end(); ++it)
+    {
+        const quint32 handle = VNameTable::Find(it->first);
+        if (IsGradedVariable(handle) == false)
+        {
+            continue;
+        }
+
+        qmu::QmuParserByteCode derivative;
+        if (Derive(it->second, derivative))
+        {
+            SetByteCode(derivative, 1);
+            sensitivity.insert(handle, Eval());
+            SetByteCode(byteCode, numResults);
+        }
+        else
+        {
+            sensitivity.insert(handle, Diff(it->second, *it->second));
+        }
+    }
+    return sensitivity;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Dual evaluate formula over dual numbers (forward mode of automatic differentiation).
+ *
+ * Size and height are independent variables. Measurements and increments depend on them linearly, so their seeds
+ * have constant gradient. If formula can't be evaluated over dual numbers gradient is sum of numerical derivatives by
+ * variables multiplied by their gradients.
+ * @param formula string of formula in internal look.
+ * @return value and gradient of formula.
+ */
+qmu::QmuDual Calculator::Dual(const QString &formula)
+{
+    SetSepForEval();
+    ClearVar();
+    SetVarFactory(BindVariable, this);
+    SetExpr(formula);
+    qmu::QmuDual result(Eval());// Parser creates bytecode only when evaluates
+
+    if (qApp->patternType() != MeasurementsType::Standard)
+    {
+        return result;
+    }
+
+    QHash<const qreal *, qmu::QmuDual> seeds;
+    const varmap_type vars = GetVar();
+    for (varmap_type::const_iterator it = vars.begin(); it != vars.end(); ++it)
+    {
+        const quint32 handle = VNameTable::Find(it->first);
+        if (handle == data->SizeHandle())
+        {
+            seeds.insert(it->second, qmu::QmuDual(*it->second, 1, 0));
+        }
+        else if (handle == data->HeightHandle())
+        {
+            seeds.insert(it->second, qmu::QmuDual(*it->second, 0, 1));
+        }
+        else if (IsGradedVariable(handle))
+        {
+            const VVariable *var = static_cast<const VVariable *>(data->FindVariable(handle));
+            seeds.insert(it->second, qmu::QmuDual(*it->second, var->SizeDerivative(), var->HeightDerivative()));
+        }
+    }
+
+    if (seeds.isEmpty() || QmuParser::EvalDual(seeds, result))
+    {
+        return result;
+    }
+
+    for (QHash<const qreal *, qmu::QmuDual>::const_iterator it = seeds.constBegin(); it != seeds.constEnd(); ++it)
+    {
+        qreal *value = const_cast<qreal *>(it.key());
+        const qreal diff = Diff(value, *value);
+        for (int k = 0; k < qmu::QmuDual::Dim; ++k)
+        {
+            result.Grad[k] += diff * it.value().Grad[k];
+        }
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Lanes evaluate formula for all lanes with bulk mode of parser.
+ *
+ * Bytecode is not cached, its variables point to arrays of lanes.
+ * @param formula string of formula in internal look.
+ * @param sizes size of each lane.
+ * @param heights height of each lane.
+ * @return value of formula for each lane or empty vector if formula uses variable that is not graded.
+ */
+QVector<qreal> Calculator::Lanes(const QString &formula, const QVector<qreal> &sizes, const QVector<qreal> &heights)
+{
+    SetSepForEval();
+    ClearVar();
+    laneSizes = sizes;
+    laneHeights = heights;
+    laneValues.clear();
+    lanesPure = true;
+    SetVarFactory(LaneVariable, this);
+    SetExpr(formula);
+
+    QVector<qreal> results(sizes.size());
+    Eval(results.data(), results.size());
+    if (lanesPure == false)
+    {
+        results.clear();
+    }
+    return results;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief EvalCompiled evaluate formula using bytecode from cache.
+ *
+ * Bytecode is bound to values of variables from current container. If formula was not compiled yet or one of variables
+ * doesn't exist anymore we return false and formula must be parsed from string. Native code of formula gets variable
+ * pointers directly and doesn't need bytecode at all, it is used whenever formula has it. Formula is compiled to native
+ * code when it was evaluated from cache jitThreshold times. Before that inside sweep formula is calculated by program of
+ * expression graph if it shares subexpressions of measurements with other formulas.
+ * @param formula string of formula in internal look.
+ * @param result value of formula.
+ * @return true if formula was evaluated.
+ */
+bool Calculator::EvalCompiled(const QString &formula, qreal &result)
+{
+    CompiledFormula compiled;
+    {
+        QMutexLocker locker(&cacheMutex);
+        CompiledFormula *cached = formulaCache.object(formula);
+        if (cached == nullptr)
+        {
+            ++cacheMisses;
+            return false;
+        }
+        if (++cached->hits == jitThreshold && qmu::QmuParserJit::IsSupported())
+        {
+            QSharedPointer<qmu::QmuParserJit> jit(new qmu::QmuParserJit());
+            if (jit->Compile(cached->byteCode, cached->numResults))
             {
-                QSharedPointer<VVariable> m = data->GetVariable<VVariable>(i.value());
-                m->SetValue(data->size(), data->height());
+                cached->jit = jit;
             }
-            DefineVar(i.value(), var->GetValue());
-            found = true;
         }
+        if (cached->jit.isNull() && cached->steps.isEmpty() == false
+                && cached->generation != VFormulaDag::Generation())
+        {// Other formulas could start to share nodes of this one
+            cached->generation = VFormulaDag::Generation();
+            cached->program = VFormulaDag::Shared(cached->steps);
+        }
+        compiled = *cached;
+    }
+
+    QVector<qreal *> values(compiled.varHandles.size());
+    for (int i = 0; i < compiled.varHandles.size(); ++i)
+    {
+        values[i] = FindVariable(compiled.varHandles.at(i));
+        if (values.at(i) == nullptr)
+        {
+            QMutexLocker locker(&cacheMutex);
+            ++cacheMisses;
+            return false;// Parsing from string will show error position
+        }
+    }
 
-        if (qApp->patternType() == MeasurementsType::Standard)
+    QVector<qreal *> ptrs(compiled.varSlots.size());
+    for (int i = 0; i < compiled.varSlots.size(); ++i)
+    {
+        ptrs[i] = values.at(compiled.varSlots.at(i));
+    }
+
+    bool shared = compiled.jit.isNull() && compiled.program.isEmpty() == false && VFormulaDag::IsSweep();
+    for (int i = 0; shared && i < compiled.pureSlots.size(); ++i)
+    {// Name could change type since formula was compiled
+        shared = IsGradedVariable(compiled.varHandles.at(compiled.pureSlots.at(i)));
+    }
+
+    if (compiled.jit.isNull() == false)
+    {
+        if (jitStack.size() < compiled.jit->GetStackSize())
         {
-            if (i.value() == data->SizeName())
+            jitStack.resize(compiled.jit->GetStackSize());
+        }
+        result = compiled.jit->Eval(jitStack.data(), ptrs.constData());
+    }
+    else if (shared)
+    {
+        result = VFormulaDag::Eval(compiled.program, ptrs.constData(), dagValues);
+    }
+    else
+    {
+        compiled.byteCode.SetVarPtrs(ptrs);
+
+        SetByteCode(compiled.byteCode, compiled.numResults);
+        result = Eval();
+    }
+
+    QMutexLocker locker(&cacheMutex);
+    ++cacheHits;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CacheFormula save bytecode of last evaluated formula to the cache.
+ *
+ * Each variable pointer in bytecode must belong to only one variable name, otherwise we can't bind it back later.
+ * @param formula string of formula in internal look.
+ */
+void Calculator::CacheFormula(const QString &formula) const
+{
+    CompiledFormula *compiled = new CompiledFormula();
+    compiled->byteCode = GetByteCode();
+    compiled->numResults = GetNumResults();
+
+    const varmap_type &vars = GetVar();
+    const QVector<qreal *> ptrs = compiled->byteCode.GetVarPtrs();
+    for (int i = 0; i < ptrs.size(); ++i)
+    {
+        QString name;
+        int count = 0;
+        for (varmap_type::const_iterator it = vars.begin(); it != vars.end(); ++it)
+        {
+            if (it->second == ptrs.at(i))
             {
-                vVarVal[0] = data->size();
-                DefineVar(data->SizeName(), &vVarVal[0]);
-                found = true;
+                name = it->first;
+                ++count;
             }
+        }
+
+        if (count != 1)
+        {
+            delete compiled;
+            return;
+        }
 
-            if (i.value() == data->HeightName())
+        const quint32 handle = VNameTable::Handle(name);
+        int slot = compiled->varHandles.indexOf(handle);
+        if (slot == -1)
+        {
+            compiled->varHandles.append(handle);
+            slot = compiled->varHandles.size() - 1;
+        }
+        compiled->varSlots.append(slot);
+    }
+
+    QVector<quint32> handles(compiled->varSlots.size());
+    QVector<bool> pure(compiled->varSlots.size());
+    for (int i = 0; i < compiled->varSlots.size(); ++i)
+    {
+        handles[i] = compiled->varHandles.at(compiled->varSlots.at(i));
+        pure[i] = IsGradedVariable(handles.at(i));
+        if (pure.at(i) && compiled->pureSlots.contains(compiled->varSlots.at(i)) == false)
+        {
+            compiled->pureSlots.append(compiled->varSlots.at(i));
+        }
+    }
+    compiled->steps = VFormulaDag::Lower(compiled->byteCode, handles, pure);
+
+    QMutexLocker locker(&cacheMutex);
+    formulaCache.insert(formula, compiled);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief FindVariable return pointer to value of variable.
+ * @param handle handle of name of variable, increment, measurement, length of curve or size and height.
+ * @return pointer to value or nullptr if variable doesn't exist.
+ */
+qreal *Calculator::FindVariable(const quint32 &handle)
+{
+    qreal *value = nullptr;
+    const bool standard = (qApp->patternType() == MeasurementsType::Standard);
+
+    VInternalVariable *var = data->FindVariable(handle);
+    if (var != nullptr)
+    {
+        if (standard && (var->GetType() == VarType::Measurement || var->GetType() == VarType::Increment))
+        {
+            if (VContainer::IsThreadGradation() || QThread::currentThread() != qApp->thread())
+            {
+                // Variable is shared with other threads, keep value here. Map doesn't move values on insert.
+                value = &gradedValues[handle];
+                *value = static_cast<VVariable *>(var)->GradedValue(data->size(), data->height());
+            }
+            else
             {
-                vVarVal[1] = data->height();
-                DefineVar(data->HeightName(), &vVarVal[1]);
-                found = true;
+                static_cast<VVariable *>(var)->SetValue(data->size(), data->height());
+                value = var->GetValue();
             }
         }
+        else
+        {
+            value = var->GetValue();
+        }
+    }
 
-        if (builInFunctions.contains(i.value()))
-        {// We found built-in function
-            found = true;
+    if (standard)
+    {
+        if (handle == data->SizeHandle())
+        {
+            vVarVal[0] = data->size();
+            value = &vVarVal[0];
         }
 
-        if (found == false)
+        if (handle == data->HeightHandle())
         {
-            throw qmu::QmuParserError (ecUNASSIGNABLE_TOKEN, i.value(), formula, i.key());
+            vVarVal[1] = data->height();
+            value = &vVarVal[1];
         }
-        ++i;
     }
+
+    return value;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IsGradedVariable check if value of variable depends only on size and height.
+ *
+ * Such variables don't change while pattern piece is parsed.
+ * @param handle handle of name of variable.
+ * @return true for measurement, increment, size and height.
+ */
+bool Calculator::IsGradedVariable(const quint32 &handle) const
+{
+    if (handle == data->SizeHandle() || handle == data->HeightHandle())
+    {
+        return true;
+    }
+
+    const VInternalVariable *var = data->FindVariable(handle);
+    return var != nullptr && (var->GetType() == VarType::Measurement || var->GetType() == VarType::Increment);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -187,7 +810,8 @@ void Calculator::InitCharacterSets()
     //String with all unique symbols for supported alpabets.
     // See script alphabets.py for generation and more information.
     //Note. MSVC doen't support normal string concatenation for long string. Thats why we use QStringList in this place.
-    QStringList symbols = QStringList() << "ցЀĆЈVӧĎАғΕĖӅИқΝĞơРңњΥĦШҫ̆جگĮаҳѕεشԶиһνԾрυلՆӝшËՎҔPÓՖXӛӟŞӣզhëծpóӞնxßվāŁЃֆĉЋ"
+    //Strings are built once, all calculators share them.
+    static const QStringList symbols = QStringList() << "ցЀĆЈVӧĎАғΕĖӅИқΝĞơРңњΥĦШҫ̆جگĮаҳѕεشԶиһνԾрυلՆӝшËՎҔPÓՖXӛӟŞӣզhëծpóӞնxßվāŁЃֆĉЋ"
                                         << "CŬđҐГΒęҘЛΚŘġҠУGاհЫدԱҰгβطԹõлκKՁÀуςهՉÈыvیՑÐSOřӘћաőcӐթèkàѓżűðsķչøӥӔĀփїІĈЎ"
                                         << "ґĐΗЖҙĘȚΟОҡĠآΧЦتЮұİزηжԸغοоÁՀقχцÉՈيюÑՐђӋіәťӆўáŠĺѐfөըnñŰӤӨӹոľЁրăЉŭċБӸēłΔҖ"
                                         << "ЙŤěΜӜDСձģΤӰЩīņحҮбưԳصδHйԻŇμӲӴсՃمτƠщՋєLQŹՓŕÖYśÞaգĽæiŽիӓîqճöyջþĂօЄӦĊЌΑĒДҗј"
@@ -196,9 +820,14 @@ void Calculator::InitCharacterSets()
                                         << "ЪƯخγвŅԴŪضλкԼĴσтÅՄنъÍՌRӕՔZÝŜbåդﻩjíլļrӵմzýռپêЅքćچЍďӱҒЕůėژșΘØҚНğńءΠFҢХħΨҪ"
                                         << "ЭųįҶرҲеԷňعθҺнԿفπÂхՇψÊэšՏÒUəÚѝŻşҤӑâeէŐımկòuշÕúտŔ";
 
-    // Defining identifier character sets
-    DefineNameChars(QStringLiteral("0123456789_") + symbols.join(""));
-    DefineOprtChars(symbols.join("") + QStringLiteral("+-*^/?<>=#!$%&|~_"));
+    static const QString nameChars = QStringLiteral("0123456789_") + symbols.join("");
+    static const QString oprtChars = symbols.join("") + QStringLiteral("+-*^/?<>=#!$%&|~_");
+
+    // Defining identifier character sets. Symbols of alphabets are checked by lookup table generated by the same script
+    // (alphabets.py --table), so only other characters are added here.
+    DefineNameChars(nameChars, qmu::QmuParserCharSet(QStringLiteral("0123456789_"), alphabetIndex, alphabetBlocks));
+    DefineOprtChars(oprtChars, qmu::QmuParserCharSet(QStringLiteral("+-*^/?<>=#!$%&|~_"), alphabetIndex,
+                                                     alphabetBlocks));
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -207,10 +836,103 @@ void Calculator::InitCharacterSets()
 qreal* Calculator::AddVariable(const QString &a_szName, void *a_pUserData)
 {
     Q_UNUSED(a_szName)
-    Q_UNUSED(a_pUserData)
+    Calculator *cal = static_cast<Calculator *>(a_pUserData);
+    SCASSERT(cal != nullptr);
 
-    static qreal value = 0;
-    return &value;
+    return &cal->unboundValue;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief BindVariable factory function for binding parser variables to values from container.
+ *
+ * Parser calls it for each unknown name while it creates bytecode.
+ * @param a_szName name of variable.
+ * @param a_pUserData pointer to calculator.
+ * @return pointer to value of variable or nullptr if variable doesn't exist.
+ */
+qreal *Calculator::BindVariable(const QString &a_szName, void *a_pUserData)
+{
+    Calculator *cal = static_cast<Calculator *>(a_pUserData);
+    SCASSERT(cal != nullptr);
+
+    qreal *value = cal->FindVariable(VNameTable::Find(a_szName));
+    if (value == nullptr && builInFunctions.contains(a_szName))
+    {// Name of built-in function without brackets
+        return AddVariable(a_szName, a_pUserData);
+    }
+    return value;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CompileVariable factory function for checking formula before tools create their variables.
+ *
+ * Variables from container are bound like in BindVariable(), other names get fake value.
+ * @param a_szName name of variable.
+ * @param a_pUserData pointer to calculator.
+ * @return pointer to value of variable.
+ */
+qreal *Calculator::CompileVariable(const QString &a_szName, void *a_pUserData)
+{
+    qreal *value = BindVariable(a_szName, a_pUserData);
+    if (value == nullptr)
+    {
+        Calculator *cal = static_cast<Calculator *>(a_pUserData);
+        if (cal->unbound.contains(a_szName) == false)
+        {
+            cal->unbound.append(a_szName);
+        }
+        return AddVariable(a_szName, a_pUserData);
+    }
+    return value;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief LaneVariable factory function for binding parser variables to arrays of lanes.
+ *
+ * Size and height get their values, measurements and increments get graded values of each lane. Other names get zeros
+ * and mark formula as not pure.
+ * @param a_szName name of variable.
+ * @param a_pUserData pointer to calculator.
+ * @return pointer to values of variable for all lanes.
+ */
+qreal *Calculator::LaneVariable(const QString &a_szName, void *a_pUserData)
+{
+    Calculator *cal = static_cast<Calculator *>(a_pUserData);
+    SCASSERT(cal != nullptr);
+
+    const quint32 handle = VNameTable::Find(a_szName);
+    if (cal->laneValues.contains(handle))
+    {// Unknown names share one array, it can't be replaced while parser uses it
+        return cal->laneValues[handle].data();
+    }
+
+    QVector<qreal> values(cal->laneSizes.size(), 0);
+    if (handle == cal->data->SizeHandle())
+    {
+        values = cal->laneSizes;
+    }
+    else if (handle == cal->data->HeightHandle())
+    {
+        values = cal->laneHeights;
+    }
+    else if (cal->IsGradedVariable(handle))
+    {
+        const VVariable *var = static_cast<const VVariable *>(cal->data->FindVariable(handle));
+        for (int i = 0; i < values.size(); ++i)
+        {
+            values[i] = var->GradedValue(cal->laneSizes.at(i), cal->laneHeights.at(i));
+        }
+    }
+    else
+    {
+        cal->lanesPure = false;
+    }
+
+    cal->laneValues.insert(handle, values);
+    return cal->laneValues[handle].data();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -247,16 +969,3 @@ void Calculator::SetSepForTr(bool fromUser)
         SetDecSep('.');
     }
 }
-
-//---------------------------------------------------------------------------------------------------------------------
-void Calculator::RemoveAll(QMap<int, QString> &map, const QString &val)
-{
-    QList<int> listKeys = map.keys(val);
-    if (listKeys.size() > 0)
-    {
-        for (int i = 0; i < listKeys.size(); ++i)
-        {
-            map.remove(listKeys.at(i));
-        }
-    }
-}
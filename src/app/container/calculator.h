@@ -30,6 +30,13 @@
 #define CALCULATOR_H
 
 #include "../../libs/qmuparser/qmuparser.h"
+#include "vformuladag.h"
+#include <QCache>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
 
 class VContainer;
 
@@ -38,6 +45,8 @@ class VContainer;
  *
  * Main purpose make easy evaluate value of formula and get tokens.
  * Note. If created to many parser for different purpes in the same time parser can work wrong.
+ * For evaluation use static method EvalFormula(data, formula). It takes calculator from pool of current thread, so
+ * parser, his callbacks and character sets are created only once per thread.
  * Example:
  * DialogEditWrongFormula *dialog = new DialogEditWrongFormula(data);
  * dialog->setFormula(formula);
@@ -47,9 +56,7 @@ class VContainer;
  *     //Need delete dialog here because parser in dialog don't allow use correct separator for parsing here.
  *     //Don't know why.
  *     delete dialog;
- *     Calculator *cal = new Calculator(data);
- *     result = cal->EvalFormula(formula);
- *     delete cal;//Here can be memory leak, but dialog already check this formula and probability very low.
+ *     result = Calculator::EvalFormula(data, formula);
  * }
  */
 class Calculator:public qmu::QmuParser
@@ -59,16 +66,103 @@ public:
     Calculator(const QString &formula, bool fromUser = true);
     ~Calculator();
     qreal         EvalFormula(const QString &formula);
+    static qreal  EvalFormula(const VContainer *data, const QString &formula);
+    static QMap<int, QString> CompileFormula(const VContainer *data, const QString &formula);
+    static QMap<quint32, qreal> EvalSensitivity(const VContainer *data, const QString &formula);
+    static qmu::QmuDual EvalDual(const VContainer *data, const QString &formula);
+    static QVector<qreal> EvalLanes(const VContainer *data, const QString &formula, const QVector<qreal> &sizes,
+                                    const QVector<qreal> &heights);
+    static void   SetThreadLane(const QHash<QString, QVector<qreal> > *values, int lane);
+    static void   ClearThreadLane();
+
+    static qint64 FormulaCacheHits();
+    static qint64 FormulaCacheMisses();
+    static void   ClearFormulaCache();
 private:
     Q_DISABLE_COPY(Calculator)
     qreal *vVarVal;
     const VContainer *data;
-    void          InitVariables(const VContainer *data, const QMap<int, QString> &tokens, const QString &formula);
+
+    /** @brief jitStack stack buffer for native code of formulas. */
+    QVector<qreal> jitStack;
+
+    /** @brief dagValues values of steps for formula program of expression graph. */
+    QVector<qreal> dagValues;
+
+    /** @brief gradedValues values of measurements and increments for threads other than GUI thread. */
+    QMap<quint32, qreal> gradedValues;
+
+    /** @brief unbound names of variables of last compiled formula that don't exist in container yet. */
+    QStringList   unbound;
+
+    /** @brief unboundValue fake value of all variables that don't exist in container. */
+    qreal         unboundValue;
+
+    /** @brief laneSizes sizes of lanes for bulk evaluation. */
+    QVector<qreal> laneSizes;
+
+    /** @brief laneHeights heights of lanes for bulk evaluation. */
+    QVector<qreal> laneHeights;
+
+    /** @brief laneValues values of variables for each lane by handle of name, parser reads them with lane offset. */
+    QMap<quint32, QVector<qreal> > laneValues;
+
+    /** @brief lanesPure false if formula of bulk evaluation uses variable that depends on geometry of lane. */
+    bool          lanesPure;
+
+    /**
+     * @brief The CompiledFormula struct keep finalized bytecode of formula.
+     *
+     * Variables are stored by handle of name (see VNameTable) because pointers to values are valid only for container
+     * that was used for compilation. varSlots maps every variable reference of bytecode (in GetVarPtrs() order) to
+     * index in varHandles. Native code of formula doesn't depend on variable pointers, so it is compiled once and
+     * shared by all threads. Formula gets native code only after jitThreshold evaluations from cache, compilation
+     * doesn't pay off for formulas evaluated a few times. It is null before that or if formula can't be compiled.
+     * Steps are program of formula in expression graph (see VFormulaDag), program was lowered for variables from
+     * pureSlots being measurements, increments, size or height. Program keeps only memo checks of nodes that other
+     * formulas share, it is pruned again when generation of graph changes.
+     */
+    struct CompiledFormula
+    {
+        CompiledFormula()
+            : byteCode(), numResults(0), varHandles(), varSlots(), jit(), hits(0), steps(), pureSlots(), program(),
+              generation(-1) {}
+        qmu::QmuParserByteCode byteCode;
+        int                    numResults;
+        QVector<quint32>       varHandles;
+        QVector<int>           varSlots;
+        QSharedPointer<qmu::QmuParserJit> jit;
+        int                    hits;
+        QVector<VFormulaStep>  steps;
+        QVector<int>           pureSlots;
+        QVector<VFormulaStep>  program;
+        int                    generation;
+    };
+
+    static const int jitThreshold;
+
+    static QCache<QString, CompiledFormula> formulaCache;
+    static QMutex cacheMutex;
+    static qint64 cacheHits;
+    static qint64 cacheMisses;
+
+    static Calculator *TakeFromPool(const VContainer *data);
+    static void   ReturnToPool(Calculator *cal);
+    QMap<int, QString> Compile(const QString &formula);
+    QMap<quint32, qreal> Sensitivity(const QString &formula);
+    qmu::QmuDual  Dual(const QString &formula);
+    QVector<qreal> Lanes(const QString &formula, const QVector<qreal> &sizes, const QVector<qreal> &heights);
+    bool          EvalCompiled(const QString &formula, qreal &result);
+    void          CacheFormula(const QString &formula) const;
+    qreal*        FindVariable(const quint32 &handle);
+    bool          IsGradedVariable(const quint32 &handle) const;
     void          InitCharacterSets();
     static qreal* AddVariable(const QString &a_szName, void *a_pUserData);
+    static qreal* BindVariable(const QString &a_szName, void *a_pUserData);
+    static qreal* CompileVariable(const QString &a_szName, void *a_pUserData);
+    static qreal* LaneVariable(const QString &a_szName, void *a_pUserData);
     void          SetSepForEval();
     void          SetSepForTr(bool fromUser);
-    void          RemoveAll(QMap<int, QString> &map, const QString &val);
 };
 
 #endif // CALCULATOR_H
@@ -10,7 +10,9 @@ SOURCES += \
     container/vcurvelength.cpp \
     container/vlinelength.cpp \
     container/vsplinelength.cpp \
-    container/vformula.cpp
+    container/vformula.cpp \
+    container/vnametable.cpp \
+    container/vformuladag.cpp
  
 HEADERS += \
     container/vcontainer.h \
@@ -32,4 +34,8 @@ HEADERS += \
     container/vlineangle_p.h \
     container/vlinelength_p.h \
     container/vmeasurement_p.h \
-    container/vformula.h
+    container/vformula.h \
+    container/vversionedhash.h \
+    container/vnametable.h \
+    container/vformuladag.h \
+    container/alphabets.h
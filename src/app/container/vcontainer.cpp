@@ -32,12 +32,53 @@
 #include "../geometry/varc.h"
 #include "../geometry/vsplinepath.h"
 #include <QLineF>
+#include <QThreadStorage>
 #include <QtAlgorithms>
 
 quint32 VContainer::_id = NULL_ID;
 qreal VContainer::_size = 50;
 qreal VContainer::_height = 176;
-QSet<const QString> VContainer::uniqueNames = QSet<const QString>();
+QSet<quint32> VContainer::uniqueNames = QSet<quint32>();
+QMutex VContainer::uniqueNamesMutex;
+
+/**
+ * @brief The VGradation struct keeps size and height of pattern that is graded on current thread.
+ */
+struct VGradation
+{
+    VGradation(qreal size, qreal height) : size(size), height(height) {}
+    qreal size;
+    qreal height;
+};
+
+static QThreadStorage<VGradation *> threadGradation;
+
+/**
+ * @brief The VThreadScope struct keeps id counter and unique names of pattern that is recalculated on current thread.
+ */
+struct VThreadScope
+{
+    VThreadScope() : id(NULL_ID), uniqueNames() {}
+    VThreadScope(quint32 id, const QSet<quint32> &uniqueNames) : id(id), uniqueNames(uniqueNames) {}
+    quint32       id;
+    QSet<quint32> uniqueNames;
+};
+
+/**
+ * @brief threadScopes stack of scopes of current thread. Pattern piece can be recalculated on the same thread as
+ * pattern it belongs to, so scopes can be nested.
+ */
+static QThreadStorage<QVector<VThreadScope> > threadScopes;
+
+//---------------------------------------------------------------------------------------------------------------------
+static VThreadScope *CurrentScope()
+{
+    if (threadScopes.hasLocalData() == false || threadScopes.localData().isEmpty())
+    {
+        return nullptr;
+    }
+    return &threadScopes.localData().last();
+}
 
 //---------------------------------------------------------------------------------------------------------------------
 /**
@@ -74,10 +115,7 @@ VContainer::VContainer(const VContainer &data)
 
 //---------------------------------------------------------------------------------------------------------------------
 VContainer::~VContainer()
-{
-    ClearGObjects();
-    ClearVariables();
-}
+{}
 
 //---------------------------------------------------------------------------------------------------------------------
 /**
@@ -99,16 +137,14 @@ const QSharedPointer<VGObject> VContainer::GetGObject(quint32 id)const
  * @return Object
  */
 template <typename key, typename val>
-const val VContainer::GetObject(const QHash<key, val> &obj, key id) const
+const val VContainer::GetObject(const VVersionedHash<key, val> &obj, key id) const
 {
-    if (obj.contains(id))
-    {
-        return obj.value(id);
-    }
-    else
+    const val value = obj.value(id);
+    if (value.isNull())
     {
         throw VExceptionBadId(tr("Can't find object"), id);
     }
+    return value;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -139,7 +175,7 @@ quint32 VContainer::AddGObject(VGObject *obj)
 {
     SCASSERT(obj != nullptr);
     QSharedPointer<VGObject> pointer(obj);
-    uniqueNames.insert(obj->name());
+    AddUniqueName(VNameTable::Handle(obj->name()));
     return AddObject(d->gObjects, pointer);
 }
 
@@ -156,6 +192,16 @@ quint32 VContainer::AddDetail(VDetail detail)
     return id;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief getId return current id. Inside thread scope returns id of scope.
+ */
+quint32 VContainer::getId()
+{
+    const VThreadScope *scope = CurrentScope();
+    return scope != nullptr ? scope->id : _id;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief getNextId generate next unique id
@@ -163,8 +209,10 @@ quint32 VContainer::AddDetail(VDetail detail)
  */
 quint32 VContainer::getNextId()
 {
-    _id++;
-    return _id;
+    VThreadScope *scope = CurrentScope();
+    quint32 &id = scope != nullptr ? scope->id : _id;
+    id++;
+    return id;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -174,9 +222,11 @@ quint32 VContainer::getNextId()
  */
 void VContainer::UpdateId(quint32 newId)
 {
-    if (newId > _id)
+    VThreadScope *scope = CurrentScope();
+    quint32 &id = scope != nullptr ? scope->id : _id;
+    if (newId > id)
     {
-       _id = newId;
+       id = newId;
     }
 }
 
@@ -188,16 +238,12 @@ void VContainer::UpdateId(quint32 newId)
  * @param point object
  */
 template <typename val>
-void VContainer::UpdateObject(QHash<quint32, val> &obj, const quint32 &id, val point)
+void VContainer::UpdateObject(VVersionedHash<quint32, val> &obj, const quint32 &id, val point)
 {
     Q_ASSERT_X(id > NULL_ID, Q_FUNC_INFO, "id = 0");
     SCASSERT(point.isNull() == false);
     point->setId(id);
-    if (d->gObjects.contains(id))
-    {
-        d->gObjects[id].clear();
-    }
-    obj[id] = point;
+    obj.insert(id, point);
     UpdateId(id);
 }
 
@@ -207,7 +253,15 @@ void VContainer::UpdateObject(QHash<quint32, val> &obj, const quint32 &id, val p
  */
 void VContainer::Clear()
 {
-    _id = NULL_ID;
+    VThreadScope *scope = CurrentScope();
+    if (scope != nullptr)
+    {
+        scope->id = NULL_ID;
+    }
+    else
+    {
+        _id = NULL_ID;
+    }
 
     d->details.clear();
     ClearVariables();
@@ -221,11 +275,6 @@ void VContainer::Clear()
  */
 void VContainer::ClearGObjects()
 {
-    QHash<quint32, QSharedPointer<VGObject> >::iterator i;
-    for (i = d->gObjects.begin(); i != d->gObjects.end(); ++i)
-    {
-        i.value().clear();
-    }
     d->gObjects.clear();
 }
 
@@ -235,21 +284,18 @@ void VContainer::ClearCalculationGObjects()
     if (d->gObjects.size()>0)
     {
         QVector<quint32> keys;
-        QHash<quint32, QSharedPointer<VGObject> >::iterator i;
-        for (i = d->gObjects.begin(); i != d->gObjects.end(); ++i)
+        const VVersionedHash<quint32, QSharedPointer<VGObject> > &gObjects = d.constData()->gObjects;
+        VVersionedHash<quint32, QSharedPointer<VGObject> >::const_iterator i;
+        for (i = gObjects.constBegin(); i != gObjects.constEnd(); ++i)
         {
             if (i.value()->getMode() == Draw::Calculation)
             {
-                i.value().clear();
                 keys.append(i.key());
             }
         }
-        if (keys.size()>0)
+        for (int i = 0; i < keys.size(); ++i)
         {
-            for (int i = 0; i < keys.size(); ++i)
-            {
-                d->gObjects.remove(keys.at(i));
-            }
+            d->gObjects.remove(keys.at(i));
         }
     }
 }
@@ -261,31 +307,23 @@ void VContainer::ClearVariables(const VarType &type)
     {
         if (type == VarType::Unknown)
         {
-            QHash<QString, QSharedPointer<VInternalVariable> >::iterator i;
-            for (i = d->variables.begin(); i != d->variables.end(); ++i)
-            {
-                i.value().clear();
-            }
             d->variables.clear();
         }
         else
         {
-            QVector<QString> keys;
-            QHash<QString, QSharedPointer<VInternalVariable> >::iterator i;
-            for (i = d->variables.begin(); i != d->variables.end(); ++i)
+            QVector<quint32> keys;
+            const VVersionedHash<quint32, QSharedPointer<VInternalVariable> > &variables = d.constData()->variables;
+            VVersionedHash<quint32, QSharedPointer<VInternalVariable> >::const_iterator i;
+            for (i = variables.constBegin(); i != variables.constEnd(); ++i)
             {
                 if (i.value()->GetType() == type)
                 {
-                    i.value().clear();
                     keys.append(i.key());
                 }
             }
-            if (keys.size()>0)
+            for (int i = 0; i < keys.size(); ++i)
             {
-                for (int i = 0; i < keys.size(); ++i)
-                {
-                    d->variables.remove(keys.at(i));
-                }
+                d->variables.remove(keys.at(i));
             }
         }
     }
@@ -299,13 +337,13 @@ void VContainer::ClearVariables(const VarType &type)
  */
 void VContainer::AddLine(const quint32 &firstPointId, const quint32 &secondPointId)
 {
-    const QSharedPointer<VPointF> first = GeometricObject<VPointF>(firstPointId);
-    const QSharedPointer<VPointF> second = GeometricObject<VPointF>(secondPointId);
+    const VPointF *first = &GeometricObjectRef<VPointF>(firstPointId);
+    const VPointF *second = &GeometricObjectRef<VPointF>(secondPointId);
 
-    VLengthLine *length = new VLengthLine(first.data(), firstPointId, second.data(), secondPointId);
+    VLengthLine *length = new VLengthLine(first, firstPointId, second, secondPointId);
     AddVariable(length->GetName(), length);
 
-    VLineAngle *angle = new VLineAngle(first.data(), firstPointId, second.data(), secondPointId);
+    VLineAngle *angle = new VLineAngle(first, firstPointId, second, secondPointId);
     AddVariable(angle->GetName(), angle);
 }
 
@@ -317,12 +355,12 @@ void VContainer::AddLine(const quint32 &firstPointId, const quint32 &secondPoint
  * @return id of object in container
  */
 template <typename key, typename val>
-quint32 VContainer::AddObject(QHash<key, val> &obj, val value)
+quint32 VContainer::AddObject(VVersionedHash<key, val> &obj, val value)
 {
     SCASSERT(value != nullptr);
     quint32 id = getNextId();
     value->setId(id);
-    obj[id] = value;
+    obj.insert(id, value);
     return id;
 }
 
@@ -337,7 +375,7 @@ void VContainer::UpdateGObject(quint32 id, VGObject* obj)
     SCASSERT(obj != nullptr);
     QSharedPointer<VGObject> pointer(obj);
     UpdateObject(d->gObjects, id, pointer);
-    uniqueNames.insert(obj->name());
+    AddUniqueName(VNameTable::Handle(obj->name()));
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -353,6 +391,121 @@ void VContainer::UpdateDetail(quint32 id, const VDetail &detail)
     UpdateId(id);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief UpdateFromContainer replace objects and variables by their versions from other container. Container gets only
+ * new versions of objects and variables it already has.
+ * @param source container with new versions.
+ * @param ids ids of changed objects.
+ * @param handles handles of names of changed variables.
+ */
+void VContainer::UpdateFromContainer(const VContainer &source, const QSet<quint32> &ids, const QSet<quint32> &handles)
+{
+    QSet<quint32>::const_iterator i = ids.constBegin();
+    while (i != ids.constEnd())
+    {
+        if (d.constData()->gObjects.contains(*i) && source.d->gObjects.contains(*i))
+        {
+            d->gObjects.insert(*i, source.d->gObjects.value(*i));
+        }
+        ++i;
+    }
+
+    QSet<quint32>::const_iterator j = handles.constBegin();
+    while (j != handles.constEnd())
+    {
+        if (d.constData()->variables.contains(*j) && source.d->variables.contains(*j))
+        {
+            d->variables.insert(*j, source.d->variables.value(*j));
+        }
+        ++j;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief MergeChanges apply objects and variables that other container changed, added or removed since base version.
+ *
+ * Both containers must be versions of base. Objects and variables that stayed the same share pointers with base, so
+ * comparing pointers is enough.
+ * @param base version both containers were made from.
+ * @param changed container with changes.
+ */
+void VContainer::MergeChanges(const VContainer &base, const VContainer &changed)
+{
+    d->gObjects.Merge(base.d->gObjects, changed.d->gObjects);
+    d->variables.Merge(base.d->variables, changed.d->variables);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ChangesSince find objects and variables that container changed since base version.
+ *
+ * Container must be version of base. Subtries shared with base are skipped, so cost depends on count of changes.
+ * @param base version container was made from.
+ * @param ids ids of changed objects.
+ * @param handles handles of names of changed variables.
+ * @return false if container added or removed objects or variables or some object got other name.
+ */
+bool VContainer::ChangesSince(const VContainer &base, QSet<quint32> &ids, QSet<quint32> &handles) const
+{
+    QVector<QPair<quint32, QSharedPointer<VGObject> > > objects;
+    QVector<quint32> removed;
+    d->gObjects.Changes(base.d->gObjects, objects, removed);
+    if (removed.isEmpty() == false)
+    {
+        return false;
+    }
+    for (int i = 0; i < objects.size(); ++i)
+    {
+        const QSharedPointer<VGObject> *oldObject = base.d->gObjects.Find(objects.at(i).first);
+        if (oldObject == nullptr || (*oldObject)->name() != objects.at(i).second->name())
+        {
+            return false;
+        }
+        ids.insert(objects.at(i).first);
+    }
+
+    QVector<QPair<quint32, QSharedPointer<VInternalVariable> > > variables;
+    d->variables.Changes(base.d->variables, variables, removed);
+    if (removed.isEmpty() == false)
+    {
+        return false;
+    }
+    for (int i = 0; i < variables.size(); ++i)
+    {
+        if (base.d->variables.contains(variables.at(i).first) == false)
+        {
+            return false;
+        }
+        handles.insert(variables.at(i).first);
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief NewGObjects find objects that container added since base version.
+ * @param base version container was made from.
+ * @return ids of objects that base doesn't have.
+ */
+QVector<quint32> VContainer::NewGObjects(const VContainer &base) const
+{
+    QVector<QPair<quint32, QSharedPointer<VGObject> > > objects;
+    QVector<quint32> removed;
+    d->gObjects.Changes(base.d->gObjects, objects, removed);
+
+    QVector<quint32> ids;
+    for (int i = 0; i < objects.size(); ++i)
+    {
+        if (base.d->gObjects.contains(objects.at(i).first) == false)
+        {
+            ids.append(objects.at(i).first);
+        }
+    }
+    return ids;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 qreal VContainer::GetTableValue(const QString &name) const
 {
@@ -371,8 +524,11 @@ qreal VContainer::GetTableValue(const QString &name) const
  */
 void VContainer::RemoveIncrement(const QString &name)
 {
-    d->variables[name].clear();
-    d->variables.remove(name);
+    const quint32 handle = VNameTable::Find(name);
+    if (d.constData()->variables.contains(handle))
+    {
+        d->variables.remove(handle);
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -414,7 +570,39 @@ const QMap<QString, QSharedPointer<VLineAngle> > VContainer::DataAngleLines() co
 //---------------------------------------------------------------------------------------------------------------------
 bool VContainer::IsUnique(const QString &name)
 {
-    return (!uniqueNames.contains(name) && !builInFunctions.contains(name));
+    const quint32 handle = VNameTable::Find(name);
+    if (handle == 0)
+    {
+        return !builInFunctions.contains(name);
+    }
+
+    const VThreadScope *scope = CurrentScope();
+    if (scope != nullptr)
+    {
+        return !scope->uniqueNames.contains(handle) && !builInFunctions.contains(name);
+    }
+
+    QMutexLocker locker(&uniqueNamesMutex);
+    return !uniqueNames.contains(handle) && !builInFunctions.contains(name);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief AddUniqueName remember name of object or variable. Inside thread scope name goes to scope, otherwise access
+ * to names is locked.
+ * @param handle handle of name.
+ */
+void VContainer::AddUniqueName(const quint32 &handle)
+{
+    VThreadScope *scope = CurrentScope();
+    if (scope != nullptr)
+    {
+        scope->uniqueNames.insert(handle);
+        return;
+    }
+
+    QMutexLocker locker(&uniqueNamesMutex);
+    uniqueNames.insert(handle);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -423,9 +611,26 @@ bool VContainer::IsUnique(const QString &name)
  * @param name name of row
  * @return true if contains
  */
-bool VContainer::VariableExist(const QString &name)
+bool VContainer::VariableExist(const QString &name) const
 {
-    return d->variables.contains(name);
+    return d->variables.contains(VNameTable::Find(name));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief FindVariable find variable by handle of name. Doesn't hash name and doesn't copy pointer, use it when need
+ * only value of variable.
+ * @param handle handle of variable's name.
+ * @return variable or nullptr if container doesn't have variable.
+ */
+VInternalVariable *VContainer::FindVariable(const quint32 &handle) const
+{
+    const QSharedPointer<VInternalVariable> *variable = d->variables.Find(handle);
+    if (variable == nullptr)
+    {
+        return nullptr;
+    }
+    return variable->data();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -434,13 +639,14 @@ const QMap<QString, QSharedPointer<T> > VContainer::DataVar(const VarType &type)
 {
     QMap<QString, QSharedPointer<T> > map;
     //Sorting QHash by id
-    QHash<QString, QSharedPointer<VInternalVariable> >::const_iterator i;
-    for (i = d->variables.constBegin(); i != d->variables.constEnd(); ++i)
+    const VVersionedHash<quint32, QSharedPointer<VInternalVariable> > &variables = d->variables;
+    VVersionedHash<quint32, QSharedPointer<VInternalVariable> >::const_iterator i;
+    for (i = variables.constBegin(); i != variables.constEnd(); ++i)
     {
         if (i.value()->GetType() == type)
         {
-            QSharedPointer<T> var = GetVariable<T>(i.key());
-            map.insert(qApp->VarToUser(i.key()), var);
+            QSharedPointer<T> var = qSharedPointerDynamicCast<T>(i.value());
+            map.insert(qApp->VarToUser(VNameTable::Name(i.key())), var);
         }
     }
     return map;
@@ -455,9 +661,52 @@ void VContainer::ClearDetails()
 //---------------------------------------------------------------------------------------------------------------------
 void VContainer::ClearUniqueNames()
 {
+    VThreadScope *scope = CurrentScope();
+    if (scope != nullptr)
+    {
+        scope->uniqueNames.clear();
+        return;
+    }
+
+    QMutexLocker locker(&uniqueNamesMutex);
     uniqueNames.clear();
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief UniqueNames return handles of names of all objects and variables. Inside thread scope returns names of scope.
+ */
+QSet<quint32> VContainer::UniqueNames()
+{
+    const VThreadScope *scope = CurrentScope();
+    if (scope != nullptr)
+    {
+        return scope->uniqueNames;
+    }
+
+    QMutexLocker locker(&uniqueNamesMutex);
+    return uniqueNames;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SetUniqueNames replace handles of names of all objects and variables. GUI thread uses it to apply result of
+ * recalculation.
+ * @param names handles of names.
+ */
+void VContainer::SetUniqueNames(const QSet<quint32> &names)
+{
+    VThreadScope *scope = CurrentScope();
+    if (scope != nullptr)
+    {
+        scope->uniqueNames = names;
+        return;
+    }
+
+    QMutexLocker locker(&uniqueNamesMutex);
+    uniqueNames = names;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief SetSize set value of size
@@ -472,6 +721,7 @@ void VContainer::SetSize(qreal size)
 void VContainer::SetSizeName(const QString &name)
 {
     d->sizeName = name;
+    d->sizeHandle = VNameTable::Handle(name);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -488,6 +738,7 @@ void VContainer::SetHeight(qreal height)
 void VContainer::SetHeightName(const QString &name)
 {
     d->heightName = name;
+    d->heightHandle = VNameTable::Handle(name);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -497,6 +748,10 @@ void VContainer::SetHeightName(const QString &name)
  */
 qreal VContainer::size()
 {
+    if (IsThreadGradation())
+    {
+        return threadGradation.localData()->size;
+    }
     return _size;
 }
 
@@ -506,6 +761,15 @@ QString VContainer::SizeName() const
     return d->sizeName;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SizeHandle return handle of size's name.
+ */
+quint32 VContainer::SizeHandle() const
+{
+    return d->sizeHandle;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief height return height
@@ -513,6 +777,10 @@ QString VContainer::SizeName() const
  */
 qreal VContainer::height()
 {
+    if (IsThreadGradation())
+    {
+        return threadGradation.localData()->height;
+    }
     return _height;
 }
 
@@ -522,6 +790,87 @@ QString VContainer::HeightName() const
     return d->heightName;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief HeightHandle return handle of height's name.
+ */
+quint32 VContainer::HeightHandle() const
+{
+    return d->heightHandle;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SetThreadGradation set size and height only for current thread.
+ *
+ * Grading calculates pattern for many sizes and heights on thread pool at the same time. While thread gradation is set
+ * size() and height() return its values and measurements are not updated in place (see IsThreadGradation()).
+ * @param size value of size in pattern units.
+ * @param height value of height in pattern units.
+ */
+void VContainer::SetThreadGradation(qreal size, qreal height)
+{
+    threadGradation.setLocalData(new VGradation(size, height));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ClearThreadGradation return current thread to global size and height.
+ */
+void VContainer::ClearThreadGradation()
+{
+    threadGradation.setLocalData(nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief BeginThreadScope give current thread own id counter and unique names.
+ *
+ * Pattern recalculated on worker thread must not change id and names GUI thread uses. Worker starts scope with copy
+ * of them and hands result back, GUI thread applies it when result is accepted. Scopes can be nested.
+ * @param id current id.
+ * @param names handles of names of objects and variables.
+ */
+void VContainer::BeginThreadScope(quint32 id, const QSet<quint32> &names)
+{
+    threadScopes.localData().append(VThreadScope(id, names));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief EndThreadScope close last scope of current thread.
+ * @param id gets id counter of scope.
+ * @param names gets unique names of scope.
+ */
+void VContainer::EndThreadScope(quint32 &id, QSet<quint32> &names)
+{
+    VThreadScope *scope = CurrentScope();
+    SCASSERT(scope != nullptr);
+    id = scope->id;
+    names = scope->uniqueNames;
+    threadScopes.localData().removeLast();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IsThreadScope return true if current thread has own id counter and unique names.
+ */
+bool VContainer::IsThreadScope()
+{
+    return CurrentScope() != nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IsThreadGradation return true if current thread has own size and height.
+ *
+ * Measurements and increments are shared between copies of container, in this case their values must not be changed.
+ */
+bool VContainer::IsThreadGradation()
+{
+    return threadGradation.hasLocalData() && threadGradation.localData() != nullptr;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief data container with datagObjects return container of gObjects
@@ -529,7 +878,7 @@ QString VContainer::HeightName() const
  */
 const QHash<quint32, QSharedPointer<VGObject> > *VContainer::DataGObjects() const
 {
-    return &d->gObjects;
+    return &d->gObjects.hash();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -543,9 +892,35 @@ const QHash<quint32, VDetail> *VContainer::DataDetails() const
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-const QHash<QString, QSharedPointer<VInternalVariable> > *VContainer::DataVariables() const
+/**
+ * @brief DataVariables return container of variables. Key is handle of variable's name, see VNameTable::Name().
+ * @return pointer on container of variables
+ */
+const QHash<quint32, QSharedPointer<VInternalVariable> > *VContainer::DataVariables() const
+{
+    return &d->variables.hash();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief EntriesCount return count of objects and variables. Full copy of container would store so many entries.
+ * @return count of entries.
+ */
+int VContainer::EntriesCount() const
+{
+    return d->gObjects.size() + d->variables.size();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CollectStorage collect storage of objects and variables. Storage shared with other containers will be
+ * counted once.
+ * @param storage key is piece of storage, value is count of stored entries.
+ */
+void VContainer::CollectStorage(QHash<const void *, int> &storage) const
 {
-    return &d->variables;
+    d->gObjects.CollectStorage(storage);
+    d->variables.CollectStorage(storage);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
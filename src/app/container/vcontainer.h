@@ -34,9 +34,12 @@
 #include "../geometry/vgobject.h"
 #include "../exception/vexceptionbadid.h"
 #include "../geometry/vabstractcurve.h"
+#include "vversionedhash.h"
+#include "vnametable.h"
 
 #include <QCoreApplication>
 #include <QHash>
+#include <QMutex>
 #include <QSet>
 #include <QSharedPointer>
 
@@ -50,28 +53,32 @@ class VContainerData : public QSharedData
 public:
 
     VContainerData()
-        :sizeName(size_M), heightName(height_M), gObjects(QHash<quint32, QSharedPointer<VGObject> >()),
-          variables(QHash<QString, QSharedPointer<VInternalVariable> > ()), details(QHash<quint32, VDetail>())
+        :sizeName(size_M), heightName(height_M), sizeHandle(VNameTable::Handle(size_M)),
+          heightHandle(VNameTable::Handle(height_M)), gObjects(VVersionedHash<quint32, QSharedPointer<VGObject> >()),
+          variables(VVersionedHash<quint32, QSharedPointer<VInternalVariable> > ()), details(QHash<quint32, VDetail>())
     {}
 
     VContainerData(const VContainerData &data)
-        :QSharedData(data), sizeName(data.sizeName), heightName(data.heightName), gObjects(data.gObjects),
-          variables(data.variables), details(data.details)
+        :QSharedData(data), sizeName(data.sizeName), heightName(data.heightName), sizeHandle(data.sizeHandle),
+          heightHandle(data.heightHandle), gObjects(data.gObjects), variables(data.variables), details(data.details)
     {}
 
     virtual ~VContainerData();
 
     QString        sizeName;
     QString        heightName;
+    quint32        sizeHandle;
+    quint32        heightHandle;
     /**
      * @brief gObjects graphicals objects of pattern.
      */
-    QHash<quint32, QSharedPointer<VGObject> > gObjects;
+    VVersionedHash<quint32, QSharedPointer<VGObject> > gObjects;
 
     /**
-     * @brief variables container for measurements, increments, lines lengths, lines angles, arcs lengths, curve lengths
+     * @brief variables container for measurements, increments, lines lengths, lines angles, arcs lengths, curve lengths.
+     * Key is handle of variable's name from VNameTable.
      */
-    QHash<QString, QSharedPointer<VInternalVariable>> variables;
+    VVersionedHash<quint32, QSharedPointer<VInternalVariable> > variables;
     /**
      * @brief details container of details
      */
@@ -82,6 +89,115 @@ public:
 #pragma GCC diagnostic pop
 #endif
 
+class VPointF;
+class VArc;
+class VSpline;
+class VSplinePath;
+
+/**
+ * @brief The VGObjectType struct checks if geometric object of type can be used as object of class T. Container uses
+ * type of object instead of RTTI when casts objects.
+ */
+template <typename T>
+struct VGObjectType;
+
+template <>
+struct VGObjectType<VGObject>
+{
+    static bool Is(const GOType &type) {Q_UNUSED(type); return true;}
+};
+
+template <>
+struct VGObjectType<VPointF>
+{
+    static bool Is(const GOType &type) {return type == GOType::Point;}
+};
+
+template <>
+struct VGObjectType<VAbstractCurve>
+{
+    static bool Is(const GOType &type)
+    {return type == GOType::Arc || type == GOType::Spline || type == GOType::SplinePath;}
+};
+
+template <>
+struct VGObjectType<VArc>
+{
+    static bool Is(const GOType &type) {return type == GOType::Arc;}
+};
+
+template <>
+struct VGObjectType<VSpline>
+{
+    static bool Is(const GOType &type) {return type == GOType::Spline;}
+};
+
+template <>
+struct VGObjectType<VSplinePath>
+{
+    static bool Is(const GOType &type) {return type == GOType::SplinePath;}
+};
+
+/**
+ * @brief The VVariableType struct checks if variable of type can be used as variable of class T.
+ */
+template <typename T>
+struct VVariableType;
+
+template <>
+struct VVariableType<VInternalVariable>
+{
+    static bool Is(const VarType &type) {Q_UNUSED(type); return true;}
+};
+
+template <>
+struct VVariableType<VVariable>
+{
+    static bool Is(const VarType &type) {return type == VarType::Measurement || type == VarType::Increment;}
+};
+
+template <>
+struct VVariableType<VMeasurement>
+{
+    static bool Is(const VarType &type) {return type == VarType::Measurement;}
+};
+
+template <>
+struct VVariableType<VIncrement>
+{
+    static bool Is(const VarType &type) {return type == VarType::Increment;}
+};
+
+template <>
+struct VVariableType<VLengthLine>
+{
+    static bool Is(const VarType &type) {return type == VarType::LineLength;}
+};
+
+template <>
+struct VVariableType<VLineAngle>
+{
+    static bool Is(const VarType &type) {return type == VarType::LineAngle;}
+};
+
+template <>
+struct VVariableType<VCurveLength>
+{
+    static bool Is(const VarType &type) {return type == VarType::SplineLength || type == VarType::ArcLength;}
+};
+
+template <>
+struct VVariableType<VSplineLength>
+{
+    static bool Is(const VarType &type) {return type == VarType::SplineLength;}
+};
+
+template <>
+struct VVariableType<VArcLength>
+{
+    static bool Is(const VarType &type) {return type == VarType::ArcLength;}
+};
+
 /**
  * @brief The VContainer class container of all variables.
  */
@@ -97,26 +213,19 @@ public:
     template <typename T>
     const QSharedPointer<T> GeometricObject(const quint32 &id) const
     {
-        QSharedPointer<VGObject> gObj = QSharedPointer<VGObject>();
-        if (d->gObjects.contains(id))
-        {
-            gObj = d->gObjects.value(id);
-        }
-        else
-        {
-            throw VExceptionBadId(tr("Can't find object"), id);
-        }
+        return qSharedPointerCast<T>(*FindGObject<T>(id));
+    }
 
-        try
-        {
-            QSharedPointer<T> obj = qSharedPointerDynamicCast<T>(gObj);
-            SCASSERT(obj.isNull() == false);
-            return obj;
-        }
-        catch (const std::bad_alloc &)
-        {
-            throw VExceptionBadId(tr("Can't cast object"), id);
-        }
+    template <typename T>
+    /**
+     * @brief GeometricObjectRef return geometric object by id without copying of pointer. Reference stays valid until
+     * container changes.
+     * @param id object id
+     * @return object
+     */
+    const T           &GeometricObjectRef(const quint32 &id) const
+    {
+        return *static_cast<const T *>(FindGObject<T>(id)->data());
     }
 
     const QSharedPointer<VGObject> GetGObject(quint32 id) const;
@@ -131,26 +240,20 @@ public:
     QSharedPointer<T> GetVariable(QString name) const
     {
         SCASSERT(name.isEmpty()==false);
-        if (d->variables.contains(name))
+        const QSharedPointer<VInternalVariable> *variable = d->variables.Find(VNameTable::Find(name));
+        if (variable == nullptr)
         {
-            try
-            {
-                QSharedPointer<T> value = qSharedPointerDynamicCast<T>(d->variables.value(name));
-                SCASSERT(value.isNull() == false);
-                return value;
-            }
-            catch (const std::bad_alloc &)
-            {
-                throw VExceptionBadId(tr("Can't cast object"), name);
-            }
+            throw VExceptionBadId(tr("Can't find object"), name);
         }
-        else
+        if (VVariableType<T>::Is((*variable)->GetType()) == false)
         {
-            throw VExceptionBadId(tr("Can't find object"), name);
+            throw VExceptionBadId(tr("Can't cast object"), name);
         }
+        return qSharedPointerCast<T>(*variable);
     }
+    VInternalVariable *FindVariable(const quint32 &handle) const;
 
-    static quint32     getId(){return _id;}
+    static quint32     getId();
     static quint32     getNextId();
     static void        UpdateId(quint32 newId);
 
@@ -168,30 +271,30 @@ public:
      */
     void               AddCurveLength(const quint32 &id, const quint32 &parentId = 0)
     {
-        const QSharedPointer<VAbstractCurve> var = GeometricObject<VAbstractCurve>(id);
-        AddVariable(var->name(), new TLength(id, parentId, var.data()));
+        const VAbstractCurve &var = GeometricObjectRef<VAbstractCurve>(id);
+        AddVariable(var.name(), new TLength(id, parentId, &var));
     }
 
     template <typename T>
     void               AddVariable(const QString& name, T *var)
     {
-        if (d->variables.contains(name))
+        const quint32 handle = VNameTable::Handle(name);
+        const QSharedPointer<VInternalVariable> *variable = d.constData()->variables.Find(handle);
+        if (variable != nullptr && (*variable)->GetType() != var->GetType())
         {
-            if (d->variables.value(name)->GetType() == var->GetType())
-            {
-                d->variables[name].clear();
-            }
-            else
-            {
-                throw VExceptionBadId(tr("Can't find object. Type mismatch."), name);
-            }
+            throw VExceptionBadId(tr("Can't find object. Type mismatch."), name);
         }
-        d->variables[name] = QSharedPointer<T>(var);
-        uniqueNames.insert(name);
+        d->variables.insert(handle, QSharedPointer<T>(var));
+        AddUniqueName(handle);
     }
 
     void               UpdateGObject(quint32 id, VGObject* obj);
     void               UpdateDetail(quint32 id, const VDetail &detail);
+    void               UpdateFromContainer(const VContainer &source, const QSet<quint32> &ids,
+                                           const QSet<quint32> &handles);
+    void               MergeChanges(const VContainer &base, const VContainer &changed);
+    bool               ChangesSince(const VContainer &base, QSet<quint32> &ids, QSet<quint32> &handles) const;
+    QVector<quint32>   NewGObjects(const VContainer &base) const;
 
     void               Clear();
     void               ClearGObjects();
@@ -199,6 +302,8 @@ public:
     void               ClearVariables(const VarType &type = VarType::Unknown);
     void               ClearDetails();
     static void        ClearUniqueNames();
+    static QSet<quint32> UniqueNames();
+    static void        SetUniqueNames(const QSet<quint32> &names);
 
     static void        SetSize(qreal size);
     void               SetSizeName(const QString &name);
@@ -206,16 +311,24 @@ public:
     void               SetHeightName(const QString &name);
     static qreal       size();
     QString            SizeName() const;
+    quint32            SizeHandle() const;
     static qreal       height();
     QString            HeightName()const;
+    quint32            HeightHandle() const;
+    static void        SetThreadGradation(qreal size, qreal height);
+    static void        ClearThreadGradation();
+    static bool        IsThreadGradation();
+    static void        BeginThreadScope(quint32 id, const QSet<quint32> &names);
+    static void        EndThreadScope(quint32 &id, QSet<quint32> &names);
+    static bool        IsThreadScope();
 
-    bool               VariableExist(const QString& name);
+    bool               VariableExist(const QString& name) const;
 
     void               RemoveIncrement(const QString& name);
 
     const QHash<quint32, QSharedPointer<VGObject> >         *DataGObjects() const;
     const QHash<quint32, VDetail>                           *DataDetails() const;
-    const QHash<QString, QSharedPointer<VInternalVariable>> *DataVariables() const;
+    const QHash<quint32, QSharedPointer<VInternalVariable>> *DataVariables() const;
 
     const QMap<QString, QSharedPointer<VMeasurement> >  DataMeasurements() const;
     const QMap<QString, QSharedPointer<VIncrement> >    DataIncrements() const;
@@ -226,14 +339,18 @@ public:
 
     static bool        IsUnique(const QString &name);
 
+    int                EntriesCount() const;
+    void               CollectStorage(QHash<const void *, int> &storage) const;
+
 private:
     /**
-     * @brief _id current id. New object will have value +1. For empty class equal 0.
+     * @brief _id current id. New object will have value +1. For empty class equal 0. Thread scope has own id.
      */
     static quint32 _id;
     static qreal   _size;
     static qreal   _height;
-    static QSet<const QString> uniqueNames;
+    static QSet<quint32> uniqueNames;
+    static QMutex        uniqueNamesMutex;
 
     QSharedDataPointer<VContainerData> d;
 
@@ -243,18 +360,40 @@ private:
         return qHash( p.data() );
     }
 
+    static void    AddUniqueName(const quint32 &handle);
+
     template <typename key, typename val>
     // cppcheck-suppress functionStatic
-    const val GetObject(const QHash<key, val> &obj, key id) const;
+    const val GetObject(const VVersionedHash<key, val> &obj, key id) const;
 
     template <typename val>
-    void UpdateObject(QHash<quint32, val > &obj, const quint32 &id, val point);
+    void UpdateObject(VVersionedHash<quint32, val > &obj, const quint32 &id, val point);
 
     template <typename key, typename val>
-    static quint32 AddObject(QHash<key, val> &obj, val value);
+    static quint32 AddObject(VVersionedHash<key, val> &obj, val value);
 
     template <typename T>
     const QMap<QString, QSharedPointer<T> > DataVar(const VarType &type) const;
+
+    template <typename T>
+    /**
+     * @brief FindGObject find geometric object and check its type.
+     * @param id object id
+     * @return pointer to object in container
+     */
+    const QSharedPointer<VGObject> *FindGObject(const quint32 &id) const
+    {
+        const QSharedPointer<VGObject> *gObj = d->gObjects.Find(id);
+        if (gObj == nullptr)
+        {
+            throw VExceptionBadId(tr("Can't find object"), id);
+        }
+        if (VGObjectType<T>::Is((*gObj)->getType()) == false)
+        {
+            throw VExceptionBadId(tr("Can't cast object"), id);
+        }
+        return gObj;
+    }
 };
 
 #endif // VCONTAINER_H
@@ -224,10 +224,8 @@ void VFormula::Eval()
     {
         try
         {
-            Calculator *cal = new Calculator(data);
             QString expression = qApp->FormulaFromUser(formula);
-            const qreal result = cal->EvalFormula(expression);
-            delete cal;
+            const qreal result = Calculator::EvalFormula(data, expression);
 
             //if result equal 0
             if (checkZero && qFuzzyCompare(1 + result, 1 + 0))
@@ -0,0 +1,671 @@
+/************************************************************************
+ **
+ **  @file   vformuladag.cpp
+ **  @author Roman Telezhynskyi <dismine(at)gmail.com>
+ **  @date   17 10, 2026
+ **
+ **  @brief
+ **  @copyright
+ **  This source code is part of the Valentine project, a pattern making
+ **  program, whose allow create and modeling patterns of clothing.
+ **  Copyright (C) 2014 Valentina project
+ **  <https://bitbucket.org/dismine/valentina> All Rights Reserved.
+ **
+ **  Valentina is free software: you can redistribute it and/or modify
+ **  it under the terms of the GNU General Public License as published by
+ **  the Free Software Foundation, either version 3 of the License, or
+ **  (at your option) any later version.
+ **
+ **  Valentina is distributed in the hope that it will be useful,
+ **  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **  GNU General Public License for more details.
+ **
+ **  You should have received a copy of the GNU General Public License
+ **  along with Valentina.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ *************************************************************************/
+
+
+#include "vformuladag.h"
+#include "../options.h"
+#include <QThreadStorage>
+#include <QVarLengthArray>
+#include <QtCore/qmath.h>
+
+using namespace qmu;
+
+QHash<QByteArray, quint32> VFormulaDag::nodes = QHash<QByteArray, quint32>();
+quint32 VFormulaDag::lastNode = 0;
+QHash<quint32, int> VFormulaDag::users = QHash<quint32, int>();
+int VFormulaDag::generation = 0;
+QMutex VFormulaDag::mutex;
+
+/**
+ * @brief The VFormulaMemo struct keep values of nodes calculated in sweep of current thread.
+ */
+struct VFormulaMemo
+{
+    VFormulaMemo() : depth(0), values() {}
+    int                   depth;
+    QHash<quint32, qreal> values;
+};
+
+static QThreadStorage<VFormulaMemo *> formulaMemo;
+
+/**
+ * @brief The VFormulaTree struct keep subtree of formula while bytecode is lowered.
+ */
+struct VFormulaTree
+{
+    VFormulaTree() : steps(), node(0), pure(true) {}
+    QVector<VFormulaStep> steps;
+    quint32               node;
+    bool                  pure;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+static void AppendKey(QByteArray &key, const T &value)
+{
+    key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ShiftStep move operands of step that point to other steps.
+ * @param step step of program.
+ * @param offset how many steps were inserted before.
+ */
+static void ShiftStep(VFormulaStep &step, int offset)
+{
+    switch (step.type)
+    {
+        case VFormulaStepType::Operator:
+            step.a += offset;
+            step.b += offset;
+            break;
+        case VFormulaStepType::Function:
+            for (int i = 0; i < step.args.size(); ++i)
+            {
+                step.args[i] += offset;
+            }
+            break;
+        case VFormulaStepType::Memo:
+            step.a += offset;
+            break;
+        case VFormulaStepType::Variable:
+        case VFormulaStepType::Value:
+        default:
+            break;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Memoize put memo check before pure subtree, so subtree is calculated only once per sweep.
+ *
+ * Subtree with one step is cheaper to calculate than to look up.
+ * @param tree subtree.
+ */
+static void Memoize(VFormulaTree &tree)
+{
+    if (tree.pure == false || tree.steps.size() < 2 || tree.steps.first().type == VFormulaStepType::Memo)
+    {
+        return;
+    }
+
+    for (int i = 0; i < tree.steps.size(); ++i)
+    {
+        ShiftStep(tree.steps[i], 1);
+    }
+    tree.steps.last().memo = true;
+
+    VFormulaStep check;
+    check.type = VFormulaStepType::Memo;
+    check.node = tree.node;
+    check.a = tree.steps.size();
+    tree.steps.prepend(check);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Join make new subtree with step that takes values of children.
+ *
+ * Children that are pure while parent is not are maximal pure subtrees, only they get memo check.
+ * @param children children of new node.
+ * @param step step of new node.
+ * @param key key of new node without children.
+ * @return subtree.
+ */
+static VFormulaTree Join(QVector<VFormulaTree> &children, VFormulaStep step, QByteArray key)
+{
+    VFormulaTree tree;
+    for (int i = 0; i < children.size(); ++i)
+    {
+        tree.pure = tree.pure && children.at(i).pure;
+    }
+
+    QVector<int> roots;
+    for (int i = 0; i < children.size(); ++i)
+    {
+        VFormulaTree &child = children[i];
+        if (tree.pure == false)
+        {
+            Memoize(child);
+        }
+        AppendKey(key, child.node);
+
+        const int offset = tree.steps.size();
+        for (int j = 0; j < child.steps.size(); ++j)
+        {
+            VFormulaStep s = child.steps.at(j);
+            ShiftStep(s, offset);
+            tree.steps.append(s);
+        }
+        roots.append(tree.steps.size() - 1);
+    }
+
+    if (step.type == VFormulaStepType::Operator)
+    {
+        step.a = roots.at(0);
+        step.b = roots.at(1);
+    }
+    else
+    {
+        step.args = roots;
+    }
+    step.node = VFormulaDag::Intern(key);
+    tree.node = step.node;
+    tree.steps.append(step);
+    return tree;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static VFormulaTree Variable(int ref, const QVector<quint32> &handles, const QVector<bool> &pure)
+{
+    QByteArray key("V");
+    AppendKey(key, handles.at(ref));
+
+    VFormulaTree tree;
+    tree.pure = pure.at(ref);
+    tree.node = VFormulaDag::Intern(key);
+
+    VFormulaStep step;
+    step.type = VFormulaStepType::Variable;
+    step.node = tree.node;
+    step.a = ref;
+    tree.steps.append(step);
+    return tree;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static VFormulaTree Value(qreal value)
+{
+    QByteArray key("C");
+    AppendKey(key, value);
+
+    VFormulaTree tree;
+    tree.node = VFormulaDag::Intern(key);
+
+    VFormulaStep step;
+    step.type = VFormulaStepType::Value;
+    step.node = tree.node;
+    step.value = value;
+    tree.steps.append(step);
+    return tree;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static VFormulaTree Operator(ECmdCode code, const VFormulaTree &left, const VFormulaTree &right)
+{
+    QByteArray key("O");
+    AppendKey(key, code);
+
+    VFormulaStep step;
+    step.type = VFormulaStepType::Operator;
+    step.code = code;
+
+    QVector<VFormulaTree> children = QVector<VFormulaTree>() << left << right;
+    return Join(children, step, key);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Lower convert finalized bytecode of formula to program of expression graph.
+ *
+ * Bytecode with if-then-else, assignment, string or bulk functions and with functions that have more than three
+ * arguments is not supported. Program is not needed if formula doesn't have subexpression that can be shared with other
+ * formulas.
+ * @param byteCode finalized bytecode.
+ * @param handles handles of names for each variable reference (in GetVarPtrs() order).
+ * @param pure true for each variable reference that doesn't change while pattern piece is parsed.
+ * @return program or empty vector if formula can't or doesn't need to use expression graph.
+ */
+QVector<VFormulaStep> VFormulaDag::Lower(const QmuParserByteCode &byteCode, const QVector<quint32> &handles,
+                                         const QVector<bool> &pure)
+{
+    SCASSERT(handles.size() == pure.size());
+
+    QVector<VFormulaTree> stack;
+    int ref = 0;
+    for (const SToken *pTok = byteCode.GetBase(); pTok->Cmd != cmEND; ++pTok)
+    {
+        switch (pTok->Cmd)
+        {
+            case cmLE:
+            case cmGE:
+            case cmNEQ:
+            case cmEQ:
+            case cmLT:
+            case cmGT:
+            case cmADD:
+            case cmSUB:
+            case cmMUL:
+            case cmDIV:
+            case cmPOW:
+            case cmLAND:
+            case cmLOR:
+            {
+                if (stack.size() < 2)
+                {
+                    return QVector<VFormulaStep>();
+                }
+                const VFormulaTree right = stack.takeLast();
+                const VFormulaTree left = stack.takeLast();
+                stack.append(Operator(pTok->Cmd, left, right));
+                break;
+            }
+            case cmVAR:
+                stack.append(Variable(ref++, handles, pure));
+                break;
+            case cmVAL:
+                stack.append(Value(pTok->Val.data2));
+                break;
+            case cmVARPOW2:
+            case cmVARPOW3:
+            case cmVARPOW4:
+            {
+                // Same order of multiplications as in parser, so result doesn't differ.
+                const VFormulaTree x = Variable(ref++, handles, pure);
+                VFormulaTree power = Operator(cmMUL, x, x);
+                if (pTok->Cmd != cmVARPOW2)
+                {
+                    power = Operator(cmMUL, power, x);
+                }
+                if (pTok->Cmd == cmVARPOW4)
+                {
+                    power = Operator(cmMUL, power, x);
+                }
+                stack.append(power);
+                break;
+            }
+            case cmVARMUL:
+            {
+                const VFormulaTree x = Variable(ref++, handles, pure);
+                stack.append(Operator(cmADD, Operator(cmMUL, x, Value(pTok->Val.data)), Value(pTok->Val.data2)));
+                break;
+            }
+            case cmFUNC:
+            {
+                const int argc = pTok->Fun.argc;
+                const int count = argc < 0 ? -argc : argc;
+                if (argc > 3 || stack.size() < count)
+                {
+                    return QVector<VFormulaStep>();
+                }
+
+                QByteArray key("F");
+                AppendKey(key, pTok->Fun.ptr);
+                AppendKey(key, argc);
+
+                VFormulaStep step;
+                step.type = VFormulaStepType::Function;
+                step.argc = argc;
+                step.fun = pTok->Fun.ptr;
+
+                QVector<VFormulaTree> children = stack.mid(stack.size() - count);
+                stack.resize(stack.size() - count);
+                stack.append(Join(children, step, key));
+                break;
+            }
+            default:
+                return QVector<VFormulaStep>();
+        }
+    }
+
+    if (stack.size() != 1)
+    {
+        return QVector<VFormulaStep>();
+    }
+
+    VFormulaTree &tree = stack.last();
+    Memoize(tree);
+    bool memo = false;
+    QMutexLocker locker(&mutex);
+    for (int i = 0; i < tree.steps.size(); ++i)
+    {
+        if (tree.steps.at(i).type == VFormulaStepType::Memo)
+        {
+            memo = true;
+            if (++users[tree.steps.at(i).node] == 2)
+            {
+                ++generation;// Programs of earlier formulas can share this node now
+            }
+        }
+    }
+    return memo ? tree.steps : QVector<VFormulaStep>();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Shared remove memo checks of nodes that only one formula uses.
+ *
+ * Nodes get users while formulas are lowered, so program must be pruned again when Generation() changes.
+ * @param steps program from Lower().
+ * @return program or empty vector if no node of program is shared.
+ */
+QVector<VFormulaStep> VFormulaDag::Shared(const QVector<VFormulaStep> &steps)
+{
+    QVector<bool> keep(steps.size(), true);
+    bool shared = false;
+    {
+        QMutexLocker locker(&mutex);
+        for (int i = 0; i < steps.size(); ++i)
+        {
+            if (steps.at(i).type == VFormulaStepType::Memo)
+            {
+                keep[i] = users.value(steps.at(i).node) > 1;
+                shared = shared || keep.at(i);
+            }
+        }
+    }
+
+    if (shared == false)
+    {
+        return QVector<VFormulaStep>();
+    }
+
+    QVector<int> index(steps.size());
+    int count = 0;
+    for (int i = 0; i < steps.size(); ++i)
+    {
+        index[i] = count;
+        if (keep.at(i))
+        {
+            ++count;
+        }
+    }
+
+    QVector<VFormulaStep> program;
+    program.reserve(count);
+    for (int i = 0; i < steps.size(); ++i)
+    {
+        if (keep.at(i) == false)
+        {
+            continue;
+        }
+        VFormulaStep step = steps.at(i);
+        switch (step.type)
+        {
+            case VFormulaStepType::Operator:
+                step.a = index.at(step.a);
+                step.b = index.at(step.b);
+                break;
+            case VFormulaStepType::Function:
+                for (int j = 0; j < step.args.size(); ++j)
+                {
+                    step.args[j] = index.at(step.args.at(j));
+                }
+                break;
+            case VFormulaStepType::Memo:
+                step.a = index.at(step.a);
+                break;
+            case VFormulaStepType::Variable:
+            case VFormulaStepType::Value:
+            default:
+                break;
+        }
+        program.append(step);
+    }
+
+    for (int i = 0; i < steps.size(); ++i)
+    {// Value of node without memo check must not be saved
+        if (steps.at(i).type == VFormulaStepType::Memo && keep.at(i) == false)
+        {
+            program[index.at(steps.at(i).a)].memo = false;
+        }
+    }
+    return program;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Eval calculate program of formula.
+ *
+ * Inside sweep each memo check looks for value of node. If value was found program jumps over steps of subtree,
+ * otherwise subtree is calculated and its value is saved.
+ * @param steps program.
+ * @param vars pointers to values of variable references.
+ * @param values buffer for values of steps.
+ * @return value of formula.
+ */
+qreal VFormulaDag::Eval(const QVector<VFormulaStep> &steps, qreal *const *vars, QVector<qreal> &values)
+{
+    SCASSERT(steps.isEmpty() == false);
+
+    VFormulaMemo *memo = formulaMemo.hasLocalData() ? formulaMemo.localData() : nullptr;
+    if (memo != nullptr && memo->depth == 0)
+    {
+        memo = nullptr;
+    }
+
+    if (values.size() < steps.size())
+    {
+        values.resize(steps.size());
+    }
+    qreal *v = values.data();
+
+#ifdef Q_CC_CLANG
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wundefined-reinterpret-cast"
+#endif
+
+    for (int i = 0; i < steps.size(); ++i)
+    {
+        const VFormulaStep &step = steps.at(i);
+        switch (step.type)
+        {
+            case VFormulaStepType::Memo:
+                if (memo != nullptr)
+                {
+                    const QHash<quint32, qreal>::const_iterator it = memo->values.constFind(step.node);
+                    if (it != memo->values.constEnd())
+                    {
+                        v[step.a] = it.value();
+                        i = step.a;
+                    }
+                }
+                continue;
+            case VFormulaStepType::Variable:
+                v[i] = *vars[step.a];
+                break;
+            case VFormulaStepType::Value:
+                v[i] = step.value;
+                break;
+            case VFormulaStepType::Operator:
+            {
+                const qreal a = v[step.a];
+                const qreal b = v[step.b];
+                switch (step.code)
+                {
+                    case cmLE:
+                        v[i] = a <= b;
+                        break;
+                    case cmGE:
+                        v[i] = a >= b;
+                        break;
+                    case cmNEQ:
+                        v[i] = (qFuzzyCompare(a, b) == false);
+                        break;
+                    case cmEQ:
+                        v[i] = qFuzzyCompare(a, b);
+                        break;
+                    case cmLT:
+                        v[i] = a < b;
+                        break;
+                    case cmGT:
+                        v[i] = a > b;
+                        break;
+                    case cmADD:
+                        v[i] = a + b;
+                        break;
+                    case cmSUB:
+                        v[i] = a - b;
+                        break;
+                    case cmMUL:
+                        v[i] = a * b;
+                        break;
+                    case cmDIV:
+                        v[i] = a / b;
+                        break;
+                    case cmPOW:
+                        v[i] = qPow(a, b);
+                        break;
+                    case cmLAND:
+                        v[i] = static_cast<bool>(a) && static_cast<bool>(b);
+                        break;
+                    case cmLOR:
+                        v[i] = static_cast<bool>(a) || static_cast<bool>(b);
+                        break;
+                    default:
+                        SCASSERT(false);
+                        break;
+                }
+                break;
+            }
+            case VFormulaStepType::Function:
+                switch (step.argc)
+                {
+                    case 0:
+                        v[i] = (*reinterpret_cast<fun_type0>(step.fun))();
+                        break;
+                    case 1:
+                        v[i] = (*reinterpret_cast<fun_type1>(step.fun))(v[step.args.at(0)]);
+                        break;
+                    case 2:
+                        v[i] = (*reinterpret_cast<fun_type2>(step.fun))(v[step.args.at(0)], v[step.args.at(1)]);
+                        break;
+                    case 3:
+                        v[i] = (*reinterpret_cast<fun_type3>(step.fun))(v[step.args.at(0)], v[step.args.at(1)],
+                                                                        v[step.args.at(2)]);
+                        break;
+                    default:
+                    {
+                        QVarLengthArray<qreal, 16> args(step.args.size());
+                        for (int j = 0; j < step.args.size(); ++j)
+                        {
+                            args[j] = v[step.args.at(j)];
+                        }
+                        v[i] = (*reinterpret_cast<multfun_type>(step.fun))(args.constData(), args.size());
+                        break;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (step.memo && memo != nullptr)
+        {
+            memo->values.insert(step.node, v[i]);
+        }
+    }
+
+#ifdef Q_CC_CLANG
+    #pragma clang diagnostic pop
+#endif
+
+    return v[steps.size() - 1];
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IsSweep return true if current thread is inside sweep.
+ */
+bool VFormulaDag::IsSweep()
+{
+    return formulaMemo.hasLocalData() && formulaMemo.localData()->depth > 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Intern return node id of subexpression. Subexpression without id gets new one.
+ * @param key key of subexpression. It is built from kind of node and ids of children.
+ * @return node id.
+ */
+quint32 VFormulaDag::Intern(const QByteArray &key)
+{
+    QMutexLocker locker(&mutex);
+    quint32 &node = nodes[key];
+    if (node == 0)
+    {
+        node = ++lastNode;
+    }
+    return node;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief NodeCount return count of nodes in expression graph.
+ */
+int VFormulaDag::NodeCount()
+{
+    QMutexLocker locker(&mutex);
+    return nodes.size();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Generation return number that changes each time some node gets second user.
+ */
+int VFormulaDag::Generation()
+{
+    QMutexLocker locker(&mutex);
+    return generation;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Clear remove all nodes of expression graph.
+ *
+ * Ids are never reused, so programs lowered before don't get values of other nodes from memo.
+ */
+void VFormulaDag::Clear()
+{
+    QMutexLocker locker(&mutex);
+    nodes.clear();
+    users.clear();
+    ++generation;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VFormulaDag::BeginSweep()
+{
+    if (formulaMemo.hasLocalData() == false)
+    {
+        formulaMemo.setLocalData(new VFormulaMemo());
+    }
+    ++formulaMemo.localData()->depth;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void VFormulaDag::EndSweep()
+{
+    VFormulaMemo *memo = formulaMemo.localData();
+    SCASSERT(memo != nullptr);
+    if (--memo->depth == 0)
+    {
+        memo->values.clear();
+    }
+}
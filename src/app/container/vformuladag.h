@@ -0,0 +1,122 @@
+/************************************************************************
+ **
+ **  @file   vformuladag.h
+ **  @author Roman Telezhynskyi <dismine(at)gmail.com>
+ **  @date   17 10, 2026
+ **
+ **  @brief
+ **  @copyright
+ **  This source code is part of the Valentine project, a pattern making
+ **  program, whose allow create and modeling patterns of clothing.
+ **  Copyright (C) 2014 Valentina project
+ **  <https://bitbucket.org/dismine/valentina> All Rights Reserved.
+ **
+ **  Valentina is free software: you can redistribute it and/or modify
+ **  it under the terms of the GNU General Public License as published by
+ **  the Free Software Foundation, either version 3 of the License, or
+ **  (at your option) any later version.
+ **
+ **  Valentina is distributed in the hope that it will be useful,
+ **  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **  GNU General Public License for more details.
+ **
+ **  You should have received a copy of the GNU General Public License
+ **  along with Valentina.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ *************************************************************************/
+
+
+#ifndef VFORMULADAG_H
+#define VFORMULADAG_H
+
+#include "../../libs/qmuparser/qmuparserbytecode.h"
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+enum class VFormulaStepType : char { Variable, Value, Operator, Function, Memo };
+
+/**
+ * @brief The VFormulaStep struct is one step of formula program lowered to expression graph.
+ *
+ * Operands are indexes of previous steps of the same program. Variable step keeps index of variable reference (in
+ * GetVarPtrs() order) in a. Memo step keeps index of step that calculates value of node in a.
+ */
+struct VFormulaStep
+{
+    VFormulaStep()
+        :type(VFormulaStepType::Value), code(qmu::cmUNKNOWN), node(0), memo(false), a(0), b(0), argc(0), value(0),
+          fun(nullptr), args()
+    {}
+
+    VFormulaStepType      type;
+    qmu::ECmdCode         code;
+    /** @brief node id of expression graph node calculated by this step. */
+    quint32               node;
+    /** @brief memo true if value must be saved for other formulas of sweep. */
+    bool                  memo;
+    int                   a;
+    int                   b;
+    int                   argc;
+    qreal                 value;
+    qmu::generic_fun_type fun;
+    QVector<int>          args;
+};
+
+/**
+ * @brief The VFormulaDag class keeps expression graph shared by all formulas of pattern.
+ *
+ * Each formula is lowered from finalized bytecode to program of steps. Every subtree of formula gets node id. Equal
+ * subtrees get the same node id in all formulas, so node id identifies value of subexpression. Subtrees that depend only
+ * on measurements, increments, size and height don't change while pattern piece is parsed. Such subtree is calculated
+ * by first formula that needs it and all other formulas of the same sweep take its value from memo. Memo is used only
+ * for nodes that have more than one user, lookup of value that nobody else calculates only costs time.
+ *
+ * Memo lives only while VFormulaSweep object exists, outside of sweep program is calculated without memo. Each thread
+ * has own memo, so concurrent gradations don't see values of each other.
+ */
+class VFormulaDag
+{
+public:
+    static QVector<VFormulaStep> Lower(const qmu::QmuParserByteCode &byteCode, const QVector<quint32> &handles,
+                                       const QVector<bool> &pure);
+    static QVector<VFormulaStep> Shared(const QVector<VFormulaStep> &steps);
+    static qreal   Eval(const QVector<VFormulaStep> &steps, qreal *const *vars, QVector<qreal> &values);
+    static bool    IsSweep();
+    static quint32 Intern(const QByteArray &key);
+    static int     NodeCount();
+    static int     Generation();
+    static void    Clear();
+private:
+    Q_DISABLE_COPY(VFormulaDag)
+    VFormulaDag(){}
+    friend class VFormulaSweep;
+
+    static QHash<QByteArray, quint32> nodes;
+    static quint32                    lastNode;
+    static QHash<quint32, int>        users;
+    static int                        generation;
+    static QMutex                     mutex;
+
+    static void    BeginSweep();
+    static void    EndSweep();
+};
+
+/**
+ * @brief The VFormulaSweep class marks scope where all formulas share memo of expression graph.
+ *
+ * Values of measurements, increments, size and height must not change inside sweep. Sweeps can be nested, memo is
+ * cleared when the outer one ends.
+ */
+class VFormulaSweep
+{
+public:
+    VFormulaSweep() { VFormulaDag::BeginSweep(); }
+    ~VFormulaSweep() { VFormulaDag::EndSweep(); }
+private:
+    Q_DISABLE_COPY(VFormulaSweep)
+};
+
+#endif // VFORMULADAG_H
@@ -0,0 +1,99 @@
+/************************************************************************
+ **
+ **  @file   vnametable.cpp
+ **  @author Roman Telezhynskyi <dismine(at)gmail.com>
+ **  @date   17 10, 2026
+ **
+ **  @brief
+ **  @copyright
+ **  This source code is part of the Valentine project, a pattern making
+ **  program, whose allow create and modeling patterns of clothing.
+ **  Copyright (C) 2014 Valentina project
+ **  <https://bitbucket.org/dismine/valentina> All Rights Reserved.
+ **
+ **  Valentina is free software: you can redistribute it and/or modify
+ **  it under the terms of the GNU General Public License as published by
+ **  the Free Software Foundation, either version 3 of the License, or
+ **  (at your option) any later version.
+ **
+ **  Valentina is distributed in the hope that it will be useful,
+ **  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **  GNU General Public License for more details.
+ **
+ **  You should have received a copy of the GNU General Public License
+ **  along with Valentina.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ *************************************************************************/
+
+#include "vnametable.h"
+
+QHash<QString, quint32> VNameTable::handles = QHash<QString, quint32>();
+QVector<QString> VNameTable::names = QVector<QString>() << QString();
+QReadWriteLock VNameTable::lock;
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Handle return handle of name. Name without handle gets new one.
+ * @param name name of variable.
+ * @return handle of name.
+ */
+quint32 VNameTable::Handle(const QString &name)
+{
+    if (name.isEmpty())
+    {
+        return 0;
+    }
+
+    {
+        QReadLocker locker(&lock);
+        const quint32 handle = handles.value(name, 0);
+        if (handle != 0)
+        {
+            return handle;
+        }
+    }
+
+    QWriteLocker locker(&lock);
+    quint32 &handle = handles[name];
+    if (handle == 0)
+    {// Other thread could add name while we were waiting
+        names.append(name);
+        handle = static_cast<quint32>(names.size() - 1);
+    }
+    return handle;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Find return handle of name without creating new one.
+ * @param name name of variable.
+ * @return handle of name or 0 if name doesn't have handle.
+ */
+quint32 VNameTable::Find(const QString &name)
+{
+    QReadLocker locker(&lock);
+    return handles.value(name, 0);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Name return name by handle.
+ * @param handle handle of name.
+ * @return name or empty string if handle is unknown.
+ */
+QString VNameTable::Name(const quint32 &handle)
+{
+    QReadLocker locker(&lock);
+    return names.value(static_cast<int>(handle));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Count return count of names with handle.
+ */
+int VNameTable::Count()
+{
+    QReadLocker locker(&lock);
+    return names.size() - 1;
+}
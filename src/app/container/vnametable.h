@@ -0,0 +1,60 @@
+/************************************************************************
+ **
+ **  @file   vnametable.h
+ **  @author Roman Telezhynskyi <dismine(at)gmail.com>
+ **  @date   17 10, 2026
+ **
+ **  @brief
+ **  @copyright
+ **  This source code is part of the Valentine project, a pattern making
+ **  program, whose allow create and modeling patterns of clothing.
+ **  Copyright (C) 2014 Valentina project
+ **  <https://bitbucket.org/dismine/valentina> All Rights Reserved.
+ **
+ **  Valentina is free software: you can redistribute it and/or modify
+ **  it under the terms of the GNU General Public License as published by
+ **  the Free Software Foundation, either version 3 of the License, or
+ **  (at your option) any later version.
+ **
+ **  Valentina is distributed in the hope that it will be useful,
+ **  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **  GNU General Public License for more details.
+ **
+ **  You should have received a copy of the GNU General Public License
+ **  along with Valentina.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ *************************************************************************/
+
+#ifndef VNAMETABLE_H
+#define VNAMETABLE_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The VNameTable class gives stable integer handles to names of variables.
+ *
+ * Name gets handle first time it is used and keeps it while program is running. Container keeps variables by handle and
+ * calculator keeps handles in compiled formulas, so evaluation doesn't need hash strings. Handle 0 means no name.
+ * Table is shared by all threads.
+ */
+class VNameTable
+{
+public:
+    static quint32 Handle(const QString &name);
+    static quint32 Find(const QString &name);
+    static QString Name(const quint32 &handle);
+    static int     Count();
+private:
+    Q_DISABLE_COPY(VNameTable)
+    VNameTable(){}
+
+    static QHash<QString, quint32> handles;
+    static QVector<QString>        names;
+    static QReadWriteLock          lock;
+};
+
+#endif // VNAMETABLE_H
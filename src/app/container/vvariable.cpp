@@ -84,6 +84,18 @@ void VVariable::SetValue(const qreal &size, const qreal &height)
         qWarning("Gradation doesn't support inches");
         return;
     }
+    VInternalVariable::SetValue(GradedValue(size, height));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief GradedValue calculate value of variable for size and height without changing variable.
+ * @param size value of size in pattern units.
+ * @param height value of height in pattern units.
+ * @return graded value.
+ */
+qreal VVariable::GradedValue(const qreal &size, const qreal &height) const
+{
     const qreal baseSize = VAbstractMeasurements::UnitConvertor(50.0, Unit::Cm, qApp->patternUnit());
     const qreal baseHeight = VAbstractMeasurements::UnitConvertor(176.0, Unit::Cm, qApp->patternUnit());
     const qreal sizeIncrement = VAbstractMeasurements::UnitConvertor(2.0, Unit::Cm, qApp->patternUnit());
@@ -92,7 +104,27 @@ void VVariable::SetValue(const qreal &size, const qreal &height)
     // Formula for calculation gradation
     const qreal k_size    = ( size - baseSize ) / sizeIncrement;
     const qreal k_height  = ( height - baseHeight ) / heightIncrement;
-    VInternalVariable::SetValue(d->base + k_size * d->ksize + k_height * d->kheight);
+    return d->base + k_size * d->ksize + k_height * d->kheight;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SizeDerivative return how graded value changes with size. Value depends on size linearly.
+ * @return derivative of graded value by size.
+ */
+qreal VVariable::SizeDerivative() const
+{
+    return d->ksize / VAbstractMeasurements::UnitConvertor(2.0, Unit::Cm, qApp->patternUnit());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief HeightDerivative return how graded value changes with height. Value depends on height linearly.
+ * @return derivative of graded value by height.
+ */
+qreal VVariable::HeightDerivative() const
+{
+    return d->kheight / VAbstractMeasurements::UnitConvertor(6.0, Unit::Cm, qApp->patternUnit());
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -57,6 +57,9 @@ public:
     void    SetDescription(const QString &desc);
 
     void    SetValue(const qreal &size, const qreal &height);
+    qreal   GradedValue(const qreal &size, const qreal &height) const;
+    qreal   SizeDerivative() const;
+    qreal   HeightDerivative() const;
 
     virtual bool IsNotUsed() const;
 private:
@@ -0,0 +1,742 @@
+/************************************************************************
+ **
+ **  @file   vversionedhash.h
+ **  @author Roman Telezhynskyi <dismine(at)gmail.com>
+ **  @date   17 10, 2026
+ **
+ **  @brief
+ **  @copyright
+ **  This source code is part of the Valentine project, a pattern making
+ **  program, whose allow create and modeling patterns of clothing.
+ **  Copyright (C) 2014 Valentina project
+ **  <https://bitbucket.org/dismine/valentina> All Rights Reserved.
+ **
+ **  Valentina is free software: you can redistribute it and/or modify
+ **  it under the terms of the GNU General Public License as published by
+ **  the Free Software Foundation, either version 3 of the License, or
+ **  (at your option) any later version.
+ **
+ **  Valentina is distributed in the hope that it will be useful,
+ **  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **  GNU General Public License for more details.
+ **
+ **  You should have received a copy of the GNU General Public License
+ **  along with Valentina.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ *************************************************************************/
+
+#ifndef VVERSIONEDHASH_H
+#define VVERSIONEDHASH_H
+
+#include <QAtomicInt>
+#include <QExplicitlySharedDataPointer>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+
+/**
+ * @brief The VVersionedHash class hash with cheap versions.
+ *
+ * Each copy of hash is a version. Values are kept in persistent hash array mapped trie. Node of trie has up to 32 slots
+ * selected by 5 bits of key hash, slot keeps value or sub node. Copy shares root of trie. Write to version copies only
+ * shared nodes on path to changed slot, all other nodes stay shared between versions. Both lookup and write cost
+ * O(log32 n). Const methods can be called from several threads at the same time.
+ */
+template <typename Key, typename T>
+class VVersionedHash
+{
+    struct Node;
+public:
+    /**
+     * @brief The const_iterator class walks trie of version without building flat hash. Order of values is order of
+     * slots. Iterator is valid until version changes.
+     */
+    class const_iterator
+    {
+    public:
+        const_iterator();
+
+        const Key       &key() const;
+        const T         &value() const;
+        const_iterator  &operator++();
+        bool             operator==(const const_iterator &other) const;
+        bool             operator!=(const const_iterator &other) const;
+    private:
+        friend class VVersionedHash<Key, T>;
+
+        struct Position
+        {
+            Position() :node(nullptr), index(0) {}
+            Position(const Node *n, int i) :node(n), index(i) {}
+
+            const Node *node;
+
+            /** @brief index position in values of node, positions after them point to sub nodes. */
+            int         index;
+        };
+
+        /** @brief path path from root to current value, empty for end of version. */
+        QVector<Position> path;
+
+        void             Settle();
+    };
+
+    VVersionedHash();
+    VVersionedHash(const VVersionedHash<Key, T> &hash);
+    VVersionedHash<Key, T> &operator=(const VVersionedHash<Key, T> &hash);
+
+    bool                 contains(const Key &key) const;
+    const T              value(const Key &key) const;
+    void                 insert(const Key &key, const T &value);
+    void                 remove(const Key &key);
+    void                 clear();
+    void                 Merge(const VVersionedHash<Key, T> &base, const VVersionedHash<Key, T> &changed);
+    void                 Changes(const VVersionedHash<Key, T> &base, QVector<QPair<Key, T> > &changed,
+                                 QVector<Key> &removed) const;
+    int                  size() const;
+    bool                 isEmpty() const;
+    const QHash<Key, T> &hash() const;
+    const_iterator       constBegin() const;
+    const_iterator       constEnd() const;
+    const T             *Find(const Key &key) const;
+    void                 CollectStorage(QHash<const void *, int> &storage) const;
+private:
+    struct Node : public QSharedData
+    {
+        Node()
+            :QSharedData(), dataMap(0), nodeMap(0), values(), children()
+        {}
+
+        Node(const Node &node)
+            :QSharedData(node), dataMap(node.dataMap), nodeMap(node.nodeMap), values(node.values),
+              children(node.children)
+        {}
+
+        /** @brief dataMap slots that keep values. */
+        quint32                                      dataMap;
+
+        /** @brief nodeMap slots that keep sub nodes. */
+        quint32                                      nodeMap;
+
+        /** @brief values values in order of slots. Node below last level keeps here all keys with same hash. */
+        QVector<QPair<Key, T> >                      values;
+
+        /** @brief children sub nodes in order of slots. */
+        QVector<QExplicitlySharedDataPointer<Node> > children;
+    };
+
+    /** @brief Bits count of hash bits for one level of trie. */
+    static const int     Bits = 5;
+
+    /** @brief HashBits count of bits in hash. Nodes deeper keep keys with same hash. */
+    static const int     HashBits = 32;
+
+    QExplicitlySharedDataPointer<Node> root;
+    int                  count;
+
+    /** @brief flat cache of all values. Valid only if flatValid is set. Cache is rebuilt under flatMutex. */
+    mutable QHash<Key, T> flat;
+    mutable QAtomicInt    flatValid;
+    mutable QMutex        flatMutex;
+
+    static quint32       Slot(uint h, int shift);
+    static int           Index(quint32 map, quint32 slot);
+    static bool          Insert(QExplicitlySharedDataPointer<Node> &node, int shift, uint h, const Key &key,
+                                const T &value);
+    static void          Remove(QExplicitlySharedDataPointer<Node> &node, int shift, uint h, const Key &key);
+    static void          Flatten(const Node *node, QHash<Key, T> &hash);
+    static void          Diff(const Node *node, const Node *base, int shift, QVector<QPair<Key, T> > &changed,
+                              QVector<Key> &removed);
+    static void          SlotValues(const Node *node, quint32 slot, QVector<QPair<Key, T> > &values);
+    static void          Collect(const Node *node, QVector<QPair<Key, T> > &values);
+    static void          Compare(const QVector<QPair<Key, T> > &values, const QVector<QPair<Key, T> > &baseValues,
+                                 QVector<QPair<Key, T> > &changed, QVector<Key> &removed);
+    static void          CollectStorage(const Node *node, QHash<const void *, int> &storage);
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+VVersionedHash<Key, T>::VVersionedHash()
+    :root(new Node()), count(0), flat(), flatValid(0), flatMutex()
+{}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+VVersionedHash<Key, T>::VVersionedHash(const VVersionedHash<Key, T> &hash)
+    :root(hash.root), count(hash.count), flat(), flatValid(0), flatMutex()
+{
+    QMutexLocker locker(&hash.flatMutex);
+    flat = hash.flat;
+    flatValid.store(hash.flatValid.load());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+VVersionedHash<Key, T> &VVersionedHash<Key, T>::operator=(const VVersionedHash<Key, T> &hash)
+{
+    if (this == &hash)
+    {
+        return *this;
+    }
+    root = hash.root;
+    count = hash.count;
+    QMutexLocker locker(&hash.flatMutex);
+    flat = hash.flat;
+    flatValid.store(hash.flatValid.load());
+    return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+bool VVersionedHash<Key, T>::contains(const Key &key) const
+{
+    return Find(key) != nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief value return value by key.
+ * @param key key.
+ * @return value or default-constructed value if hash doesn't contain key.
+ */
+template <typename Key, typename T>
+const T VVersionedHash<Key, T>::value(const Key &key) const
+{
+    const T *value = Find(key);
+    if (value == nullptr)
+    {
+        return T();
+    }
+    return *value;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::insert(const Key &key, const T &value)
+{
+    if (Insert(root, 0, qHash(key), key, value))
+    {
+        ++count;
+    }
+    flatValid.store(0);
+    flat.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::remove(const Key &key)
+{
+    if (contains(key) == false)
+    {
+        return;
+    }
+    Remove(root, 0, qHash(key), key);
+    --count;
+    flatValid.store(0);
+    flat.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::clear()
+{
+    root = QExplicitlySharedDataPointer<Node>(new Node());
+    count = 0;
+    flatValid.store(0);
+    flat.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Merge apply to version changes other version made since base: changed and new values are inserted, removed
+ * keys are removed. Subtries that changed version still shares with base are skipped, so cost depends on count of
+ * changes, not on size of hash.
+ * @param base version changes are counted from.
+ * @param changed version made from base.
+ */
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::Merge(const VVersionedHash<Key, T> &base, const VVersionedHash<Key, T> &changed)
+{
+    QVector<QPair<Key, T> > values;
+    QVector<Key> removed;
+    changed.Changes(base, values, removed);
+
+    for (int i = 0; i < values.size(); ++i)
+    {
+        insert(values.at(i).first, values.at(i).second);
+    }
+    for (int i = 0; i < removed.size(); ++i)
+    {
+        remove(removed.at(i));
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Changes find values that version changed, added or removed since base. Subtries that version still shares
+ * with base are skipped.
+ * @param base version changes are counted from.
+ * @param changed changed and new values.
+ * @param removed keys that exist only in base.
+ */
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::Changes(const VVersionedHash<Key, T> &base, QVector<QPair<Key, T> > &changed,
+                                     QVector<Key> &removed) const
+{
+    Diff(root.data(), base.root.data(), 0, changed, removed);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+int VVersionedHash<Key, T>::size() const
+{
+    return count;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+bool VVersionedHash<Key, T>::isEmpty() const
+{
+    return count == 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief hash return all values of version. Result is cached until next write.
+ * @return hash.
+ */
+template <typename Key, typename T>
+const QHash<Key, T> &VVersionedHash<Key, T>::hash() const
+{
+    if (flatValid.loadAcquire() == 1)
+    {
+        return flat;
+    }
+
+    QMutexLocker locker(&flatMutex);
+    if (flatValid.load() == 0)
+    {
+        flat.clear();
+        Flatten(root.data(), flat);
+        flatValid.storeRelease(1);
+    }
+    return flat;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+typename VVersionedHash<Key, T>::const_iterator VVersionedHash<Key, T>::constBegin() const
+{
+    const_iterator i;
+    i.path.append(typename const_iterator::Position(root.data(), 0));
+    i.Settle();
+    return i;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+typename VVersionedHash<Key, T>::const_iterator VVersionedHash<Key, T>::constEnd() const
+{
+    return const_iterator();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CollectStorage collect size of each node of version. Nodes shared by several versions will be counted once.
+ * @param storage key is node, value is count of stored entries.
+ */
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::CollectStorage(QHash<const void *, int> &storage) const
+{
+    CollectStorage(root.data(), storage);
+    QMutexLocker locker(&flatMutex);
+    if (flatValid.load() == 1)
+    {
+        storage.insert(&flat, flat.size());
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Find return pointer to value by key. Pointer stays valid until version changes.
+ * @param key key.
+ * @return pointer to value or nullptr if hash doesn't contain key.
+ */
+template <typename Key, typename T>
+const T *VVersionedHash<Key, T>::Find(const Key &key) const
+{
+    const uint h = qHash(key);
+    const Node *node = root.data();
+    for (int shift = 0; shift < HashBits; shift += Bits)
+    {
+        const quint32 slot = Slot(h, shift);
+        if (node->dataMap & slot)
+        {
+            const QPair<Key, T> &pair = node->values.at(Index(node->dataMap, slot));
+            return pair.first == key ? &pair.second : nullptr;
+        }
+        if ((node->nodeMap & slot) == 0)
+        {
+            return nullptr;
+        }
+        node = node->children.at(Index(node->nodeMap, slot)).data();
+    }
+
+    for (int i = 0; i < node->values.size(); ++i)
+    {
+        if (node->values.at(i).first == key)
+        {
+            return &node->values.at(i).second;
+        }
+    }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+quint32 VVersionedHash<Key, T>::Slot(uint h, int shift)
+{
+    return 1u << ((h >> shift) & 0x1f);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Index return position of slot in list of values or sub nodes.
+ * @param map slots map.
+ * @param slot slot bit.
+ * @return count of used slots before slot.
+ */
+template <typename Key, typename T>
+int VVersionedHash<Key, T>::Index(quint32 map, quint32 slot)
+{
+    quint32 bits = map & (slot - 1);
+    bits = bits - ((bits >> 1) & 0x55555555);
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+    return static_cast<int>((((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Insert insert value in subtrie. Shared nodes on path will be copied.
+ * @return true if key is new.
+ */
+template <typename Key, typename T>
+bool VVersionedHash<Key, T>::Insert(QExplicitlySharedDataPointer<Node> &node, int shift, uint h, const Key &key,
+                                    const T &value)
+{
+    node.detach();
+    Node *n = node.data();
+
+    if (shift >= HashBits)
+    {
+        for (int i = 0; i < n->values.size(); ++i)
+        {
+            if (n->values.at(i).first == key)
+            {
+                n->values[i].second = value;
+                return false;
+            }
+        }
+        n->values.append(qMakePair(key, value));
+        return true;
+    }
+
+    const quint32 slot = Slot(h, shift);
+    if (n->nodeMap & slot)
+    {
+        return Insert(n->children[Index(n->nodeMap, slot)], shift + Bits, h, key, value);
+    }
+
+    if (n->dataMap & slot)
+    {
+        const int i = Index(n->dataMap, slot);
+        if (n->values.at(i).first == key)
+        {
+            n->values[i].second = value;
+            return false;
+        }
+
+        // Slot is busy, both values go to new sub node.
+        QExplicitlySharedDataPointer<Node> child(new Node());
+        const QPair<Key, T> old = n->values.at(i);
+        Insert(child, shift + Bits, qHash(old.first), old.first, old.second);
+        Insert(child, shift + Bits, h, key, value);
+
+        n->values.remove(i);
+        n->dataMap &= ~slot;
+        n->nodeMap |= slot;
+        n->children.insert(Index(n->nodeMap, slot), child);
+        return true;
+    }
+
+    n->dataMap |= slot;
+    n->values.insert(Index(n->dataMap, slot), qMakePair(key, value));
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Remove remove existing key from subtrie. Shared nodes on path will be copied. Sub node left with one value
+ * turns back into value.
+ */
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::Remove(QExplicitlySharedDataPointer<Node> &node, int shift, uint h, const Key &key)
+{
+    node.detach();
+    Node *n = node.data();
+
+    if (shift >= HashBits)
+    {
+        for (int i = 0; i < n->values.size(); ++i)
+        {
+            if (n->values.at(i).first == key)
+            {
+                n->values.remove(i);
+                return;
+            }
+        }
+        return;
+    }
+
+    const quint32 slot = Slot(h, shift);
+    if (n->dataMap & slot)
+    {
+        n->values.remove(Index(n->dataMap, slot));
+        n->dataMap &= ~slot;
+        return;
+    }
+
+    if (n->nodeMap & slot)
+    {
+        const int i = Index(n->nodeMap, slot);
+        Remove(n->children[i], shift + Bits, h, key);
+
+        const Node *child = n->children.at(i).data();
+        if (child->nodeMap == 0 && child->values.size() <= 1)
+        {
+            const QVector<QPair<Key, T> > values = child->values;
+            n->children.remove(i);
+            n->nodeMap &= ~slot;
+            if (values.isEmpty() == false)
+            {
+                n->dataMap |= slot;
+                n->values.insert(Index(n->dataMap, slot), values.first());
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::Flatten(const Node *node, QHash<Key, T> &hash)
+{
+    for (int i = 0; i < node->values.size(); ++i)
+    {
+        hash.insert(node->values.at(i).first, node->values.at(i).second);
+    }
+    for (int i = 0; i < node->children.size(); ++i)
+    {
+        Flatten(node->children.at(i).data(), hash);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Diff find values of subtrie that differ from subtrie of base version on the same level.
+ * @param changed values that are new or differ from base.
+ * @param removed keys that exist only in base.
+ */
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::Diff(const Node *node, const Node *base, int shift, QVector<QPair<Key, T> > &changed,
+                                  QVector<Key> &removed)
+{
+    if (node == base)
+    {
+        return;
+    }
+
+    if (shift >= HashBits)
+    {
+        Compare(node->values, base->values, changed, removed);
+        return;
+    }
+
+    for (int bit = 0; bit < (1 << Bits); ++bit)
+    {
+        const quint32 slot = 1u << bit;
+        if ((node->nodeMap & slot) && (base->nodeMap & slot))
+        {
+            Diff(node->children.at(Index(node->nodeMap, slot)).data(),
+                 base->children.at(Index(base->nodeMap, slot)).data(), shift + Bits, changed, removed);
+        }
+        else if (((node->dataMap | node->nodeMap | base->dataMap | base->nodeMap) & slot) != 0)
+        {
+            QVector<QPair<Key, T> > values;
+            QVector<QPair<Key, T> > baseValues;
+            SlotValues(node, slot, values);
+            SlotValues(base, slot, baseValues);
+            Compare(values, baseValues, changed, removed);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SlotValues collect value of slot or all values of sub node in slot.
+ */
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::SlotValues(const Node *node, quint32 slot, QVector<QPair<Key, T> > &values)
+{
+    if (node->dataMap & slot)
+    {
+        values.append(node->values.at(Index(node->dataMap, slot)));
+    }
+    else if (node->nodeMap & slot)
+    {
+        Collect(node->children.at(Index(node->nodeMap, slot)).data(), values);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::Collect(const Node *node, QVector<QPair<Key, T> > &values)
+{
+    values += node->values;
+    for (int i = 0; i < node->children.size(); ++i)
+    {
+        Collect(node->children.at(i).data(), values);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Compare compare values of one slot. Slot keeps only a few values, so simple search is enough.
+ */
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::Compare(const QVector<QPair<Key, T> > &values, const QVector<QPair<Key, T> > &baseValues,
+                                     QVector<QPair<Key, T> > &changed, QVector<Key> &removed)
+{
+    for (int i = 0; i < values.size(); ++i)
+    {
+        int j = 0;
+        while (j < baseValues.size() && (baseValues.at(j).first == values.at(i).first) == false)
+        {
+            ++j;
+        }
+        if (j == baseValues.size() || baseValues.at(j).second != values.at(i).second)
+        {
+            changed.append(values.at(i));
+        }
+    }
+
+    for (int j = 0; j < baseValues.size(); ++j)
+    {
+        int i = 0;
+        while (i < values.size() && (values.at(i).first == baseValues.at(j).first) == false)
+        {
+            ++i;
+        }
+        if (i == values.size())
+        {
+            removed.append(baseValues.at(j).first);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::CollectStorage(const Node *node, QHash<const void *, int> &storage)
+{
+    if (storage.contains(node))
+    {
+        return;
+    }
+    storage.insert(node, node->values.size() + node->children.size());
+    for (int i = 0; i < node->children.size(); ++i)
+    {
+        CollectStorage(node->children.at(i).data(), storage);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+VVersionedHash<Key, T>::const_iterator::const_iterator()
+    :path()
+{}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+const Key &VVersionedHash<Key, T>::const_iterator::key() const
+{
+    const Position &position = path.last();
+    return position.node->values.at(position.index).first;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+const T &VVersionedHash<Key, T>::const_iterator::value() const
+{
+    const Position &position = path.last();
+    return position.node->values.at(position.index).second;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+typename VVersionedHash<Key, T>::const_iterator &VVersionedHash<Key, T>::const_iterator::operator++()
+{
+    ++path.last().index;
+    Settle();
+    return *this;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+bool VVersionedHash<Key, T>::const_iterator::operator==(const const_iterator &other) const
+{
+    if (path.isEmpty() || other.path.isEmpty())
+    {
+        return path.isEmpty() && other.path.isEmpty();
+    }
+    return path.last().node == other.path.last().node && path.last().index == other.path.last().index;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+template <typename Key, typename T>
+bool VVersionedHash<Key, T>::const_iterator::operator!=(const const_iterator &other) const
+{
+    return (*this == other) == false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Settle move iterator to nearest value starting from current position. Path gets empty if there are no more
+ * values.
+ */
+template <typename Key, typename T>
+void VVersionedHash<Key, T>::const_iterator::Settle()
+{
+    while (path.isEmpty() == false)
+    {
+        const Node *node = path.last().node;
+        const int index = path.last().index;
+        if (index < node->values.size())
+        {
+            return;
+        }
+
+        const int child = index - node->values.size();
+        if (child < node->children.size())
+        {
+            ++path.last().index;
+            path.append(Position(node->children.at(child).data(), 0));
+        }
+        else
+        {
+            path.removeLast();
+        }
+    }
+}
+
+#endif // VVERSIONEDHASH_H
@@ -65,7 +65,8 @@ VApplication::VApplication(int &argc, char **argv)
       variables(QMap<QString, VTranslation>()), functions(QMap<QString, VTranslation>()),
       postfixOperators(QMap<QString, VTranslation>()), stDescriptions(QMap<QString, VTranslation>()),
       undoStack(nullptr), sceneView(nullptr), currentScene(nullptr),
-      autoSaveTimer(nullptr), mainWindow(nullptr), openingPattern(false), settings(nullptr), doc(nullptr)
+      autoSaveTimer(nullptr), mainWindow(nullptr), openingPattern(false), settings(nullptr), doc(nullptr),
+      toUserCache(4096), fromUserCache(4096)
 {
     undoStack = new QUndoStack(this);
 
@@ -1464,13 +1465,93 @@ QString VApplication::PostfixOperator(const QString &name) const
 }
 
 //---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief FormulaFromUser translate formula from user look to internal. Throw exception if formula has error.
+ *
+ * Result is cached, so the same formula is parsed only once.
+ */
 QString VApplication::FormulaFromUser(const QString &formula)
 {
-    QString newFormula = formula;
+    const QString key = TranslationKey(formula);
+    const VFormulaTranslation *cached = fromUserCache.object(key);
+    if (cached != nullptr)
+    {
+        return cached->formula;
+    }
+
+    VFormulaTranslation *translation = new VFormulaTranslation();
+    try
+    {
+        TranslateFromUser(formula, *translation);
+    }
+    catch (...)
+    {
+        delete translation;
+        throw;
+    }
+
+    const QString newFormula = translation->formula;
+    fromUserCache.insert(key, translation);// Cache takes ownership
+    return newFormula;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief FormulaToUser translate formula from internal look to user. If formula has error returns it without changes.
+ *
+ * Result is cached, so the same formula is parsed only once.
+ */
+QString VApplication::FormulaToUser(const QString &formula)
+{
+    const QString key = TranslationKey(formula);
+    const VFormulaTranslation *cached = toUserCache.object(key);
+    if (cached != nullptr)
+    {
+        return cached->formula;
+    }
+
+    VFormulaTranslation *translation = new VFormulaTranslation();
+    if (TranslateToUser(formula, *translation) == false)
+    {
+        delete translation;
+        return formula;
+    }
+
+    const QString newFormula = translation->formula;
+    toUserCache.insert(key, translation);// Cache takes ownership
+    return newFormula;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief TranslationKey return key of formula in translation caches.
+ *
+ * Translation depends on system locale and option of using OS separator, so they are part of key. Change of option
+ * doesn't need reset of caches.
+ */
+QString VApplication::TranslationKey(const QString &formula)
+{
+    const bool osSeparatorValue = getSettings()->value("configuration/osSeparator", 1).toBool();
+    return QLocale::system().name() + (osSeparatorValue ? QLatin1Char('1') : QLatin1Char('0')) + QLatin1Char('\n')
+            + formula;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief TranslateFromUser translate formula from user. Throw exception if formula has error.
+ * @param formula formula in user look.
+ * @param translation result of translation.
+ */
+void VApplication::TranslateFromUser(const QString &formula, VFormulaTranslation &translation)
+{
+    QString &newFormula = translation.formula;
+    newFormula = formula;
 
     Calculator *cal = new Calculator(formula);
-    QMap<int, QString> tokens = cal->GetTokens();
-    QMap<int, QString> numbers = cal->GetNumbers();
+    QMap<int, QString> &tokens = translation.tokens;
+    QMap<int, QString> &numbers = translation.numbers;
+    tokens = cal->GetTokens();
+    numbers = cal->GetNumbers();
     delete cal;
 
     QList<int> tKeys = tokens.keys();
@@ -1555,17 +1636,22 @@ QString VApplication::FormulaFromUser(const QString &formula)
 
         }
     }
-
-    return newFormula;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-QString VApplication::FormulaToUser(const QString &formula)
+/**
+ * @brief TranslateToUser translate formula to user.
+ * @param formula formula in internal look.
+ * @param translation result of translation.
+ * @return false if formula has error.
+ */
+bool VApplication::TranslateToUser(const QString &formula, VFormulaTranslation &translation)
 {
-    QString newFormula = formula;
+    QString &newFormula = translation.formula;
+    newFormula = formula;
 
-    QMap<int, QString> tokens;
-    QMap<int, QString> numbers;
+    QMap<int, QString> &tokens = translation.tokens;
+    QMap<int, QString> &numbers = translation.numbers;
     try
     {
         Calculator *cal = new Calculator(formula, false);
@@ -1580,7 +1666,7 @@ QString VApplication::FormulaToUser(const QString &formula)
                  << "Message:     " << e.GetMsg()  << "\n"
                  << "Expression:  " << e.GetExpr() << "\n"
                  << "--------------------------------------";
-        return newFormula;
+        return false;
     }
 
     QList<int> tKeys = tokens.keys();
@@ -1673,7 +1759,7 @@ QString VApplication::FormulaToUser(const QString &formula)
         }
     }
 
-    return newFormula;
+    return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -33,6 +33,7 @@
 #include "../options.h"
 #include "vtranslation.h"
 #include <QSettings>
+#include <QCache>
 #include "../widgets/vmaingraphicsview.h"
 
 class VApplication;// used in define
@@ -46,6 +47,22 @@ class VPattern;
 #endif
 #define qApp (static_cast<VApplication*>(QCoreApplication::instance()))
 
+/**
+ * @brief The VFormulaTranslation struct keep result of translation formula to user or from user.
+ */
+struct VFormulaTranslation
+{
+    VFormulaTranslation()
+        :formula(QString()), tokens(QMap<int, QString>()), numbers(QMap<int, QString>())
+    {}
+    /** @brief formula translated formula. */
+    QString            formula;
+    /** @brief tokens positions of tokens in translated formula. */
+    QMap<int, QString> tokens;
+    /** @brief numbers positions of numbers in translated formula. */
+    QMap<int, QString> numbers;
+};
+
 /**
  * @brief The VApplication class reimplamentation QApplication class.
  */
@@ -143,6 +160,14 @@ private:
     QSettings          *settings;
 
     VPattern           *doc;
+    /**
+     * @brief toUserCache cache of formulas translated to user. Property browser, dialogs and history show the same
+     * formulas again and again, so each formula is parsed only once. Used only from GUI thread.
+     */
+    QCache<QString, VFormulaTranslation> toUserCache;
+    /** @brief fromUserCache cache of formulas translated from user. */
+    QCache<QString, VFormulaTranslation> fromUserCache;
+
     void               InitLineWidth();
     void               InitMeasurements();
     void               InitVariables();
@@ -158,6 +183,9 @@ private:
     void               CorrectionsPositions(int position, int bias, QMap<int, QString> &tokens,
                                             QMap<int, QString> &numbers);
     void               BiasTokens(int position, int bias, QMap<int, QString> &tokens) const;
+    QString            TranslationKey(const QString &formula);
+    void               TranslateFromUser(const QString &formula, VFormulaTranslation &translation);
+    bool               TranslateToUser(const QString &formula, VFormulaTranslation &translation);
     void               InitMeasurement(const QString &name, const VTranslation &m, const VTranslation &g,
                                        const VTranslation &d);
 
@@ -492,9 +492,7 @@ void DialogTool::Eval(const QString &text, bool &flag, QLabel *label, const QStr
             QString formula = text;
             formula.replace("\n", " ");
             formula = qApp->FormulaFromUser(formula);
-            Calculator *cal = new Calculator(data);
-            const qreal result = cal->EvalFormula(formula);
-            delete cal;
+            const qreal result = Calculator::EvalFormula(data, formula);
 
             //if result equal 0
             if (checkZero && qFuzzyCompare(1 + result, 1 + 0))
@@ -154,10 +154,23 @@ qreal VArc::AngleArc() const
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief GetPoints return list of points needed for drawing arc.
+ *
+ * Points are calculated only once, they are kept in shared data until arc is changed.
  * @return list of points
  */
-QVector<QPointF> VArc::GetPoints() const
+const QVector<QPointF> &VArc::GetPoints() const
 {
+    if (d->cached.loadAcquire() == 1)
+    {
+        return d->points;
+    }
+
+    QMutexLocker locker(&d->cacheMutex);
+    if (d->cached.load() == 1)
+    {
+        return d->points;
+    }
+
     QVector<QPointF> points;
     qreal i = 0;
     qreal angle = AngleArc();
@@ -176,7 +189,76 @@ QVector<QPointF> VArc::GetPoints() const
             points.append(line.p2());
         }
     } while (i <= angle);
-    return points;
+
+    d->points = points;
+    d->cached.storeRelease(1);
+    return d->points;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IntersectLine return list of points for real intersection with line.
+ *
+ * Line is intersected with circle of arc, after that we keep points that lie on segment and inside arc angle.
+ * Degenerate arcs use intersection with flattened curve.
+ * @param line line that intersect with arc.
+ * @return list of intersection points ordered along arc.
+ */
+QVector<QPointF> VArc::IntersectLine(const QLineF &line) const
+{
+    const qreal angleArc = AngleArc();
+    if (qFuzzyIsNull(line.length()) || qFuzzyIsNull(d->radius) || qFuzzyIsNull(angleArc))
+    {
+        return VAbstractCurve::IntersectLine(line);
+    }
+
+    QVector<QPointF> intersections;
+    const QPointF center = d->center.toQPointF();
+    QPointF p1;
+    QPointF p2;
+    const qint32 res = LineIntersectCircle(center, d->radius, line, p1, p2);
+    if (res == 0)
+    {
+        return intersections;
+    }
+
+    const qreal eps = 1e-9;
+    const qreal angleEps = 1e-6;
+    const qreal sqLineLength = line.length() * line.length();
+    const QLineF start(center, GetP1());
+    qreal previous = -1;
+    for (qint32 i = 0; i < res; ++i)
+    {
+        const QPointF &point = i == 0 ? p1 : p2;
+
+        // parameter of point on line segment
+        const qreal s = ((point.x() - line.x1()) * line.dx() + (point.y() - line.y1()) * line.dy()) / sqLineLength;
+        if (s < -eps || s > 1 + eps)
+        {
+            continue;
+        }
+
+        qreal angle = start.angleTo(QLineF(center, point));
+        if (angle > 360 - angleEps)
+        {
+            angle = 0;
+        }
+        if (angle > angleArc + angleEps)
+        {
+            continue;
+        }
+
+        if (previous >= 0 && angle < previous)
+        {
+            intersections.prepend(point);
+        }
+        else
+        {
+            intersections.append(point);
+        }
+        previous = angle;
+    }
+    return intersections;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -251,6 +333,7 @@ void VArc::SetFormulaF1(const VFormula &value)
 {
     d->formulaF1 = value.getFormula(FormulaType::FromUser);
     d->f1 = value.getDoubleValue();
+    d->cached.store(0);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -278,6 +361,7 @@ void VArc::SetFormulaF2(const VFormula &value)
 {
     d->formulaF2 = value.getFormula(FormulaType::FromUser);
     d->f2 = value.getDoubleValue();
+    d->cached.store(0);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -305,6 +389,7 @@ void VArc::SetFormulaRadius(const VFormula &value)
 {
     d->formulaRadius = value.getFormula(FormulaType::FromUser);
     d->radius = value.getDoubleValue();
+    d->cached.store(0);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -331,4 +416,5 @@ VPointF VArc::GetCenter() const
 void VArc::SetCenter(const VPointF &value)
 {
     d->center = value;
+    d->cached.store(0);
 }
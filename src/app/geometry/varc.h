@@ -71,7 +71,8 @@ public:
     QPointF            GetP1() const;
     QPointF            GetP2 () const;
     qreal              AngleArc() const;
-    QVector<QPointF>   GetPoints () const;
+    const QVector<QPointF> &GetPoints () const;
+    virtual QVector<QPointF> IntersectLine(const QLineF &line) const;
     QPointF            CutArc (const qreal &length, VArc &arc1, VArc &arc2) const;
     QPointF            CutArc (const qreal &length) const;
     virtual void       setId(const quint32 &id);
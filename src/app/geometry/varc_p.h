@@ -32,6 +32,9 @@
 #include <QSharedData>
 #include "../options.h"
 #include "vpointf.h"
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
 
 #ifdef Q_CC_GNU
     #pragma GCC diagnostic push
@@ -44,23 +47,23 @@ public:
 
     VArcData ()
         : f1(0), formulaF1(QString()), f2(0), formulaF2(QString()), radius(0), formulaRadius(QString()),
-          center(VPointF())
+          center(VPointF()), points(), cached(0), cacheMutex()
     {}
 
     VArcData (VPointF center, qreal radius, QString formulaRadius, qreal f1, QString formulaF1, qreal f2,
                 QString formulaF2)
         : f1(f1), formulaF1(formulaF1), f2(f2), formulaF2(formulaF2), radius(radius), formulaRadius(formulaRadius),
-          center(center)
+          center(center), points(), cached(0), cacheMutex()
     {}
 
     VArcData(VPointF center, qreal radius, qreal f1, qreal f2)
         : f1(f1), formulaF1(QString("%1").arg(f1)), f2(f2), formulaF2(QString("%1").arg(f2)), radius(radius),
-          formulaRadius(QString("%1").arg(radius)), center(center)
+          formulaRadius(QString("%1").arg(radius)), center(center), points(), cached(0), cacheMutex()
     {}
 
     VArcData(const VArcData &arc)
         : QSharedData(arc), f1(arc.f1), formulaF1(arc.formulaF1), f2(arc.f2), formulaF2(arc.formulaF2),
-          radius(arc.radius), formulaRadius(arc.formulaRadius), center(arc.center)
+          radius(arc.radius), formulaRadius(arc.formulaRadius), center(arc.center), points(), cached(0), cacheMutex()
     {}
 
     virtual ~VArcData();
@@ -85,6 +88,14 @@ public:
 
     /** @brief center center point of arc. */
     VPointF            center;
+
+    /** @brief points cached points of arc. Valid only if cached is set. */
+    mutable QVector<QPointF> points;
+
+    /** @brief cached 1 if points are calculated. Cache is filled under cacheMutex and published by this flag. */
+    mutable QAtomicInt       cached;
+
+    mutable QMutex           cacheMutex;
 };
 
 VArcData::~VArcData()
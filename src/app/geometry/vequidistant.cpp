@@ -49,11 +49,11 @@ QPainterPath VEquidistant::ContourPath(const quint32 &idDetail, const VContainer
         {
             case (Tool::NodePoint):
             {
-                const QSharedPointer<VPointF> point = data->GeometricObject<VPointF>(detail.at(i).getId());
-                points.append(point->toQPointF());
+                const VPointF &point = data->GeometricObjectRef<VPointF>(detail.at(i).getId());
+                points.append(point.toQPointF());
                 if (detail.getSeamAllowance() == true)
                 {
-                    QPointF pEkv = point->toQPointF();
+                    QPointF pEkv = point.toQPointF();
                     pEkv.setX(pEkv.x()+detail.at(i).getMx());
                     pEkv.setY(pEkv.y()+detail.at(i).getMy());
                     pointsEkv.append(pEkv);
@@ -62,23 +62,23 @@ QPainterPath VEquidistant::ContourPath(const quint32 &idDetail, const VContainer
             break;
             case (Tool::NodeArc):
             {
-                const QSharedPointer<VArc> arc = data->GeometricObject<VArc>(detail.at(i).getId());
-                qreal len1 = GetLengthContour(points, arc->GetPoints());
-                qreal lenReverse = GetLengthContour(points, GetReversePoint(arc->GetPoints()));
+                const QVector<QPointF> nodePoints = data->GeometricObjectRef<VArc>(detail.at(i).getId()).GetPoints();
+                qreal len1 = GetLengthContour(points, nodePoints);
+                qreal lenReverse = GetLengthContour(points, GetReversePoint(nodePoints));
                 if (len1 <= lenReverse)
                 {
-                    points << arc->GetPoints();
+                    points << nodePoints;
                     if (detail.getSeamAllowance() == true)
                     {
-                        pointsEkv << biasPoints(arc->GetPoints(), detail.at(i).getMx(), detail.at(i).getMy());
+                        pointsEkv << biasPoints(nodePoints, detail.at(i).getMx(), detail.at(i).getMy());
                     }
                 }
                 else
                 {
-                    points << GetReversePoint(arc->GetPoints());
+                    points << GetReversePoint(nodePoints);
                     if (detail.getSeamAllowance() == true)
                     {
-                        pointsEkv << biasPoints(GetReversePoint(arc->GetPoints()), detail.at(i).getMx(),
+                        pointsEkv << biasPoints(GetReversePoint(nodePoints), detail.at(i).getMx(),
                                                 detail.at(i).getMy());
                     }
                 }
@@ -86,23 +86,23 @@ QPainterPath VEquidistant::ContourPath(const quint32 &idDetail, const VContainer
             break;
             case (Tool::NodeSpline):
             {
-                const QSharedPointer<VSpline> spline = data->GeometricObject<VSpline>(detail.at(i).getId());
-                qreal len1 = GetLengthContour(points, spline->GetPoints());
-                qreal lenReverse = GetLengthContour(points, GetReversePoint(spline->GetPoints()));
+                const QVector<QPointF> nodePoints = data->GeometricObjectRef<VSpline>(detail.at(i).getId()).GetPoints();
+                qreal len1 = GetLengthContour(points, nodePoints);
+                qreal lenReverse = GetLengthContour(points, GetReversePoint(nodePoints));
                 if (len1 <= lenReverse)
                 {
-                    points << spline->GetPoints();
+                    points << nodePoints;
                     if (detail.getSeamAllowance() == true)
                     {
-                        pointsEkv << biasPoints(spline->GetPoints(), detail.at(i).getMx(), detail.at(i).getMy());
+                        pointsEkv << biasPoints(nodePoints, detail.at(i).getMx(), detail.at(i).getMy());
                     }
                 }
                 else
                 {
-                    points << GetReversePoint(spline->GetPoints());
+                    points << GetReversePoint(nodePoints);
                     if (detail.getSeamAllowance() == true)
                     {
-                        pointsEkv << biasPoints(GetReversePoint(spline->GetPoints()), detail.at(i).getMx(),
+                        pointsEkv << biasPoints(GetReversePoint(nodePoints), detail.at(i).getMx(),
                                                 detail.at(i).getMy());
                     }
                 }
@@ -110,23 +110,24 @@ QPainterPath VEquidistant::ContourPath(const quint32 &idDetail, const VContainer
             break;
             case (Tool::NodeSplinePath):
             {
-                const QSharedPointer<VSplinePath> splinePath = data->GeometricObject<VSplinePath>(detail.at(i).getId());
-                qreal len1 = GetLengthContour(points, splinePath->GetPoints());
-                qreal lenReverse = GetLengthContour(points, GetReversePoint(splinePath->GetPoints()));
+                const QVector<QPointF> nodePoints =
+                        data->GeometricObjectRef<VSplinePath>(detail.at(i).getId()).GetPoints();
+                qreal len1 = GetLengthContour(points, nodePoints);
+                qreal lenReverse = GetLengthContour(points, GetReversePoint(nodePoints));
                 if (len1 <= lenReverse)
                 {
-                    points << splinePath->GetPoints();
+                    points << nodePoints;
                     if (detail.getSeamAllowance() == true)
                     {
-                     pointsEkv << biasPoints(splinePath->GetPoints(), detail.at(i).getMx(), detail.at(i).getMy());
+                     pointsEkv << biasPoints(nodePoints, detail.at(i).getMx(), detail.at(i).getMy());
                     }
                 }
                 else
                 {
-                    points << GetReversePoint(splinePath->GetPoints());
+                    points << GetReversePoint(nodePoints);
                     if (detail.getSeamAllowance() == true)
                     {
-                        pointsEkv << biasPoints(GetReversePoint(splinePath->GetPoints()), detail.at(i).getMx(),
+                        pointsEkv << biasPoints(GetReversePoint(nodePoints), detail.at(i).getMx(),
                                                 detail.at(i).getMy());
                     }
                 }
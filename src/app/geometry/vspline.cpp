@@ -29,8 +29,82 @@
 #include "vspline.h"
 #include "vspline_p.h"
 #include <QDebug>
+#include <QLineF>
 #include <QPainterPath>
 #include <QtCore/qmath.h>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(Q_PROCESSOR_X86_64)
+#   include <emmintrin.h>
+#   define V_BEZIER_SSE2
+#endif
+
+// Constants of spline flattening, see PointBezier().
+static const double curveCollinearityEpsilon = 1e-30;
+static const double distanceToleranceSquare  = 0.5 * 0.5;
+static const int    curveRecursionLimit      = 32;
+
+/**
+ * @brief Part of spline waiting for subdivision. Each point is pair of coordinates, so x and y can be calculated
+ * together.
+ */
+struct VBezierPart
+{
+    double p[4][2];
+    int    level;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Subdivide divide part of spline in halves by de Casteljau's algorithm with t = 0.5.
+ */
+static inline void Subdivide(const VBezierPart &part, VBezierPart &left, VBezierPart &right)
+{
+#ifdef V_BEZIER_SSE2
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d p1 = _mm_loadu_pd(part.p[0]);
+    const __m128d p2 = _mm_loadu_pd(part.p[1]);
+    const __m128d p3 = _mm_loadu_pd(part.p[2]);
+    const __m128d p4 = _mm_loadu_pd(part.p[3]);
+    const __m128d p12 = _mm_mul_pd(_mm_add_pd(p1, p2), half);
+    const __m128d p23 = _mm_mul_pd(_mm_add_pd(p2, p3), half);
+    const __m128d p34 = _mm_mul_pd(_mm_add_pd(p3, p4), half);
+    const __m128d p123 = _mm_mul_pd(_mm_add_pd(p12, p23), half);
+    const __m128d p234 = _mm_mul_pd(_mm_add_pd(p23, p34), half);
+    const __m128d p1234 = _mm_mul_pd(_mm_add_pd(p123, p234), half);
+
+    _mm_storeu_pd(left.p[0], p1);
+    _mm_storeu_pd(left.p[1], p12);
+    _mm_storeu_pd(left.p[2], p123);
+    _mm_storeu_pd(left.p[3], p1234);
+    _mm_storeu_pd(right.p[0], p1234);
+    _mm_storeu_pd(right.p[1], p234);
+    _mm_storeu_pd(right.p[2], p34);
+    _mm_storeu_pd(right.p[3], p4);
+#else
+    for (int i = 0; i < 2; ++i)
+    {
+        const double p12 = (part.p[0][i] + part.p[1][i]) / 2;
+        const double p23 = (part.p[1][i] + part.p[2][i]) / 2;
+        const double p34 = (part.p[2][i] + part.p[3][i]) / 2;
+        const double p123 = (p12 + p23) / 2;
+        const double p234 = (p23 + p34) / 2;
+        const double p1234 = (p123 + p234) / 2;
+
+        left.p[0][i] = part.p[0][i];
+        left.p[1][i] = p12;
+        left.p[2][i] = p123;
+        left.p[3][i] = p1234;
+        right.p[0][i] = p1234;
+        right.p[1][i] = p234;
+        right.p[2][i] = p34;
+        right.p[3][i] = part.p[3][i];
+    }
+#endif
+    left.level = part.level + 1;
+    right.level = part.level + 1;
+}
 
 //---------------------------------------------------------------------------------------------------------------------
 /**
@@ -93,7 +167,8 @@ VSpline::~VSpline()
  */
 qreal VSpline::GetLength () const
 {
-    return LengthBezier ( GetP1().toQPointF(), d->p2, d->p3, GetP4().toQPointF());
+    UpdateCache();
+    return d->length;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -140,35 +215,26 @@ qreal VSpline::LengthT(qreal t) const
  * @param spl1p3 third point of first spline
  * @param spl2p2 second point of second spline
  * @param spl2p3 third point of second spline
+ * @param tolerance acceptable error of length first spline.
  * @return point of cutting. This point is forth point of first spline and first point of second spline.
  */
-QPointF VSpline::CutSpline ( qreal length, QPointF &spl1p2, QPointF &spl1p3, QPointF &spl2p2, QPointF &spl2p3 ) const
+QPointF VSpline::CutSpline ( qreal length, QPointF &spl1p2, QPointF &spl1p3, QPointF &spl2p2, QPointF &spl2p3,
+                             qreal tolerance ) const
 {
+    const QVector<qreal> table = ArcLengthTable(GetP1().toQPointF(), d->p2, d->p3, GetP4().toQPointF());
+    const qreal fullLength = table.last();
+
     //Always need return two splines, so we must correct wrong length.
-    if (length < GetLength()*0.02)
+    if (length < fullLength*0.02)
     {
-        length = GetLength()*0.02;
+        length = fullLength*0.02;
     }
-    else if ( length > GetLength()*0.98)
+    else if ( length > fullLength*0.98)
     {
-        length = GetLength()*0.98;
+        length = fullLength*0.98;
     }
 
-    // Very stupid way find correct value of t.
-    // Better first compare with t = 0.5. Find length of spline.
-    // If length larger, take t = 0.75 and so on.
-    // If length less, take t = 0.25 and so on.
-    qreal parT = 0;
-    qreal step = 0.001;
-    while (1)
-    {
-        parT = parT + step;
-        qreal splLength = LengthT(parT);
-        if (splLength >= length || parT > 1)
-        {
-            break;
-        }
-    }
+    const qreal parT = ParamT(GetP1().toQPointF(), d->p2, d->p3, GetP4().toQPointF(), table, length, tolerance);
 
     QLineF seg1_2 ( GetP1 ().toQPointF(), GetP2 () );
     seg1_2.setLength(seg1_2.length () * parT);
@@ -202,13 +268,13 @@ QPointF VSpline::CutSpline ( qreal length, QPointF &spl1p2, QPointF &spl1p3, QPo
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-QPointF VSpline::CutSpline(qreal length, VSpline &spl1, VSpline &spl2) const
+QPointF VSpline::CutSpline(qreal length, VSpline &spl1, VSpline &spl2, qreal tolerance) const
 {
     QPointF spl1p2;
     QPointF spl1p3;
     QPointF spl2p2;
     QPointF spl2p3;
-    QPointF cutPoint = CutSpline (length, spl1p2, spl1p3, spl2p2, spl2p3 );
+    QPointF cutPoint = CutSpline (length, spl1p2, spl1p3, spl2p2, spl2p3, tolerance );
 
     spl1 = VSpline(GetP1(), spl1p2, spl1p3, cutPoint, GetKcurve());
     spl2 = VSpline(cutPoint, spl2p2, spl2p3, GetP4(), GetKcurve());
@@ -218,11 +284,91 @@ QPointF VSpline::CutSpline(qreal length, VSpline &spl1, VSpline &spl2) const
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief GetPoints return list with spline points.
+ *
+ * Spline is flattened only once, points are kept in shared data.
  * @return list of points.
  */
-QVector<QPointF> VSpline::GetPoints () const
+const QVector<QPointF> &VSpline::GetPoints () const
 {
-    return GetPoints(GetP1().toQPointF(), d->p2, d->p3, GetP4().toQPointF());
+    UpdateCache();
+    return d->points;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IntersectLine return list of points for real intersection with line.
+ *
+ * Control points are projected on normal of line, so intersections are roots of cubic Bernstein polynomial of
+ * signed distances. Only if spline lies on line we fall back to intersection with flattened curve.
+ * @param line line that intersect with spline.
+ * @return list of intersection points ordered along spline.
+ */
+QVector<QPointF> VSpline::IntersectLine(const QLineF &line) const
+{
+    const qreal lineLength = line.length();
+    if (qFuzzyIsNull(lineLength))
+    {
+        return VAbstractCurve::IntersectLine(line);
+    }
+
+    const QPointF p1 = GetP1().toQPointF();
+    const QPointF p2 = GetP2();
+    const QPointF p3 = GetP3();
+    const QPointF p4 = GetP4().toQPointF();
+
+    // unit normal of line
+    const qreal nx = -line.dy() / lineLength;
+    const qreal ny = line.dx() / lineLength;
+    const qreal d0 = (p1.x() - line.x1()) * nx + (p1.y() - line.y1()) * ny;
+    const qreal d1 = (p2.x() - line.x1()) * nx + (p2.y() - line.y1()) * ny;
+    const qreal d2 = (p3.x() - line.x1()) * nx + (p3.y() - line.y1()) * ny;
+    const qreal d3 = (p4.x() - line.x1()) * nx + (p4.y() - line.y1()) * ny;
+
+    QVector<QPointF> intersections;
+    // Spline lies inside convex hull of control points, so it can't cross line if they all are on one side.
+    if ((d0 > 0 && d1 > 0 && d2 > 0 && d3 > 0) || (d0 < 0 && d1 < 0 && d2 < 0 && d3 < 0))
+    {
+        return intersections;
+    }
+
+    const qreal a = -d0 + 3 * d1 - 3 * d2 + d3;
+    const qreal b = 3 * d0 - 6 * d1 + 3 * d2;
+    const qreal c = -3 * d0 + 3 * d1;
+    const qreal d = d0;
+    if (qFuzzyIsNull(qAbs(a) + qAbs(b) + qAbs(c) + qAbs(d)))
+    {
+        // spline lies on line
+        return VAbstractCurve::IntersectLine(line);
+    }
+
+    const qreal eps = 1e-9;
+    const qreal sqLineLength = lineLength * lineLength;
+    const QVector<qreal> roots = CubicRoots(a, b, c, d);
+    qreal previous = -1;
+    for (int i = 0; i < roots.size(); ++i)
+    {
+        const qreal t = qBound(0.0, roots.at(i), 1.0);
+        if (roots.at(i) < -eps || roots.at(i) > 1 + eps || t - previous <= eps)
+        {
+            continue;
+        }
+
+        const qreal mt = 1 - t;
+        const qreal b0 = mt * mt * mt;
+        const qreal b1 = 3 * mt * mt * t;
+        const qreal b2 = 3 * mt * t * t;
+        const qreal b3 = t * t * t;
+        const QPointF point = p1 * b0 + p2 * b1 + p3 * b2 + p4 * b3;
+
+        // parameter of point on line segment
+        const qreal s = ((point.x() - line.x1()) * line.dx() + (point.y() - line.y1()) * line.dy()) / sqLineLength;
+        if (s >= -eps && s <= 1 + eps)
+        {
+            intersections.append(point);
+            previous = t;
+        }
+    }
+    return intersections;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -237,20 +383,10 @@ QVector<QPointF> VSpline::GetPoints () const
 QVector<QPointF> VSpline::GetPoints (const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4)
 {
     QVector<QPointF> pvector;
-    QVector<qreal> x;
-    QVector<qreal> y;
-    QVector<qreal>& wx = x;
-    QVector<qreal>& wy = y;
-    x.append ( p1.x () );
-    y.append ( p1.y () );
-    PointBezier_r ( p1.x (), p1.y (), p2.x (), p2.y (),
-                    p3.x (), p3.y (), p4.x (), p4.y (), 0, wx, wy );
-    x.append ( p4.x () );
-    y.append ( p4.y () );
-    for ( qint32 i = 0; i < x.count(); ++i )
-    {
-        pvector.append( QPointF ( x.at(i), y.at(i)) );
-    }
+    pvector.reserve(64);
+    pvector.append(p1);
+    PointBezier(p1, p2, p3, p4, pvector);
+    pvector.append(p4);
     return pvector;
 }
 
@@ -277,295 +413,159 @@ qreal VSpline::LengthBezier ( const QPointF &p1, const QPointF &p2, const QPoint
 
 //---------------------------------------------------------------------------------------------------------------------
 /**
- * @brief PointBezier_r find spline point using four point of spline.
- * @param x1 х coordinate first point.
- * @param y1 у coordinate first point.
- * @param x2 х coordinate first control point.
- * @param y2 у coordinate first control point.
- * @param x3 х coordinate second control point.
- * @param y3 у coordinate second control point.
- * @param x4 х coordinate last point.
- * @param y4 у coordinate last point.
- * @param level level of recursion. In the begin 0.
- * @param px list х coordinat spline points.
- * @param py list у coordinat spline points.
+ * @brief PointBezier find spline points using four point of spline.
+ *
+ * Anti-Grain subdivision: spline is divided in halves until each part can be approximated by straight line. Parts wait
+ * on explicit stack, left half is processed first, so points are found in order from first point to last. First and
+ * last points of spline are not added.
+ * @param p1 first spline point.
+ * @param p2 first control point.
+ * @param p3 second control point.
+ * @param p4 last spline point.
+ * @param points list of spline points, new points are appended.
  */
-void VSpline::PointBezier_r ( qreal x1, qreal y1, qreal x2, qreal y2,
-                              qreal x3, qreal y3, qreal x4, qreal y4,
-                              qint16 level, QVector<qreal> &px, QVector<qreal> &py)
-{
-    const double curve_collinearity_epsilon                 = 1e-30;
-    const double curve_angle_tolerance_epsilon              = 0.01;
-    const double m_angle_tolerance = 0.0;
-    enum curve_recursion_limit_e { curve_recursion_limit = 32 };
-    const double m_cusp_limit = 0.0;
-    double m_approximation_scale = 1.0;
-    double m_distance_tolerance_square;
-
-    m_distance_tolerance_square = 0.5 / m_approximation_scale;
-    m_distance_tolerance_square *= m_distance_tolerance_square;
-
-    if (level > curve_recursion_limit)
-    {
-        return;
-    }
-
-    // Calculate all the mid-points of the line segments
-    //----------------------
-    const double x12   = (x1 + x2) / 2;
-    const double y12   = (y1 + y2) / 2;
-    const double x23   = (x2 + x3) / 2;
-    const double y23   = (y2 + y3) / 2;
-    const double x34   = (x3 + x4) / 2;
-    const double y34   = (y3 + y4) / 2;
-    const double x123  = (x12 + x23) / 2;
-    const double y123  = (y12 + y23) / 2;
-    const double x234  = (x23 + x34) / 2;
-    const double y234  = (y23 + y34) / 2;
-    const double x1234 = (x123 + x234) / 2;
-    const double y1234 = (y123 + y234) / 2;
-
-
-    // Try to approximate the full cubic curve by a single straight line
-    //------------------
-    const double dx = x4-x1;
-    const double dy = y4-y1;
-
-    double d2 = fabs((x2 - x4) * dy - (y2 - y4) * dx);
-    double d3 = fabs((x3 - x4) * dy - (y3 - y4) * dx);
-
-    switch ((static_cast<int>(d2 > curve_collinearity_epsilon) << 1) +
-             static_cast<int>(d3 > curve_collinearity_epsilon))
+void VSpline::PointBezier(const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4,
+                          QVector<QPointF> &points)
+{
+    // Depth first search keeps at most one waiting part for each level.
+    VBezierPart stack[curveRecursionLimit + 2];
+    int top = 0;
+    stack[0].p[0][0] = p1.x(); stack[0].p[0][1] = p1.y();
+    stack[0].p[1][0] = p2.x(); stack[0].p[1][1] = p2.y();
+    stack[0].p[2][0] = p3.x(); stack[0].p[2][1] = p3.y();
+    stack[0].p[3][0] = p4.x(); stack[0].p[3][1] = p4.y();
+    stack[0].level = 0;
+
+    while (top >= 0)
     {
-        case 0:
+        const VBezierPart part = stack[top--];
+        if (part.level > curveRecursionLimit)
         {
-            // All collinear OR p1==p4
-            //----------------------
-            double k = dx*dx + dy*dy;
-            if (k < 0.000000001)
-            {
-                d2 = CalcSqDistance(x1, y1, x2, y2);
-                d3 = CalcSqDistance(x4, y4, x3, y3);
-            }
-            else
-            {
-                k   = 1 / k;
-                {
-                    const double da1 = x2 - x1;
-                    const double da2 = y2 - y1;
-                    d2  = k * (da1*dx + da2*dy);
-                }
-                {
-                    const double da1 = x3 - x1;
-                    const double da2 = y3 - y1;
-                    d3  = k * (da1*dx + da2*dy);
-                }
-                // cppcheck-suppress incorrectLogicOperator
-                if (d2 > 0 && d2 < 1 && d3 > 0 && d3 < 1)
-                {
-                    // Simple collinear case, 1---2---3---4
-                    // We can leave just two endpoints
-                    return;
-                }
-                if (d2 <= 0)
-                {
-                    d2 = CalcSqDistance(x2, y2, x1, y1);
-                }
-                else if (d2 >= 1)
-                {
-                    d2 = CalcSqDistance(x2, y2, x4, y4);
-                }
-                else
-                {
-                    d2 = CalcSqDistance(x2, y2, x1 + d2*dx, y1 + d2*dy);
-                }
-
-                if (d3 <= 0)
-                {
-                    d3 = CalcSqDistance(x3, y3, x1, y1);
-                }
-                else if (d3 >= 1)
-                {
-                    d3 = CalcSqDistance(x3, y3, x4, y4);
-                }
-                else
-                {
-                    d3 = CalcSqDistance(x3, y3, x1 + d3*dx, y1 + d3*dy);
-                }
-            }
-            if (d2 > d3)
-            {
-                if (d2 < m_distance_tolerance_square)
-                {
-                    px.append(x2);
-                    py.append(y2);
-                    return;
-                }
-            }
-            else
-            {
-                if (d3 < m_distance_tolerance_square)
-                {
-                    px.append(x3);
-                    py.append(y3);
-                    return;
-                }
-            }
-            break;
+            continue;
         }
-        case 1:
-        {
-            // p1,p2,p4 are collinear, p3 is significant
-            //----------------------
-            if (d3 * d3 <= m_distance_tolerance_square * (dx*dx + dy*dy))
-            {
-                if (m_angle_tolerance < curve_angle_tolerance_epsilon)
-                {
-                    px.append(x23);
-                    py.append(y23);
-                    return;
-                }
 
-                // Angle Condition
-                //----------------------
-                double da1 = fabs(atan2(y4 - y3, x4 - x3) - atan2(y3 - y2, x3 - x2));
-                if (da1 >= M_PI)
-                {
-                    da1 = 2*M_PI - da1;
-                }
+        const double x1 = part.p[0][0], y1 = part.p[0][1];
+        const double x2 = part.p[1][0], y2 = part.p[1][1];
+        const double x3 = part.p[2][0], y3 = part.p[2][1];
+        const double x4 = part.p[3][0], y4 = part.p[3][1];
 
-                if (da1 < m_angle_tolerance)
-                {
-                    px.append(x2);
-                    py.append(y2);
+        // Try to approximate the full cubic curve by a single straight line
+        //------------------
+        const double dx = x4-x1;
+        const double dy = y4-y1;
 
-                    px.append(x3);
-                    py.append(y3);
-                    return;
-                }
+        double d2 = fabs((x2 - x4) * dy - (y2 - y4) * dx);
+        double d3 = fabs((x3 - x4) * dy - (y3 - y4) * dx);
 
-                if (m_cusp_limit > 0.0 || m_cusp_limit < 0.0)
-                {
-                    if (da1 > m_cusp_limit)
-                    {
-                        px.append(x3);
-                        py.append(y3);
-                        return;
-                    }
-                }
-            }
-            break;
-        }
-        case 2:
+        switch ((static_cast<int>(d2 > curveCollinearityEpsilon) << 1) +
+                 static_cast<int>(d3 > curveCollinearityEpsilon))
         {
-            // p1,p3,p4 are collinear, p2 is significant
-            //----------------------
-            if (d2 * d2 <= m_distance_tolerance_square * (dx*dx + dy*dy))
+            case 0:
             {
-                if (m_angle_tolerance < curve_angle_tolerance_epsilon)
-                {
-                    px.append(x23);
-                    py.append(y23);
-                    return;
-                }
-
-                // Angle Condition
+                // All collinear OR p1==p4
                 //----------------------
-                double da1 = fabs(atan2(y3 - y2, x3 - x2) - atan2(y2 - y1, x2 - x1));
-                if (da1 >= M_PI)
+                double k = dx*dx + dy*dy;
+                if (k < 0.000000001)
                 {
-                    da1 = 2*M_PI - da1;
+                    d2 = CalcSqDistance(x1, y1, x2, y2);
+                    d3 = CalcSqDistance(x4, y4, x3, y3);
                 }
-
-                if (da1 < m_angle_tolerance)
+                else
                 {
-                    px.append(x2);
-                    py.append(y2);
+                    k   = 1 / k;
+                    d2  = k * ((x2 - x1)*dx + (y2 - y1)*dy);
+                    d3  = k * ((x3 - x1)*dx + (y3 - y1)*dy);
+                    // cppcheck-suppress incorrectLogicOperator
+                    if (d2 > 0 && d2 < 1 && d3 > 0 && d3 < 1)
+                    {
+                        // Simple collinear case, 1---2---3---4
+                        // We can leave just two endpoints
+                        continue;
+                    }
+                    if (d2 <= 0)
+                    {
+                        d2 = CalcSqDistance(x2, y2, x1, y1);
+                    }
+                    else if (d2 >= 1)
+                    {
+                        d2 = CalcSqDistance(x2, y2, x4, y4);
+                    }
+                    else
+                    {
+                        d2 = CalcSqDistance(x2, y2, x1 + d2*dx, y1 + d2*dy);
+                    }
 
-                    px.append(x3);
-                    py.append(y3);
-                    return;
+                    if (d3 <= 0)
+                    {
+                        d3 = CalcSqDistance(x3, y3, x1, y1);
+                    }
+                    else if (d3 >= 1)
+                    {
+                        d3 = CalcSqDistance(x3, y3, x4, y4);
+                    }
+                    else
+                    {
+                        d3 = CalcSqDistance(x3, y3, x1 + d3*dx, y1 + d3*dy);
+                    }
                 }
-
-                if (m_cusp_limit > 0.0 || m_cusp_limit < 0.0)
+                if (d2 > d3)
                 {
-                    if (da1 > m_cusp_limit)
+                    if (d2 < distanceToleranceSquare)
                     {
-                        px.append(x2);
-                        py.append(y2);
-                        return;
+                        points.append(QPointF(x2, y2));
+                        continue;
                     }
                 }
-            }
-            break;
-        }
-        case 3:
-        {
-            // Regular case
-            //-----------------
-            if ((d2 + d3)*(d2 + d3) <= m_distance_tolerance_square * (dx*dx + dy*dy))
-            {
-                // If the curvature doesn't exceed the distance_tolerance value
-                // we tend to finish subdivisions.
-                //----------------------
-                if (m_angle_tolerance < curve_angle_tolerance_epsilon)
+                else
                 {
-                    px.append(x23);
-                    py.append(y23);
-                    return;
+                    if (d3 < distanceToleranceSquare)
+                    {
+                        points.append(QPointF(x3, y3));
+                        continue;
+                    }
                 }
-
-                // Angle & Cusp Condition
+                break;
+            }
+            case 1:
+                // p1,p2,p4 are collinear, p3 is significant
                 //----------------------
-                const double k   = atan2(y3 - y2, x3 - x2);
-                double da1 = fabs(k - atan2(y2 - y1, x2 - x1));
-                double da2 = fabs(atan2(y4 - y3, x4 - x3) - k);
-                if (da1 >= M_PI)
+                if (d3 * d3 <= distanceToleranceSquare * (dx*dx + dy*dy))
                 {
-                    da1 = 2*M_PI - da1;
+                    // Angle tolerance is not used, so we don't check angle and cusp conditions.
+                    points.append(QPointF((x2 + x3) / 2, (y2 + y3) / 2));
+                    continue;
                 }
-                if (da2 >= M_PI)
+                break;
+            case 2:
+                // p1,p3,p4 are collinear, p2 is significant
+                //----------------------
+                if (d2 * d2 <= distanceToleranceSquare * (dx*dx + dy*dy))
                 {
-                    da2 = 2*M_PI - da2;
+                    points.append(QPointF((x2 + x3) / 2, (y2 + y3) / 2));
+                    continue;
                 }
-
-                if (da1 + da2 < m_angle_tolerance)
+                break;
+            case 3:
+                // Regular case
+                //-----------------
+                if ((d2 + d3)*(d2 + d3) <= distanceToleranceSquare * (dx*dx + dy*dy))
                 {
-                    // Finally we can stop the recursion
+                    // If the curvature doesn't exceed the distance_tolerance value
+                    // we tend to finish subdivisions.
                     //----------------------
-
-                    px.append(x23);
-                    py.append(y23);
-                    return;
+                    points.append(QPointF((x2 + x3) / 2, (y2 + y3) / 2));
+                    continue;
                 }
-
-                if (m_cusp_limit > 0.0 || m_cusp_limit < 0.0)
-                {
-                    if (da1 > m_cusp_limit)
-                    {
-                        px.append(x2);
-                        py.append(y2);
-                        return;
-                    }
-
-                    if (da2 > m_cusp_limit)
-                    {
-                        px.append(x3);
-                        py.append(y3);
-                        return;
-                    }
-                }
-            }
-            break;
+                break;
+            default:
+                break;
         }
-        default:
-            break;
-    }
 
-    // Continue subdivision
-    //----------------------
-    PointBezier_r(x1, y1, x12, y12, x123, y123, x1234, y1234, static_cast<qint16>(level + 1), px, py);
-    PointBezier_r(x1234, y1234, x234, y234, x34, y34, x4, y4, static_cast<qint16>(level + 1), px, py);
+        // Continue subdivision. Right half waits under left one.
+        //----------------------
+        Subdivide(part, stack[top + 2], stack[top + 1]);
+        top += 2;
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -584,6 +584,243 @@ qreal VSpline::CalcSqDistance (qreal x1, qreal y1, qreal x2, qreal y2)
     return dx * dx + dy * dy;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SpeedBezier return length of derivative of spline in point t.
+ * @param p1 first spline point.
+ * @param p2 first control point.
+ * @param p3 second control point.
+ * @param p4 last spline point.
+ * @param t parameter of point.
+ * @return speed.
+ */
+qreal VSpline::SpeedBezier(const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4, qreal t)
+{
+    const qreal mt = 1 - t;
+    const QPointF derivative = 3 * (mt * mt * (p2 - p1) + 2 * mt * t * (p3 - p2) + t * t * (p4 - p3));
+    return qSqrt(derivative.x() * derivative.x() + derivative.y() * derivative.y());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief LengthGauss return length of spline between points t1 and t2.
+ *
+ * Length is integral of speed, it is calculated by five point Gauss-Legendre quadrature. For short part of spline
+ * result is exact to rounding errors.
+ * @param p1 first spline point.
+ * @param p2 first control point.
+ * @param p3 second control point.
+ * @param p4 last spline point.
+ * @param t1 parameter of first point.
+ * @param t2 parameter of second point.
+ * @return length.
+ */
+qreal VSpline::LengthGauss(const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4, qreal t1,
+                           qreal t2)
+{
+    static const qreal abscissa[] = {0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640,
+                                     0.9061798459386640};
+    static const qreal weight[] = {0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891,
+                                   0.2369268850561891};
+
+    const qreal half = (t2 - t1) / 2;
+    const qreal middle = (t1 + t2) / 2;
+    qreal length = 0;
+    for (int i = 0; i < 5; ++i)
+    {
+        length += weight[i] * SpeedBezier(p1, p2, p3, p4, middle + half * abscissa[i]);
+    }
+    return length * half;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ArcLengthTable return table of cumulative length of spline.
+ * @param p1 first spline point.
+ * @param p2 first control point.
+ * @param p3 second control point.
+ * @param p4 last spline point.
+ * @return lengths of spline from first point to points t = i/n, i = 0..n. Last value is length of spline.
+ */
+QVector<qreal> VSpline::ArcLengthTable(const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4)
+{
+    const int segments = 32;
+    QVector<qreal> table(segments + 1);
+    table[0] = 0;
+    for (int i = 0; i < segments; ++i)
+    {
+        table[i + 1] = table.at(i) + LengthGauss(p1, p2, p3, p4, static_cast<qreal>(i) / segments,
+                                                 static_cast<qreal>(i + 1) / segments);
+    }
+    return table;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ParamT find parameter t of point on spline for length from first point.
+ *
+ * Binary search in table of cumulative length gives segment with point. Inside segment t is found by Newton's method,
+ * derivative of length is speed of spline. If step leaves bounds of segment we use bisection.
+ * @param p1 first spline point.
+ * @param p2 first control point.
+ * @param p3 second control point.
+ * @param p4 last spline point.
+ * @param table table of cumulative length (see ArcLengthTable()).
+ * @param length length from first point.
+ * @param tolerance acceptable error of length.
+ * @return parameter t.
+ */
+qreal VSpline::ParamT(const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4,
+                      const QVector<qreal> &table, qreal length, qreal tolerance)
+{
+    const int segments = table.size() - 1;
+    int first = 0;
+    int last = segments;
+    while (last - first > 1)
+    {
+        const int middle = (first + last) / 2;
+        if (table.at(middle) < length)
+        {
+            first = middle;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    const qreal tStart = static_cast<qreal>(first) / segments;
+    qreal tMin = tStart;
+    qreal tMax = static_cast<qreal>(last) / segments;
+    const qreal segLength = table.at(last) - table.at(first);
+    qreal t = tMin;
+    if (segLength > 0)
+    {
+        t = tMin + (tMax - tMin) * (length - table.at(first)) / segLength;
+    }
+
+    const int maxIterations = 64;
+    for (int i = 0; i < maxIterations; ++i)
+    {
+        const qreal error = table.at(first) + LengthGauss(p1, p2, p3, p4, tStart, t) - length;
+        if (qAbs(error) <= tolerance)
+        {
+            break;
+        }
+
+        if (error > 0)
+        {
+            tMax = t;
+        }
+        else
+        {
+            tMin = t;
+        }
+
+        const qreal speed = SpeedBezier(p1, p2, p3, p4, t);
+        qreal next = (tMin + tMax) / 2;
+        if (speed > 0)
+        {
+            const qreal newton = t - error / speed;
+            if (newton > tMin && newton < tMax)
+            {
+                next = newton;
+            }
+        }
+        t = next;
+    }
+    return t;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CubicRoots find real roots of equation a*t^3 + b*t^2 + c*t + d = 0.
+ *
+ * Closed form solution (Cardano and trigonometric) polished by Newton's method. Degenerate equations are solved as
+ * quadratic or linear.
+ * @param a coefficient of t^3.
+ * @param b coefficient of t^2.
+ * @param c coefficient of t.
+ * @param d constant term.
+ * @return roots in ascending order.
+ */
+QVector<qreal> VSpline::CubicRoots(qreal a, qreal b, qreal c, qreal d)
+{
+    QVector<qreal> roots;
+    const qreal scale = qMax(qMax(qAbs(a), qAbs(b)), qMax(qAbs(c), qAbs(d)));
+    const qreal eps = 1e-12 * scale;
+
+    if (qAbs(a) <= eps)
+    {
+        if (qAbs(b) <= eps)
+        {
+            if (qAbs(c) > eps)
+            {
+                roots.append(-d / c);
+            }
+            return roots;
+        }
+
+        const qreal discriminant = c * c - 4 * b * d;
+        if (discriminant < 0)
+        {
+            return roots;
+        }
+        // numerically stable form, avoid subtraction of close values
+        const qreal q = -0.5 * (c + (c < 0 ? -1 : 1) * qSqrt(discriminant));
+        roots.append(q / b);
+        if (qAbs(q) > eps)
+        {
+            roots.append(d / q);
+        }
+    }
+    else
+    {
+        const qreal A = b / a;
+        const qreal B = c / a;
+        const qreal C = d / a;
+        const qreal Q = (3 * B - A * A) / 9;
+        const qreal R = (9 * A * B - 27 * C - 2 * A * A * A) / 54;
+        const qreal discriminant = Q * Q * Q + R * R;
+
+        if (discriminant > 0)
+        {
+            const qreal sqrtD = qSqrt(discriminant);
+            roots.append(std::cbrt(R + sqrtD) + std::cbrt(R - sqrtD) - A / 3);
+        }
+        else if (Q < 0)
+        {
+            const qreal theta = qAcos(qBound(-1.0, R / qSqrt(-Q * Q * Q), 1.0));
+            const qreal m = 2 * qSqrt(-Q);
+            roots.append(m * qCos(theta / 3) - A / 3);
+            roots.append(m * qCos((theta + 2 * M_PI) / 3) - A / 3);
+            roots.append(m * qCos((theta + 4 * M_PI) / 3) - A / 3);
+        }
+        else
+        {
+            roots.append(-A / 3);
+        }
+    }
+
+    for (int i = 0; i < roots.size(); ++i)
+    {
+        qreal t = roots.at(i);
+        for (int j = 0; j < 2; ++j)
+        {
+            const qreal f = ((a * t + b) * t + c) * t + d;
+            const qreal df = (3 * a * t + 2 * b) * t + c;
+            if (qFuzzyIsNull(df))
+            {
+                break;
+            }
+            t -= f / df;
+        }
+        roots[i] = t;
+    }
+    std::sort(roots.begin(), roots.end());
+    return roots;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief CreateName create spline name.
@@ -593,6 +830,30 @@ void VSpline::CreateName()
     setName(QString(spl_+"%1_%2").arg(this->GetP1().name(), this->GetP4().name()));
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief UpdateCache flatten spline and calculate its length if it was not done yet.
+ *
+ * Spline points can't be changed after creation, so cache is never invalidated.
+ */
+void VSpline::UpdateCache() const
+{
+    if (d->cached.loadAcquire() == 0)
+    {
+        QMutexLocker locker(&d->cacheMutex);
+        if (d->cached.load() == 0)
+        {
+            d->points = GetPoints(GetP1().toQPointF(), d->p2, d->p3, GetP4().toQPointF());
+            d->length = 0;
+            for (qint32 i = 1; i < d->points.size(); ++i)
+            {
+                d->length += QLineF(d->points.at(i-1), d->points.at(i)).length();
+            }
+            d->cached.storeRelease(1);
+        }
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief SplinePoints return list with spline points.
@@ -65,9 +65,11 @@ public:
     qreal   GetKcurve() const;
     void    SetKcurve(qreal factor);
     qreal   LengthT(qreal t) const;
-    QPointF CutSpline ( qreal length, QPointF &spl1p2, QPointF &spl1p3, QPointF &spl2p2, QPointF &spl2p3) const;
-    QPointF CutSpline ( qreal length, VSpline &spl1, VSpline &spl2) const;
-    QVector<QPointF> GetPoints () const;
+    QPointF CutSpline ( qreal length, QPointF &spl1p2, QPointF &spl1p3, QPointF &spl2p2, QPointF &spl2p3,
+                        qreal tolerance = 0.001) const;
+    QPointF CutSpline ( qreal length, VSpline &spl1, VSpline &spl2, qreal tolerance = 0.001) const;
+    const QVector<QPointF> &GetPoints () const;
+    virtual QVector<QPointF> IntersectLine(const QLineF &line) const;
     // cppcheck-suppress unusedFunction
     static QVector<QPointF> SplinePoints(const QPointF &p1, const QPointF &p4, qreal angle1, qreal angle2, qreal kAsm1,
                                          qreal kAsm2, qreal kCurve);
@@ -76,10 +78,18 @@ protected:
 private:
     QSharedDataPointer<VSplineData> d;
     static qreal   LengthBezier (const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4 );
-    static void    PointBezier_r ( qreal x1, qreal y1, qreal x2, qreal y2, qreal x3, qreal y3, qreal x4, qreal y4,
-                                  qint16 level, QVector<qreal> &px, QVector<qreal> &py);
+    static void    PointBezier (const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4,
+                                QVector<QPointF> &points);
     static qreal   CalcSqDistance ( qreal x1, qreal y1, qreal x2, qreal y2);
+    static qreal   SpeedBezier (const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4, qreal t);
+    static qreal   LengthGauss (const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4,
+                                qreal t1, qreal t2);
+    static QVector<qreal> ArcLengthTable (const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4);
+    static qreal   ParamT (const QPointF &p1, const QPointF &p2, const QPointF &p3, const QPointF &p4,
+                           const QVector<qreal> &table, qreal length, qreal tolerance);
+    static QVector<qreal> CubicRoots (qreal a, qreal b, qreal c, qreal d);
     void           CreateName();
+    void           UpdateCache() const;
 };
 
 #endif // VSPLINE_H
@@ -29,6 +29,7 @@
 #include "vsplinepath.h"
 #include "vsplinepath_p.h"
 #include "../exception/vexception.h"
+#include <QLineF>
 
 //---------------------------------------------------------------------------------------------------------------------
 VSplinePath::VSplinePath(qreal kCurve, quint32 idObject, Draw mode)
@@ -48,6 +49,7 @@ VSplinePath::~VSplinePath()
 void VSplinePath::append(const VSplinePoint &point)
 {
     d->path.append(point);
+    d->cached.store(0);
     QString name = splPath;
     name.append(QString("_%1").arg(d->path.first().P().name()));
     if (d->path.size() > 1)
@@ -100,29 +102,65 @@ QPainterPath VSplinePath::GetPath(PathDirection direction) const
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-QVector<QPointF> VSplinePath::GetPoints() const
+const QVector<QPointF> &VSplinePath::GetPoints() const
 {
-    QVector<QPointF> pathPoints;
+    UpdateCache();
+    return d->points;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+qreal VSplinePath::GetLength() const
+{
+    UpdateCache();
+    return d->length;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+QVector<QPointF> VSplinePath::IntersectLine(const QLineF &line) const
+{
+    QVector<QPointF> intersections;
     for (qint32 i = 1; i <= Count(); ++i)
     {
         VSpline spl(d->path.at(i-1).P(), d->path.at(i).P(), d->path.at(i-1).Angle2(), d->path.at(i).Angle1(),
                     d->path.at(i-1).KAsm2(), d->path.at(i).KAsm1(), d->kCurve);
-        pathPoints += spl.GetPoints();
+        const QVector<QPointF> points = spl.IntersectLine(line);
+        for (qint32 j = 0; j < points.size(); ++j)
+        {
+            // neighbour splines share point, don't count it twice
+            if (intersections.isEmpty() == false && QLineF(intersections.last(), points.at(j)).length() < 1e-6)
+            {
+                continue;
+            }
+            intersections.append(points.at(j));
+        }
     }
-    return pathPoints;
+    return intersections;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-qreal VSplinePath::GetLength() const
+void VSplinePath::UpdateCache() const
 {
-    qreal length = 0;
+    if (d->cached.loadAcquire() == 1)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&d->cacheMutex);
+    if (d->cached.load() == 1)
+    {
+        return;
+    }
+
+    d->points.clear();
+    d->length = 0;
     for (qint32 i = 1; i <= Count(); ++i)
     {
         VSpline spl(d->path.at(i-1).P(), d->path.at(i).P(), d->path.at(i-1).Angle2(), d->path.at(i).Angle1(),
                     d->path.at(i-1).KAsm2(), d->path.at(i).KAsm1(), d->kCurve);
-        length += spl.GetLength();
+        d->points += spl.GetPoints();
+        d->length += spl.GetLength();
     }
-    return length;
+    d->cached.storeRelease(1);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -140,6 +178,7 @@ void VSplinePath::UpdatePoint(qint32 indexSpline, const SplinePointPosition &pos
     {
         d->path[indexSpline] = point;
     }
+    d->cached.store(0);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -174,6 +213,7 @@ VSplinePath &VSplinePath::operator =(const VSplinePath &path)
 //---------------------------------------------------------------------------------------------------------------------
 VSplinePoint & VSplinePath::operator[](int indx)
 {
+    d->cached.store(0);// Point can be changed by reference
     return d->path[indx];
 }
 
@@ -247,6 +287,7 @@ QVector<VSplinePoint> VSplinePath::GetSplinePath() const
 void VSplinePath::Clear()
 {
     d->path.clear();
+    d->cached.store(0);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -261,6 +302,7 @@ void VSplinePath::setKCurve(const qreal &value)
     if (value > 0)
     {
         d->kCurve = value;
+        d->cached.store(0);
     }
 }
 
@@ -88,7 +88,7 @@ public:
      * @brief GetPathPoints return list of points what located on path.
      * @return list.
      */
-    QVector<QPointF> GetPoints() const;
+    const QVector<QPointF> &GetPoints() const;
     /**
      * @brief GetSplinePath return list with spline points.
      * @return list.
@@ -99,6 +99,13 @@ public:
      * @return length.
      */
     qreal         GetLength() const;
+    /**
+     * @brief IntersectLine return list of points for real intersection with line. Each spline of path is
+     * intersected analytically.
+     * @param line line that intersect with spline path.
+     * @return list of intersection points ordered along path.
+     */
+    virtual QVector<QPointF> IntersectLine(const QLineF &line) const;
     /**
      * @brief UpdatePoint update spline point in list.
      * @param indexSpline spline index in list.
@@ -187,6 +194,10 @@ public:
     void setMaxCountPoints(const qint32 &value);
 private:
     QSharedDataPointer<VSplinePathData> d;
+    /**
+     * @brief UpdateCache flatten spline path and calculate its length if it was not done after last change.
+     */
+    void          UpdateCache() const;
 };
 
 #endif // VSPLINEPATH_H
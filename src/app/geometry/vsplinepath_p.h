@@ -32,6 +32,9 @@
 #include <QSharedData>
 #include "../options.h"
 #include "vsplinepoint.h"
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
 
 #ifdef Q_CC_GNU
     #pragma GCC diagnostic push
@@ -43,15 +46,17 @@ class VSplinePathData : public QSharedData
 public:
 
     VSplinePathData()
-        : path(QVector<VSplinePoint>()), kCurve(1), maxCountPoints(0)
+        : path(QVector<VSplinePoint>()), kCurve(1), maxCountPoints(0), points(), length(0), cached(0), cacheMutex()
     {}
 
     VSplinePathData(qreal kCurve)
-        : path(QVector<VSplinePoint>()), kCurve(kCurve), maxCountPoints(0)
+        : path(QVector<VSplinePoint>()), kCurve(kCurve), maxCountPoints(0), points(), length(0), cached(0),
+          cacheMutex()
     {}
 
     VSplinePathData(const VSplinePathData &splPath)
-        : QSharedData(splPath), path(splPath.path), kCurve(splPath.kCurve), maxCountPoints(splPath.maxCountPoints)
+        : QSharedData(splPath), path(splPath.path), kCurve(splPath.kCurve), maxCountPoints(splPath.maxCountPoints),
+          points(), length(0), cached(0), cacheMutex()
     {}
 
     virtual ~VSplinePathData();
@@ -68,6 +73,20 @@ public:
      * @brief maxCountPoints max count of points what can have spline path.
      */
     qint32        maxCountPoints;
+    /**
+     * @brief points cached flattened spline path. Valid only if cached is set.
+     */
+    mutable QVector<QPointF> points;
+    /**
+     * @brief length cached length of spline path.
+     */
+    mutable qreal            length;
+    /**
+     * @brief cached 1 if points and length are calculated. Cache is filled under cacheMutex and published by this
+     * flag.
+     */
+    mutable QAtomicInt       cached;
+    mutable QMutex           cacheMutex;
 };
 
 VSplinePathData::~VSplinePathData()
@@ -43,6 +43,8 @@
 #include "undocommands/renamepp.h"
 #include "vtooloptionspropertybrowser.h"
 #include "options.h"
+#include "container/calculator.h"
+#include "dialogs/tools/dialogeditwrongformula.h"
 
 #include <QInputDialog>
 #include <QDebug>
@@ -56,6 +58,7 @@
 #include <QProcess>
 #include <QSettings>
 #include <QTimer>
+#include <QTextStream>
 #include <QtGlobal>
 #include <QDesktopWidget>
 #include <QDesktopServices>
@@ -72,7 +75,7 @@ MainWindow::MainWindow(QWidget *parent)
       comboBoxDraws(nullptr), curFile(QString()), mode(Draw::Calculation), currentDrawIndex(0),
       currentToolBoxIndex(0), drawMode(true), recentFileActs(),
       separatorAct(nullptr), autoSaveTimer(nullptr), guiEnabled(true), gradationHeights(nullptr),
-      gradationSizes(nullptr), toolOptions(nullptr)
+      gradationSizes(nullptr), toolOptions(nullptr), gradationCheck(nullptr), gradationProgress(nullptr)
 {
     for (int i = 0; i < MaxRecentFiles; ++i)
     {
@@ -116,6 +119,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(doc, &VPattern::SetEnabledGUI, this, &MainWindow::SetEnabledGUI);
     connect(doc, &VPattern::CheckLayout, this, &MainWindow::Layout);
     connect(doc, &VPattern::SetCurrentPP, this, &MainWindow::GlobalChangePP);
+    connect(doc, &VPattern::WrongFormulas, this, &MainWindow::WrongFormulas);
     qApp->setCurrentDocument(doc);
 
     connect(qApp->getUndoStack(), &QUndoStack::cleanChanged, this, &MainWindow::PatternWasModified);
@@ -764,6 +768,143 @@ void MainWindow::EditPatternCode()
     Pattern->show();
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief MemoryReport show how much memory data sets of tools share.
+ */
+void MainWindow::MemoryReport()
+{
+    QMessageBox::information(this, tr("Data memory report"), doc->DataMemoryReport());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief MeasurementDependencies show how formulas of tools depend on measurements.
+ */
+void MainWindow::MeasurementDependencies()
+{
+    const QStringList report = doc->SensitivityReport();
+
+    QMessageBox messageBox(this);
+    messageBox.setWindowTitle(tr("Measurement dependencies"));
+    messageBox.setIcon(QMessageBox::Information);
+    if (report.isEmpty())
+    {
+        messageBox.setText(tr("Formulas of tools don't use measurements and increments."));
+    }
+    else
+    {
+        messageBox.setText(tr("Formulas of tools use measurements and increments %1 times. Details show how value of "
+                              "formula changes when variable grows by one unit.").arg(report.size()));
+        messageBox.setDetailedText(report.join("\n"));
+    }
+    messageBox.setStandardButtons(QMessageBox::Ok);
+    messageBox.exec();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ExportGradeRules save grade rules of formulas of tools to comma-separated file.
+ */
+void MainWindow::ExportGradeRules()
+{
+    const QString path = qApp->getSettings()->value("paths/pattern", QDir::homePath()).toString();
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export grade rules"), path + "/" + tr("rules") + ".csv",
+                                                    tr("Comma-separated values (*.csv)"));
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+    if (QFileInfo(fileName).suffix().isEmpty())
+    {
+        fileName += ".csv";
+    }
+
+    QFile file(fileName);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text) == false)
+    {
+        QMessageBox::warning(this, tr("Export grade rules"), tr("Can't write file %1:\n%2.").arg(fileName)
+                             .arg(file.errorString()));
+        return;
+    }
+    QTextStream out(&file);
+    out << doc->GradeRules().join("\n") << "\n";
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CheckGradation start calculation of pattern for all sizes and heights of gradation. Window shows progress,
+ * user can cancel check.
+ */
+void MainWindow::CheckGradation()
+{
+    if (gradationCheck != nullptr)
+    {
+        return;
+    }
+
+    gradationProgress = new QProgressDialog(tr("Calculating pattern for sizes and heights..."), tr("Cancel"), 0, 0,
+                                            this);
+    gradationProgress->setWindowTitle(tr("Check gradation"));
+    gradationProgress->setWindowModality(Qt::WindowModal);
+    gradationProgress->setAutoClose(false);
+    gradationProgress->setAutoReset(false);
+
+    gradationCheck = new QFutureWatcher<VPatternGrade>(this);
+    connect(gradationCheck, &QFutureWatcherBase::progressRangeChanged, gradationProgress, &QProgressDialog::setRange);
+    connect(gradationCheck, &QFutureWatcherBase::progressValueChanged, gradationProgress, &QProgressDialog::setValue);
+    connect(gradationCheck, &QFutureWatcherBase::finished, this, &MainWindow::GradationChecked);
+    connect(gradationProgress, &QProgressDialog::canceled, gradationCheck, &QFutureWatcherBase::cancel);
+    connect(gradationProgress, &QProgressDialog::canceled, doc, &VPattern::CancelGrade);
+    gradationCheck->setFuture(doc->Grade());
+    gradationProgress->show();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief GradationChecked show combinations of size and height that fail after check of gradation finished.
+ */
+void MainWindow::GradationChecked()
+{
+    SCASSERT(gradationCheck != nullptr);
+    const QFuture<VPatternGrade> future = gradationCheck->future();
+    gradationCheck->deleteLater();
+    gradationCheck = nullptr;
+    gradationProgress->deleteLater();
+    gradationProgress = nullptr;
+
+    if (future.isCanceled())
+    {
+        return;
+    }
+
+    const QList<VPatternGrade> grades = future.results();
+    QStringList failed;
+    for (int i = 0; i < grades.size(); ++i)
+    {
+        if (grades.at(i).success == false)
+        {
+            failed.append(tr("Size %1, height %2").arg(grades.at(i).size).arg(grades.at(i).height));
+        }
+    }
+
+    if (failed.isEmpty())
+    {
+        QMessageBox::information(this, tr("Check gradation"),
+                                 tr("Pattern was calculated for all %1 sizes and heights.").arg(grades.size()));
+        return;
+    }
+
+    QMessageBox messageBox(this);
+    messageBox.setWindowTitle(tr("Check gradation"));
+    messageBox.setIcon(QMessageBox::Warning);
+    messageBox.setText(tr("Pattern can't be calculated for %1 of %2 sizes and heights.").arg(failed.size())
+                       .arg(grades.size()));
+    messageBox.setDetailedText(failed.join("\n"));
+    messageBox.setStandardButtons(QMessageBox::Ok);
+    messageBox.exec();
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief showEvent handle after show window.
@@ -1392,6 +1533,7 @@ void MainWindow::Clear()
     ui->actionDraw->setEnabled(false);
     setCurrentFile("");
     pattern->Clear();
+    Calculator::ClearFormulaCache();
     doc->clear();
     sceneDraw->clear();
     sceneDetails->clear();
@@ -1408,6 +1550,10 @@ void MainWindow::Clear()
     ui->actionHistory->setEnabled(false);
     ui->actionTable->setEnabled(false);
     ui->actionEdit_pattern_code->setEnabled(false);
+    ui->actionMemory_report->setEnabled(false);
+    ui->actionMeasurement_dependencies->setEnabled(false);
+    ui->actionExport_grade_rules->setEnabled(false);
+    ui->actionCheck_gradation->setEnabled(false);
     SetEnableTool(false);
     qApp->setPatternUnit(Unit::Cm);
     qApp->setPatternType(MeasurementsType::Individual);
@@ -1455,6 +1601,53 @@ void MainWindow::ResetWindow()
     Clear();
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief WrongFormulas show all wrong formulas of opened pattern in one message and let user fix them.
+ *
+ * Formulas are fixed in file before tools are created, so pattern is not parsed again. Tools don't ask about formulas
+ * that user didn't fix.
+ * @param errors failed checks of formulas.
+ */
+void MainWindow::WrongFormulas(const QVector<VFormulaCheck> &errors)
+{
+    QStringList details;
+    for (int i = 0; i < errors.size(); ++i)
+    {
+        const VFormulaCheck &check = errors.at(i);
+        details.append(tr("Tool id %1, attribute \"%2\": %3 (position %4)\n%5").arg(check.toolId)
+                       .arg(check.attribute).arg(check.error).arg(check.position).arg(check.formula));
+    }
+
+#ifndef QT_NO_CURSOR
+    QApplication::restoreOverrideCursor();
+#endif
+    QMessageBox messageBox(this);
+    messageBox.setIcon(QMessageBox::Warning);
+    messageBox.setText(tr("Pattern has %1 wrong formula(s).").arg(errors.size()));
+    messageBox.setInformativeText(tr("Do you want to fix them now? Pattern can't be opened with wrong formulas."));
+    messageBox.setDetailedText(details.join("\n\n"));
+    messageBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+    messageBox.setDefaultButton(QMessageBox::Yes);
+    if (messageBox.exec() == QMessageBox::Yes)
+    {
+        for (int i = 0; i < errors.size(); ++i)
+        {
+            DialogEditWrongFormula *dialog = new DialogEditWrongFormula(pattern, errors.at(i).toolId, this);
+            dialog->setWindowTitle(tr("Edit wrong formula"));
+            dialog->setFormula(errors.at(i).formula);
+            if (dialog->exec() == QDialog::Accepted)
+            {
+                doc->FixFormula(errors.at(i), dialog->getFormula());
+            }
+            delete dialog;
+        }
+    }
+#ifndef QT_NO_CURSOR
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+#endif
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void MainWindow::FullParseFile()
 {
@@ -1585,6 +1778,10 @@ void MainWindow::SetEnabledGUI(bool enabled)
         ui->actionSaveAs->setEnabled(enabled);
         ui->actionPattern_properties->setEnabled(enabled);
         ui->actionEdit_pattern_code->setEnabled(enabled);
+        ui->actionMemory_report->setEnabled(enabled);
+        ui->actionMeasurement_dependencies->setEnabled(enabled);
+        ui->actionCheck_gradation->setEnabled(enabled && qApp->patternType() == MeasurementsType::Standard);
+        ui->actionExport_grade_rules->setEnabled(enabled && qApp->patternType() == MeasurementsType::Standard);
         ui->actionZoomIn->setEnabled(enabled);
         ui->actionZoomOut->setEnabled(enabled);
         ui->actionArrowTool->setEnabled(enabled);
@@ -1749,6 +1946,10 @@ void MainWindow::SetEnableWidgets(bool enable)
     ui->actionHistory->setEnabled(enable);
     ui->actionPattern_properties->setEnabled(enable);
     ui->actionEdit_pattern_code->setEnabled(enable);
+    ui->actionMemory_report->setEnabled(enable);
+    ui->actionMeasurement_dependencies->setEnabled(enable);
+    ui->actionCheck_gradation->setEnabled(enable && qApp->patternType() == MeasurementsType::Standard);
+    ui->actionExport_grade_rules->setEnabled(enable && qApp->patternType() == MeasurementsType::Standard);
     ui->actionZoomIn->setEnabled(enable);
     ui->actionZoomOut->setEnabled(enable);
     ui->actionZoomFitBest->setEnabled(enable);
@@ -2167,6 +2368,14 @@ void MainWindow::CreateActions()
     connect(ui->actionEdit_pattern_code, &QAction::triggered, this, &MainWindow::EditPatternCode);
     connect(ui->actionCloseWindow, &QAction::triggered, this, &MainWindow::ResetWindow);
     ui->actionEdit_pattern_code->setEnabled(false);
+    connect(ui->actionMemory_report, &QAction::triggered, this, &MainWindow::MemoryReport);
+    ui->actionMemory_report->setEnabled(false);
+    connect(ui->actionMeasurement_dependencies, &QAction::triggered, this, &MainWindow::MeasurementDependencies);
+    ui->actionMeasurement_dependencies->setEnabled(false);
+    connect(ui->actionExport_grade_rules, &QAction::triggered, this, &MainWindow::ExportGradeRules);
+    ui->actionExport_grade_rules->setEnabled(false);
+    connect(ui->actionCheck_gradation, &QAction::triggered, this, &MainWindow::CheckGradation);
+    ui->actionCheck_gradation->setEnabled(false);
 
     //Actions for recent files loaded by a main window application.
     for (int i = 0; i < MaxRecentFiles; ++i)
@@ -2264,6 +2473,7 @@ void MainWindow::LoadPattern(const QString &fileName)
 #endif /*Q_OS_WIN32*/
 
     qApp->setOpeningPattern();//Begin opening file
+    Calculator::ClearFormulaCache();// Formulas of previous pattern are not needed anymore
     try
     {
         VDomDocument::ValidateXML("://schema/pattern.xsd", fileName);
@@ -30,6 +30,8 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QFutureWatcher>
+#include <QProgressDialog>
 #include "widgets/vmaingraphicsscene.h"
 #include "widgets/vmaingraphicsview.h"
 #include "widgets/vitem.h"
@@ -38,6 +40,8 @@
 #include "tools/vtooluniondetails.h"
 #include "tools/drawTools/drawtools.h"
 #include "xml/vdomdocument.h"
+#include "xml/vformulacheck.h"
+#include "xml/vpatternrecalculation.h"
 
 namespace Ui
 {
@@ -89,6 +93,7 @@ public slots:
     void               ChangedHeight(const QString & text);
 
     void               PatternWasModified(bool saved);
+    void               WrongFormulas(const QVector<VFormulaCheck> &errors);
 
     void               ToolEndLine(bool checked);
     void               ToolLine(bool checked);
@@ -123,6 +128,11 @@ public slots:
      * @brief Edit XML code of pattern
      */
     void               EditPatternCode();
+    void               MemoryReport();
+    void               MeasurementDependencies();
+    void               ExportGradeRules();
+    void               CheckGradation();
+    void               GradationChecked();
     void               FullParseFile();
     void               SetEnabledGUI(bool enabled);
     void               ClickEndVisualization();
@@ -205,6 +215,12 @@ private:
     QComboBox          *gradationSizes;
     VToolOptionsPropertyBrowser *toolOptions;
 
+    /** @brief gradationCheck watcher of running check of gradation, nullptr if there is no one. */
+    QFutureWatcher<VPatternGrade> *gradationCheck;
+
+    /** @brief gradationProgress progress of running check of gradation. */
+    QProgressDialog    *gradationProgress;
+
     void               ToolBarOption();
     void               ToolBarDraws();
     void               ToolBarTools();
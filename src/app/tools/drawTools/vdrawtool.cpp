@@ -35,6 +35,7 @@
 #include "../../undocommands/addtocalc.h"
 #include "../../undocommands/savetooloptions.h"
 #include "../../exception/vexceptionundo.h"
+#include <QThread>
 
 qreal VDrawTool::factor = 1;
 
@@ -202,7 +203,9 @@ void VDrawTool::SetFactor(qreal factor)
  * @brief CheckFormula check formula.
  *
  * Try calculate formula. If find error show dialog that allow user try fix formula. If user can't throw exception. In
- * successes case return result calculation and fixed formula string. If formula ok don't touch formula.
+ * successes case return result calculation and fixed formula string. If formula ok don't touch formula. Outside GUI
+ * thread, inside thread scope of recalculation or grading and for formula that user didn't fix from list of wrong
+ * formulas on opening error is thrown without dialog.
  *
  * @param toolId [in] tool's id.
  * @param formula [in|out] string with formula.
@@ -214,12 +217,9 @@ qreal VDrawTool::CheckFormula(const quint32 &toolId, QString &formula, VContaine
 {
     SCASSERT(data != nullptr)
     qreal result = 0;
-    Calculator *cal = nullptr;
     try
     {
-        cal = new Calculator(data);
-        result = cal->EvalFormula(formula);
-        delete cal;
+        result = Calculator::EvalFormula(data, formula);
     }
     catch (qmu::QmuParserError &e)
     {
@@ -229,7 +229,16 @@ qreal VDrawTool::CheckFormula(const quint32 &toolId, QString &formula, VContaine
                  << "Message:     " << e.GetMsg()  << "\n"
                  << "Expression:  " << e.GetExpr() << "\n"
                  << "--------------------------------------";
-        delete cal;
+
+        if (QThread::currentThread() != qApp->thread() || VContainer::IsThreadScope())
+        {// Recalculation and grading can't show dialogs. File will be parsed again on GUI thread.
+            throw;
+        }
+
+        if (qApp->getCurrentDocument() != nullptr && qApp->getCurrentDocument()->IsReportedFormula(toolId, formula))
+        {// User already saw this error in list of wrong formulas and didn't fix it
+            throw;
+        }
 
         DialogUndo *dialogUndo = new DialogUndo(qApp->getMainWindow());
         if (dialogUndo->exec() == QDialog::Accepted)
@@ -247,10 +256,7 @@ qreal VDrawTool::CheckFormula(const quint32 &toolId, QString &formula, VContaine
                     /* Need delete dialog here because parser in dialog don't allow use correct separator for parsing
                      * here. */
                     delete dialog;
-                    Calculator *cal1 = new Calculator(data);
-                    result = cal1->EvalFormula(formula);
-                    delete cal1; /* Here can be memory leak, but dialog already check this formula and probability
-                                  * very low. */
+                    result = Calculator::EvalFormula(data, formula);
                 }
                 else
                 {
@@ -108,7 +108,7 @@ VToolCurveIntersectAxis *VToolCurveIntersectAxis::Create(const quint32 _id, cons
     qreal angle = CheckFormula(_id, formulaAngle, data);
     const QSharedPointer<VAbstractCurve> curve = data->GeometricObject<VAbstractCurve>(curveId);
 
-    QPointF fPoint = FindPoint(basePoint->toQPointF(), angle, curve);
+    QPointF fPoint = FindPoint(basePoint->toQPointF(), angle, curve, doc->SceneRect());
     quint32 id = _id;
     if (typeCreation == Source::FromGui)
     {
@@ -143,9 +143,9 @@ VToolCurveIntersectAxis *VToolCurveIntersectAxis::Create(const quint32 _id, cons
 
 //---------------------------------------------------------------------------------------------------------------------
 QPointF VToolCurveIntersectAxis::FindPoint(const QPointF &point, qreal angle,
-                                           const QSharedPointer<VAbstractCurve> &curve)
+                                           const QSharedPointer<VAbstractCurve> &curve, const QRectF &sceneRect)
 {
-    QLineF axis = VGObject::BuildAxis(point, angle, qApp->getCurrentScene()->sceneRect());
+    QLineF axis = VGObject::BuildAxis(point, angle, sceneRect);
     QVector<QPointF> points = curve->IntersectLine(axis);
 
     if (points.size() > 0)
@@ -48,7 +48,8 @@ public:
                                            const qreal &mx, const qreal &my, VMainGraphicsScene  *scene, VPattern *doc,
                                            VContainer *data, const Document &parse, const Source &typeCreation);
 
-    static QPointF FindPoint(const QPointF &point, qreal angle, const QSharedPointer<VAbstractCurve> &curve);
+    static QPointF FindPoint(const QPointF &point, qreal angle, const QSharedPointer<VAbstractCurve> &curve,
+                             const QRectF &sceneRect);
 
     static const QString ToolType;
     virtual int       type() const {return Type;}
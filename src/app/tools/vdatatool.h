@@ -50,7 +50,7 @@ public:
     virtual void          incrementReferens();
     virtual void          decrementReferens();
 protected:
-    /** @brief data container with data */
+    /** @brief data container with data as it was after tool. Shares storage with global container and other tools. */
     VContainer            data;
 
     /** @brief _referens keep count tools what use this tool. If value more than 1 you can't delete tool. */
@@ -88,6 +88,7 @@ void MoveSplinePath::Do(const VSplinePath &splPath)
         doc->SetAttribute(domElement, VToolSplinePath::AttrKCurve, QString().setNum(splPath.getKCurve()));
         VToolSplinePath::UpdatePathPoint(doc, domElement, splPath);
 
+        doc->MarkToolDirty(nodeId);
         emit NeedLiteParsing(Document::LiteParse);
 
         QList<QGraphicsView*> list = scene->views();
@@ -103,6 +103,7 @@ void MoveSPoint::Do(double x, double y)
         doc->SetAttribute(domElement, VAbstractTool::AttrX, QString().setNum(qApp->fromPixel(x)));
         doc->SetAttribute(domElement, VAbstractTool::AttrY, QString().setNum(qApp->fromPixel(y)));
 
+        doc->MarkToolDirty(nodeId);
         emit NeedLiteParsing(Document::LitePPParse);
 
         QList<QGraphicsView*> list = scene->views();
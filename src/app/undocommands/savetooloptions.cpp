@@ -51,6 +51,7 @@ void SaveToolOptions::undo()
     {
         domElement.parentNode().replaceChild(oldXml, domElement);
 
+        doc->MarkToolDirty(nodeId);
         emit NeedLiteParsing(Document::LiteParse);
     }
     else
@@ -68,6 +69,7 @@ void SaveToolOptions::redo()
     {
         domElement.parentNode().replaceChild(newXml, domElement);
 
+        doc->MarkToolDirty(nodeId);
         emit NeedLiteParsing(Document::LiteParse);
     }
     else
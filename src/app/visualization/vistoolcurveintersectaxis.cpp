@@ -72,7 +72,8 @@ void VisToolCurveIntersectAxis::RefreshGeometry()
             DrawPoint(basePoint, first->toQPointF(), mainColor);
             DrawLine(axisLine, axis, supportColor, Qt::DashLine);
 
-            QPointF p = VToolCurveIntersectAxis::FindPoint(first->toQPointF(), axis.angle(), curve);
+            QPointF p = VToolCurveIntersectAxis::FindPoint(first->toQPointF(), axis.angle(), curve,
+                                                           qApp->getCurrentScene()->sceneRect());
             QLineF axis_line(first->toQPointF(), p);
             DrawLine(this, axis_line, mainColor, lineStyle);
 
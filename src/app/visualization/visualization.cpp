@@ -142,9 +142,7 @@ qreal Visualization::FindVal(const QString &expression)
             QString formula = expression;
             formula.replace("\n", " ");
             formula = qApp->FormulaFromUser(formula);
-            Calculator *cal = new Calculator(Visualization::data);
-            val = cal->EvalFormula(formula);
-            delete cal;
+            val = Calculator::EvalFormula(Visualization::data, formula);
         }
         catch (qmu::QmuParserError &e)
         {
@@ -0,0 +1,72 @@
+/************************************************************************
+ **
+ **  @file   vformulacheck.h
+ **  @author Roman Telezhynskyi <dismine(at)gmail.com>
+ **  @date   17 10, 2026
+ **
+ **  @brief
+ **  @copyright
+ **  This source code is part of the Valentine project, a pattern making
+ **  program, whose allow create and modeling patterns of clothing.
+ **  Copyright (C) 2014 Valentina project
+ **  <https://bitbucket.org/dismine/valentina> All Rights Reserved.
+ **
+ **  Valentina is free software: you can redistribute it and/or modify
+ **  it under the terms of the GNU General Public License as published by
+ **  the Free Software Foundation, either version 3 of the License, or
+ **  (at your option) any later version.
+ **
+ **  Valentina is distributed in the hope that it will be useful,
+ **  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **  GNU General Public License for more details.
+ **
+ **  You should have received a copy of the GNU General Public License
+ **  along with Valentina.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ *************************************************************************/
+
+#ifndef VFORMULACHECK_H
+#define VFORMULACHECK_H
+
+#include <QMap>
+#include <QString>
+
+class VContainer;
+
+/**
+ * @brief The VFormulaCheck struct describe check of one formula attribute of pattern file.
+ *
+ * All formulas of pattern are checked together when measurements and increments are loaded, so user gets all errors
+ * at once.
+ */
+struct VFormulaCheck
+{
+    VFormulaCheck()
+        :toolId(0), attribute(QString()), formula(QString()), data(nullptr), error(QString()), position(-1),
+          unbound(QMap<int, QString>())
+    {}
+
+    /** @brief toolId id of tool that owns formula. */
+    quint32           toolId;
+
+    /** @brief attribute name of attribute with formula. */
+    QString           attribute;
+
+    /** @brief formula string of formula in internal look. */
+    QString           formula;
+
+    /** @brief data container with measurements and increments. */
+    const VContainer *data;
+
+    /** @brief error message of parser, empty if formula is correct. */
+    QString           error;
+
+    /** @brief position position of error in formula. */
+    int               position;
+
+    /** @brief unbound names of variables that don't exist in container before parsing by position in formula. */
+    QMap<int, QString> unbound;
+};
+
+#endif // VFORMULACHECK_H
@@ -40,11 +40,14 @@
 #include "../core/undoevent.h"
 #include "vstandardmeasurements.h"
 #include "vindividualmeasurements.h"
+#include "vpatternrecalculation.h"
+#include "../container/calculator.h"
 #include "../../libs/qmuparser/qmuparsererror.h"
 #include "../geometry/varc.h"
 
 #include <QMessageBox>
 #include <QUndoStack>
+#include <QtConcurrent>
 #include <QtCore/qmath.h>
 
 const QString VPattern::TagPattern      = QStringLiteral("pattern");
@@ -122,7 +125,9 @@ VPattern::VPattern(VContainer *data, Draw *mode, VMainGraphicsScene *sceneDraw,
                    VMainGraphicsScene *sceneDetail, QObject *parent)
     : QObject(parent), VDomDocument(data), nameActivPP(QString()), tools(QHash<quint32, VDataTool*>()),
       history(QVector<VToolRecord>()), cursor(0), patternPieces(QStringList()), mode(mode), sceneDraw(sceneDraw),
-      sceneDetail(sceneDetail)
+      sceneDetail(sceneDetail), recalculation(nullptr), recalculationCanceled(), gradeCanceled(),
+      calculationOnly(false), calculatedData(), parallelPieces(false), sceneRect(), reportedFormulas(), objectOwners(),
+      ownersData()
 {
     SCASSERT(sceneDraw != nullptr);
     SCASSERT(sceneDetail != nullptr);
@@ -302,7 +307,14 @@ void VPattern::Parse(const Document &parse)
     SCASSERT(sceneDetail != nullptr);
     QStringList tags = QStringList() << TagDraw << TagIncrements << TagAuthor << TagDescription << TagNotes
                                         << TagMeasurements << TagVersion << TagGradation;
+    if (parse == Document::FullParse)
+    {
+        CancelRecalculation();// Full parsing makes result outdated
+        reportedFormulas.clear();
+    }
     PrepareForParse(parse);
+    bool validated = false;
+    QVector<QDomElement> pieces;
     QDomNode domNode = documentElement().firstChild();
     while (domNode.isNull() == false)
     {
@@ -314,6 +326,28 @@ void VPattern::Parse(const Document &parse)
                 switch (tags.indexOf(domElement.tagName()))
                 {
                     case 0: // TagDraw
+                        if (parse == Document::FullParse && qApp->getOpeningPattern() && validated == false)
+                        {// Increments go before pattern pieces, so all of them are already loaded
+                            validated = true;
+                            const QVector<VFormulaCheck> errors = ValidateFormulas();
+                            if (errors.isEmpty() == false)
+                            {
+                                emit WrongFormulas(errors);
+                            }
+                            for (int i = 0; i < errors.size(); ++i)
+                            {// Tools don't ask again about formulas that were not fixed from list
+                                const QDomElement tool = elementById(QString().setNum(errors.at(i).toolId));
+                                if (tool.attribute(errors.at(i).attribute) == errors.at(i).formula)
+                                {
+                                    reportedFormulas.insert(errors.at(i).toolId, errors.at(i).formula);
+                                }
+                            }
+                        }
+                        if (parallelPieces && parse == Document::LiteParse)
+                        {
+                            pieces.append(domElement);
+                            break;
+                        }
                         if (parse == Document::FullParse)
                         {
                             if (nameActivPP.isEmpty())
@@ -355,6 +389,16 @@ void VPattern::Parse(const Document &parse)
         }
         domNode = domNode.nextSibling();
     }
+    if (pieces.isEmpty() == false)
+    {
+        ParsePiecesConcurrently(pieces);
+    }
+    if (parse == Document::FullParse)
+    {// Graph is built on first incremental recalculation
+        dependents.clear();
+        dependencies.clear();
+        dependencyHistory.clear();
+    }
     emit CheckLayout();
 }
 
@@ -451,6 +495,7 @@ void VPattern::AddTool(const quint32 &id, VDataTool *tool)
     Q_ASSERT_X(id > 0, Q_FUNC_INFO, "id <= 0");
     SCASSERT(tool != nullptr);
     tools.insert(id, tool);
+    RecordToolObjects(id);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -463,12 +508,84 @@ void VPattern::UpdateToolData(const quint32 &id, VContainer *data)
 {
     Q_ASSERT_X(id > 0, Q_FUNC_INFO, "id <= 0");
     SCASSERT(data != nullptr);
+    if (calculationOnly)
+    {
+        calculatedData.insert(id, *data);
+        return;
+    }
     ToolExists(id);
     VDataTool *tool = tools.value(id);
     SCASSERT(tool != nullptr);
     tool->VDataTool::setData(data);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief MarkToolDirty mark tool as changed. Next lite parsing will try to recalculate only this tool and tools that
+ * depend on it.
+ * @param id tool id.
+ */
+void VPattern::MarkToolDirty(const quint32 &id)
+{
+    Q_ASSERT_X(id > 0, Q_FUNC_INFO, "id <= 0");
+    dirtyTools.insert(id);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IsRecalculating return true if pattern is being recalculated on worker thread.
+ */
+bool VPattern::IsRecalculating() const
+{
+    return recalculation != nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SceneRect return rect of current scene. Tools use it to build axis. Document for recalculation returns rect
+ * from snapshot, because worker thread must not touch scene.
+ */
+QRectF VPattern::SceneRect() const
+{
+    if (calculationOnly)
+    {
+        return sceneRect;
+    }
+    return qApp->getCurrentScene()->sceneRect();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief DataMemoryReport compare memory data sets of tools use with memory full copies of data sets would use.
+ * @return report.
+ */
+QString VPattern::DataMemoryReport() const
+{
+    QHash<const void *, int> storage;
+    qint64 copies = data->EntriesCount();
+    data->CollectStorage(storage);
+
+    QHash<quint32, VDataTool*>::const_iterator i = tools.constBegin();
+    while (i != tools.constEnd())
+    {
+        const VContainer toolData = i.value()->getData();
+        copies += toolData.EntriesCount();
+        toolData.CollectStorage(storage);
+        ++i;
+    }
+
+    qint64 stored = 0;
+    QHash<const void *, int>::const_iterator j = storage.constBegin();
+    while (j != storage.constEnd())
+    {
+        stored += j.value();
+        ++j;
+    }
+
+    return tr("Data sets: %1, entries in full copies: %2, stored entries: %3.").arg(tools.size() + 1)
+            .arg(copies).arg(stored);
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief IncrementReferens increment reference parent objects.
@@ -718,8 +835,31 @@ bool VPattern::SaveDocument(const QString &fileName, QString &error)
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief LiteParseTree lite parse file.
+ *
+ * Lite parsing of whole file runs on worker thread. If recalculation is already running its data is outdated, so we
+ * cancel it and start new one.
  */
 void VPattern::LiteParseTree(const Document &parse)
+{
+    const QSet<quint32> dirty = dirtyTools;
+    dirtyTools.clear();
+
+    if (IsRecalculating())
+    {
+        StartRecalculation();
+        return;
+    }
+    LiteParse(parse, dirty, true);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief LiteParse lite parse file and show errors.
+ * @param parse parser file mode.
+ * @param dirty ids of changed tools.
+ * @param inBackground true if lite parsing of whole file can run on worker thread.
+ */
+void VPattern::LiteParse(const Document &parse, const QSet<quint32> &dirty, bool inBackground)
 {
     // Save name current pattern piece
     QString namePP = nameActivPP;
@@ -730,10 +870,21 @@ void VPattern::LiteParseTree(const Document &parse)
         switch (parse)
         {
             case Document::LitePPParse:
-                ParseCurrentPP();
+                if (IncrementalParse(dirty) == false)
+                {
+                    ParseCurrentPP();
+                }
                 break;
             case Document::LiteParse:
-                Parse(parse);
+                if (IncrementalParse(dirty) == false)
+                {
+                    if (inBackground)
+                    {
+                        StartRecalculation();
+                        return;
+                    }
+                    Parse(parse);
+                }
                 break;
             case Document::FullParse:
                 qWarning()<<"Lite parsing doesn't support full parsing";
@@ -752,55 +903,1029 @@ void VPattern::LiteParseTree(const Document &parse)
     }
     catch (const VExceptionObjectError &e)
     {
-        e.CriticalMessageBox(tr("Error parsing file."), qApp->getMainWindow());
-        emit SetEnabledGUI(false);
-        return;
+        e.CriticalMessageBox(tr("Error parsing file."), qApp->getMainWindow());
+        emit SetEnabledGUI(false);
+        return;
+    }
+    catch (const VExceptionConversionError &e)
+    {
+        e.CriticalMessageBox(tr("Error can't convert value."), qApp->getMainWindow());
+        emit SetEnabledGUI(false);
+        return;
+    }
+    catch (const VExceptionEmptyParameter &e)
+    {
+        e.CriticalMessageBox(tr("Error empty parameter."), qApp->getMainWindow());
+        emit SetEnabledGUI(false);
+        return;
+    }
+    catch (const VExceptionWrongId &e)
+    {
+        e.CriticalMessageBox(tr("Error wrong id."), qApp->getMainWindow());
+        emit SetEnabledGUI(false);
+        return;
+    }
+    catch (VException &e)
+    {
+        e.CriticalMessageBox(tr("Error parsing file."), qApp->getMainWindow());
+        emit SetEnabledGUI(false);
+        return;
+    }
+    catch (const std::bad_alloc &)
+    {
+#ifndef QT_NO_CURSOR
+        QApplication::restoreOverrideCursor();
+#endif
+        QMessageBox::critical(qApp->getMainWindow(), tr("Critical error!"), tr("Error parsing file (std::bad_alloc)."),
+                              QMessageBox::Ok, QMessageBox::Ok);
+#ifndef QT_NO_CURSOR
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+#endif
+        emit SetEnabledGUI(false);
+        return;
+    }
+
+    // Restore name current pattern piece
+    nameActivPP = namePP;
+    RefreshScenes();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief RefreshScenes update tools from data after lite parsing.
+ */
+void VPattern::RefreshScenes()
+{
+    setCurrentData();
+    emit FullUpdateFromFile();
+    // Recalculate scene rect
+    VAbstractTool::NewSceneRect(sceneDraw, qApp->getSceneView());
+    VAbstractTool::NewSceneRect(sceneDetail, qApp->getSceneView());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief FormulaAttributes return names of attributes that keep formulas of tools.
+ */
+static QStringList FormulaAttributes()
+{
+    return QStringList() << VAbstractTool::AttrLength << VAbstractTool::AttrAngle << VAbstractTool::AttrRadius
+                         << VAbstractTool::AttrAngle1 << VAbstractTool::AttrAngle2;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief The VPatternGradeLane struct grades one combination of size and height, grading maps it over indexes of
+ * combinations.
+ */
+struct VPatternGradeLane
+{
+    typedef VPatternGrade result_type;
+
+    explicit VPatternGradeLane(const QSharedPointer<VPatternGradeTask> &task) : task(task) {}
+
+    VPatternGrade operator()(int lane) const
+    {
+        return VPattern::GradeCombination(task, lane);
+    }
+
+    QSharedPointer<VPatternGradeTask> task;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Grade start calculation of pattern for all combinations of enabled sizes and heights.
+ *
+ * All combinations share one snapshot of pattern and are lite parsed on thread pool. Formulas that depend only on
+ * measurements and increments are evaluated for all combinations at once before (see GradeFormulas()), combinations
+ * take their values from there. Pattern pieces of one combination are parsed sequentially, combinations already keep
+ * all threads busy. Running grading is canceled.
+ * @return future with result for each combination, sizes change slower than heights. Canceling future stops
+ * scheduling combinations, CancelGrade() stops running ones too. Empty if pattern uses individual measurements.
+ */
+QFuture<VPatternGrade> VPattern::Grade()
+{
+    CancelGrade();
+    if (MType() != MeasurementsType::Standard)
+    {
+        return QFuture<VPatternGrade>();
+    }
+
+    QSharedPointer<VPatternGradeTask> task(new VPatternGradeTask());
+    task->snapshot = RecalculationTask();
+    gradeCanceled = task->snapshot.canceled;
+
+    const QStringList sizes = VMeasurement::ListSizes(GetGradationSizes());
+    const QStringList heights = VMeasurement::ListHeights(GetGradationHeights());
+    QVector<int> lanes;
+    for (int i = 0; i < sizes.size(); ++i)
+    {
+        for (int j = 0; j < heights.size(); ++j)
+        {
+            lanes.append(task->sizes.size());
+            task->sizes.append(sizes.at(i).toInt());
+            task->heights.append(heights.at(j).toInt());
+        }
+    }
+    task->lanes = GradeFormulas(task->sizes, task->heights);
+
+    return QtConcurrent::mapped(lanes, VPatternGradeLane(task));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CancelGrade ask running grading to stop.
+ */
+void VPattern::CancelGrade()
+{
+    if (gradeCanceled.isNull() == false)
+    {
+        gradeCanceled->store(1);
+        gradeCanceled.clear();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief GradeFormulas evaluate formulas of tools that depend only on measurements and increments for all combinations
+ * of size and height in bulk.
+ *
+ * Formulas with errors or with variables of tools are skipped, each combination evaluates them itself.
+ * @param sizes size of each combination.
+ * @param heights height of each combination.
+ * @return values of formulas for each combination by formula.
+ */
+QHash<QString, QVector<qreal> > VPattern::GradeFormulas(const QVector<qreal> &sizes,
+                                                       const QVector<qreal> &heights) const
+{
+    const QStringList attributes = FormulaAttributes();
+    QVector<QDomElement> elements;
+    const QDomNodeList draws = elementsByTagName(TagDraw);
+    for (int i = 0; i < draws.size(); ++i)
+    {
+        CollectElements(draws.at(i).toElement(), elements);
+    }
+
+    QHash<QString, QVector<qreal> > values;
+    QSet<QString> skipped;
+    for (int i = 0; i < elements.size(); ++i)
+    {
+        for (int j = 0; j < attributes.size(); ++j)
+        {
+            const QString formula = elements.at(i).attribute(attributes.at(j));
+            if (formula.isEmpty() || values.contains(formula) || skipped.contains(formula))
+            {
+                continue;
+            }
+
+            try
+            {
+                const QVector<qreal> lanes = Calculator::EvalLanes(data, formula, sizes, heights);
+                if (lanes.isEmpty())
+                {
+                    skipped.insert(formula);
+                }
+                else
+                {
+                    values.insert(formula, lanes);
+                }
+            }
+            catch (const qmu::QmuParserError &e)
+            {
+                Q_UNUSED(e);
+                skipped.insert(formula);
+            }
+        }
+    }
+    return values;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ToolLabel return name of point that tool creates or id of tool if tool has no name.
+ * @param domElement tag of tool.
+ */
+static QString ToolLabel(const QDomElement &domElement)
+{
+    const QString name = domElement.attribute(VAbstractTool::AttrName);
+    if (name.isEmpty())
+    {
+        return VPattern::tr("Tool %1").arg(domElement.attribute(VDomDocument::AttrId));
+    }
+    return name;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SensitivityReport show how formulas of tools depend on measurements, increments, size and height.
+ *
+ * Each line says how much value of formula changes when variable grows by one unit. Only variables formula uses
+ * directly are shown, objects of other tools are taken as they are.
+ * @return one line for each variable of each formula in file order.
+ */
+QStringList VPattern::SensitivityReport() const
+{
+    const QStringList attributes = FormulaAttributes();
+    QVector<QDomElement> elements;
+    const QDomNodeList draws = elementsByTagName(TagDraw);
+    for (int i = 0; i < draws.size(); ++i)
+    {
+        CollectElements(draws.at(i).toElement(), elements);
+    }
+
+    QStringList report;
+    for (int i = 0; i < elements.size(); ++i)
+    {
+        for (int j = 0; j < attributes.size(); ++j)
+        {
+            if (elements.at(i).hasAttribute(attributes.at(j)) == false)
+            {
+                continue;
+            }
+
+            QMap<quint32, qreal> sensitivity;
+            try
+            {
+                sensitivity = Calculator::EvalSensitivity(data, elements.at(i).attribute(attributes.at(j)));
+            }
+            catch (const qmu::QmuParserError &e)
+            {
+                Q_UNUSED(e);
+                continue;
+            }
+
+            QMap<quint32, qreal>::const_iterator it = sensitivity.constBegin();
+            for (; it != sensitivity.constEnd(); ++it)
+            {
+                report.append(tr("%1, %2: %3 changes by %4").arg(ToolLabel(elements.at(i))).arg(attributes.at(j))
+                              .arg(qApp->VarToUser(VNameTable::Name(it.key()))).arg(it.value()));
+            }
+        }
+    }
+    return report;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief GradeRules calculate grade rule of each formula of tools: how much its value changes from one size or height
+ * of gradation to next one.
+ *
+ * Formulas are evaluated over dual numbers, so one pass gives value and both rules. Rules are zero for pattern with
+ * individual measurements.
+ * @return rows of comma-separated table with header in first row.
+ */
+QStringList VPattern::GradeRules() const
+{
+    const QStringList attributes = FormulaAttributes();
+    QVector<QDomElement> elements;
+    const QDomNodeList draws = elementsByTagName(TagDraw);
+    for (int i = 0; i < draws.size(); ++i)
+    {
+        CollectElements(draws.at(i).toElement(), elements);
+    }
+
+    const qreal sizeStep = VAbstractMeasurements::UnitConvertor(2.0, Unit::Cm, qApp->patternUnit());
+    const qreal heightStep = VAbstractMeasurements::UnitConvertor(6.0, Unit::Cm, qApp->patternUnit());
+
+    QStringList rules;
+    rules.append(tr("Tool,Attribute,Value,Size rule,Height rule"));
+    for (int i = 0; i < elements.size(); ++i)
+    {
+        for (int j = 0; j < attributes.size(); ++j)
+        {
+            if (elements.at(i).hasAttribute(attributes.at(j)) == false)
+            {
+                continue;
+            }
+
+            qmu::QmuDual dual;
+            try
+            {
+                dual = Calculator::EvalDual(data, elements.at(i).attribute(attributes.at(j)));
+            }
+            catch (const qmu::QmuParserError &e)
+            {
+                Q_UNUSED(e);
+                continue;
+            }
+
+            rules.append(QString("%1,%2,%3,%4,%5").arg(ToolLabel(elements.at(i))).arg(attributes.at(j))
+                         .arg(dual.Val).arg(dual.Grad[0] * sizeStep).arg(dual.Grad[1] * heightStep));
+        }
+    }
+    return rules;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief The VToolNames struct keep objects of tools while formulas of pattern are validated.
+ *
+ * Objects have only names, their geometry is not calculated. Variables get names from the same classes that container
+ * uses (VLengthLine, VLineAngle and names of curves), so they are named exactly like after parsing.
+ */
+struct VToolNames
+{
+    VToolNames() : points(), curves(), variables() {}
+    QHash<quint32, VPointF> points;
+    QHash<quint32, QSharedPointer<VAbstractCurve> > curves;
+    QSet<QString> variables;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+static quint32 AttributeId(const QDomElement &domElement, const QString &name)
+{
+    return domElement.attribute(name).toUInt();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief AddLineNames add variables of line like VContainer::AddLine() does.
+ */
+static void AddLineNames(VToolNames &names, const quint32 &firstPointId, const quint32 &secondPointId)
+{
+    if (names.points.contains(firstPointId) == false || names.points.contains(secondPointId) == false)
+    {
+        return;
+    }
+    const VPointF first = names.points.value(firstPointId);
+    const VPointF second = names.points.value(secondPointId);
+    names.variables.insert(VLengthLine(&first, firstPointId, &second, secondPointId).GetName());
+    names.variables.insert(VLineAngle(&first, firstPointId, &second, secondPointId).GetName());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief AddCurveName add curve and its length like tools do with VContainer::AddCurveLength().
+ */
+static void AddCurveName(VToolNames &names, const quint32 &id, VAbstractCurve *curve)
+{
+    curve->setId(id);// Arc keeps id in name
+    names.curves.insert(id, QSharedPointer<VAbstractCurve>(curve));
+    names.variables.insert(curve->name());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CurveEnds return first and last points of spline or spline path.
+ * @return false if there is no such curve.
+ */
+static bool CurveEnds(const VToolNames &names, const quint32 &id, VPointF &first, VPointF &last)
+{
+    const QSharedPointer<VAbstractCurve> curve = names.curves.value(id);
+    if (curve.isNull())
+    {
+        return false;
+    }
+    if (curve->getType() == GOType::Spline)
+    {
+        const VSpline *spl = static_cast<const VSpline *>(curve.data());
+        first = spl->GetP1();
+        last = spl->GetP4();
+        return true;
+    }
+    if (curve->getType() == GOType::SplinePath)
+    {
+        const VSplinePath *splPath = static_cast<const VSplinePath *>(curve.data());
+        if (splPath->CountPoint() == 0)
+        {
+            return false;
+        }
+        first = splPath->at(0).P();
+        last = splPath->at(splPath->CountPoint() - 1).P();
+        return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief PartOfPath return spline path with ends of part of cut spline path, only ends give name to path.
+ */
+static VSplinePath *PartOfPath(const VPointF &first, const VPointF &last)
+{
+    VSplinePath *splPath = new VSplinePath();
+    splPath->append(VSplinePoint(first, 1, 0, 1, 0));
+    splPath->append(VSplinePoint(last, 1, 0, 1, 0));
+    return splPath;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief AddToolNames add objects and variables that tool creates.
+ *
+ * Follows what Create() of each tool adds to container. Cut tools keep their curves with ids after id of point.
+ * @param domElement element of tool.
+ * @param names objects and variables of tools that go before.
+ */
+static void AddToolNames(const QDomElement &domElement, VToolNames &names)
+{
+    const quint32 id = AttributeId(domElement, VDomDocument::AttrId);
+    const QString type = domElement.attribute(VAbstractTool::AttrType);
+    if (domElement.tagName() == VPattern::TagPoint)
+    {
+        const VPointF point(0, 0, domElement.attribute(VAbstractTool::AttrName), 0, 0);
+        if (type == VNodePoint::ToolType)
+        {
+            names.points.insert(id, names.points.value(AttributeId(domElement, VAbstractNode::AttrIdObject)));
+            return;
+        }
+        names.points.insert(id, point);
+
+        const QStringList types = QStringList() << VToolEndLine::ToolType << VToolAlongLine::ToolType
+                                                << VToolShoulderPoint::ToolType << VToolNormal::ToolType
+                                                << VToolBisector::ToolType << VToolLineIntersect::ToolType
+                                                << VToolPointOfContact::ToolType << VToolHeight::ToolType
+                                                << VToolCutSpline::ToolType << VToolCutSplinePath::ToolType
+                                                << VToolCutArc::ToolType << VToolLineIntersectAxis::ToolType
+                                                << VToolCurveIntersectAxis::ToolType;
+        switch (types.indexOf(type))
+        {
+            case 0: //VToolEndLine::ToolType
+            case 12: //VToolCurveIntersectAxis::ToolType
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrBasePoint), id);
+                break;
+            case 1: //VToolAlongLine::ToolType
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrFirstPoint), id);
+                AddLineNames(names, id, AttributeId(domElement, VAbstractTool::AttrSecondPoint));
+                break;
+            case 2: //VToolShoulderPoint::ToolType
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrP1Line), id);
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrP2Line), id);
+                break;
+            case 3: //VToolNormal::ToolType
+            case 4: //VToolBisector::ToolType
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrFirstPoint), id);
+                break;
+            case 5: //VToolLineIntersect::ToolType
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrP1Line1), id);
+                AddLineNames(names, id, AttributeId(domElement, VAbstractTool::AttrP2Line1));
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrP1Line2), id);
+                AddLineNames(names, id, AttributeId(domElement, VAbstractTool::AttrP2Line2));
+                break;
+            case 6: //VToolPointOfContact::ToolType
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrFirstPoint), id);
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrSecondPoint), id);
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrCenter), id);
+                break;
+            case 7: //VToolHeight::ToolType
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrBasePoint), id);
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrP1Line), id);
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrP2Line), id);
+                break;
+            case 8: //VToolCutSpline::ToolType
+            {
+                VPointF first;
+                VPointF last;
+                if (CurveEnds(names, AttributeId(domElement, VToolCutSpline::AttrSpline), first, last))
+                {
+                    AddCurveName(names, id + 1, new VSpline(first, first.toQPointF(), point.toQPointF(), point, 1));
+                    AddCurveName(names, id + 2, new VSpline(point, point.toQPointF(), last.toQPointF(), last, 1));
+                }
+                break;
+            }
+            case 9: //VToolCutSplinePath::ToolType
+            {
+                VPointF first;
+                VPointF last;
+                if (CurveEnds(names, AttributeId(domElement, VToolCutSplinePath::AttrSplinePath), first, last))
+                {
+                    AddCurveName(names, id + 1, PartOfPath(first, point));
+                    AddCurveName(names, id + 2, PartOfPath(point, last));
+                }
+                break;
+            }
+            case 10: //VToolCutArc::ToolType
+            {
+                const QSharedPointer<VAbstractCurve> arc = names.curves.value(AttributeId(domElement,
+                                                                                          VToolCutArc::AttrArc));
+                if (arc.isNull() == false && arc->getType() == GOType::Arc)
+                {
+                    const VPointF center = static_cast<const VArc *>(arc.data())->GetCenter();
+                    AddCurveName(names, id + 1, new VArc(center, 0, 0, 0));
+                    AddCurveName(names, id + 2, new VArc(center, 0, 0, 0));
+                }
+                break;
+            }
+            case 11: //VToolLineIntersectAxis::ToolType
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrBasePoint), id);
+                AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrP1Line), id);
+                AddLineNames(names, id, AttributeId(domElement, VAbstractTool::AttrP2Line));
+                break;
+            default:
+                break;
+        }
+    }
+    else if (domElement.tagName() == VPattern::TagLine)
+    {
+        AddLineNames(names, AttributeId(domElement, VAbstractTool::AttrFirstPoint),
+                     AttributeId(domElement, VAbstractTool::AttrSecondPoint));
+    }
+    else if (domElement.tagName() == VPattern::TagSpline && type == VToolSpline::ToolType)
+    {
+        const quint32 point1 = AttributeId(domElement, VAbstractTool::AttrPoint1);
+        const quint32 point4 = AttributeId(domElement, VAbstractTool::AttrPoint4);
+        if (names.points.contains(point1) && names.points.contains(point4))
+        {
+            const VPointF p1 = names.points.value(point1);
+            const VPointF p4 = names.points.value(point4);
+            AddCurveName(names, id, new VSpline(p1, p1.toQPointF(), p4.toQPointF(), p4, 1));
+        }
+    }
+    else if (domElement.tagName() == VPattern::TagSpline && type == VToolSplinePath::ToolType)
+    {
+        VSplinePath *splPath = new VSplinePath();
+        QDomElement element = domElement.firstChildElement(VAbstractTool::AttrPathPoint);
+        while (element.isNull() == false)
+        {
+            const VPointF p = names.points.value(AttributeId(element, VAbstractTool::AttrPSpline));
+            splPath->append(VSplinePoint(p, 1, 0, 1, 0));
+            element = element.nextSiblingElement(VAbstractTool::AttrPathPoint);
+        }
+        AddCurveName(names, id, splPath);
+    }
+    else if (domElement.tagName() == VPattern::TagArc && type == VToolArc::ToolType)
+    {
+        const quint32 center = AttributeId(domElement, VAbstractTool::AttrCenter);
+        if (names.points.contains(center))
+        {
+            AddCurveName(names, id, new VArc(names.points.value(center), 0, 0, 0));
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ValidateFormulas check all formulas of pattern in one run before parsing of pattern pieces.
+ *
+ * Called when measurements and increments are already loaded. Formulas are checked on thread pool. Variables that
+ * don't exist yet are accepted only if tool that goes before in file creates them, names of lines and curves are built
+ * the same way as container builds them. Formulas that use only measurements and increments are already compiled when
+ * tools are created.
+ * @return checks of formulas with errors.
+ */
+QVector<VFormulaCheck> VPattern::ValidateFormulas() const
+{
+    const QStringList attributes = FormulaAttributes();
+    QVector<QDomElement> elements;
+    const QDomNodeList draws = elementsByTagName(TagDraw);
+    for (int i = 0; i < draws.size(); ++i)
+    {
+        CollectElements(draws.at(i).toElement(), elements);
+    }
+
+    QVector<VFormulaCheck> checks;
+    QVector<int> owners;
+    for (int i = 0; i < elements.size(); ++i)
+    {
+        for (int j = 0; j < attributes.size(); ++j)
+        {
+            if (elements.at(i).hasAttribute(attributes.at(j)))
+            {
+                VFormulaCheck check;
+                check.toolId = elements.at(i).attribute(AttrId).toUInt();
+                check.attribute = attributes.at(j);
+                check.formula = elements.at(i).attribute(attributes.at(j));
+                check.data = data;
+                checks.append(check);
+                owners.append(i);
+            }
+        }
+    }
+
+    QtConcurrent::blockingMap(checks, &VPattern::CheckFormula);
+
+    QVector<VFormulaCheck> errors;
+    VToolNames names;
+    int next = 0;
+    for (int i = 0; i < elements.size(); ++i)
+    {
+        for (; next < checks.size() && owners.at(next) == i; ++next)
+        {
+            VFormulaCheck &check = checks[next];
+            QMap<int, QString>::const_iterator it = check.unbound.constBegin();
+            for (; check.error.isEmpty() && it != check.unbound.constEnd(); ++it)
+            {
+                if (names.variables.contains(it.value()) == false)
+                {
+                    check.error = tr("Unknown variable %1").arg(qApp->VarToUser(it.value()));
+                    check.position = it.key();
+                }
+            }
+
+            if (check.error.isEmpty() == false)
+            {
+                errors.append(check);
+            }
+        }
+        AddToolNames(elements.at(i), names);// Tool's own variables are not available for its formulas
+    }
+    return errors;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief FixFormula replace wrong formula in file by formula that user fixed.
+ * @param check failed check of formula.
+ * @param formula fixed formula in internal look.
+ */
+void VPattern::FixFormula(const VFormulaCheck &check, const QString &formula)
+{
+    QDomElement domElement = elementById(QString().setNum(check.toolId));
+    if (domElement.isElement())
+    {
+        SetAttribute(domElement, check.attribute, formula);
+        haveLiteChange();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IsReportedFormula check if user already saw error of formula in list of wrong formulas on opening.
+ * @param toolId id of tool.
+ * @param formula formula in internal look.
+ * @return true if tool must not ask user to fix formula again.
+ */
+bool VPattern::IsReportedFormula(const quint32 &toolId, const QString &formula) const
+{
+    return reportedFormulas.contains(toolId, formula);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CollectElements collect all children of element in file order.
+ * @param element element of pattern piece.
+ * @param elements list of elements.
+ */
+void VPattern::CollectElements(const QDomElement &element, QVector<QDomElement> &elements)
+{
+    QDomElement child = element.firstChildElement();
+    while (child.isNull() == false)
+    {
+        elements.append(child);
+        CollectElements(child, elements);
+        child = child.nextSiblingElement();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CheckFormula check one formula. Runs on thread from pool.
+ *
+ * Measurements are taken for size and height of current thread, so shared variables are not changed.
+ * @param check formula to check, gets error message and position or names of variables that don't exist yet.
+ */
+void VPattern::CheckFormula(VFormulaCheck &check)
+{
+    SCASSERT(check.data != nullptr);
+    VContainer::SetThreadGradation(check.data->size(), check.data->height());
+    try
+    {
+        check.unbound = Calculator::CompileFormula(check.data, check.formula);
+    }
+    catch (const qmu::QmuParserError &e)
+    {
+        check.error = e.GetMsg();
+        check.position = e.GetPos();
+    }
+    VContainer::ClearThreadGradation();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief RecalculationTask make snapshot of pattern for lite parsing on worker thread.
+ * @return task with deep copy of document.
+ */
+VPatternRecalculation VPattern::RecalculationTask() const
+{
+    VPatternRecalculation task;
+    task.document = cloneNode(true).toDocument();
+    task.data = *data;
+    task.history = history;
+    task.patternPieces = patternPieces;
+    task.nameActivPP = nameActivPP;
+    task.cursor = cursor;
+    task.mode = *mode;
+    task.sceneDraw = sceneDraw;
+    task.sceneDetail = sceneDetail;
+    task.sceneRect = SceneRect();
+    task.lastId = VContainer::getId();
+    task.uniqueNames = VContainer::UniqueNames();
+    task.canceled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    return task;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief StartRecalculation start lite parsing of snapshot of pattern on worker thread.
+ *
+ * Running recalculation gets canceled. Result will be handed back to GUI thread in RecalculationFinished().
+ */
+void VPattern::StartRecalculation()
+{
+    CancelRecalculation();
+
+    VPatternRecalculation task = RecalculationTask();
+    task.independentPieces = PiecesAreIndependent();
+    recalculationCanceled = task.canceled;
+
+    recalculation = new QFutureWatcher<VPatternRecalculation>(this);
+    connect(recalculation, &QFutureWatcherBase::finished, this, &VPattern::RecalculationFinished);
+    recalculation->setFuture(QtConcurrent::run(&VPattern::Recalculate, task));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CancelRecalculation ask running recalculation to stop. Its result will be ignored.
+ */
+void VPattern::CancelRecalculation()
+{
+    if (recalculationCanceled.isNull() == false)
+    {
+        recalculationCanceled->store(1);
+        recalculationCanceled.clear();
+    }
+    recalculation = nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Recalculate lite parse snapshot of pattern. Runs on worker thread.
+ *
+ * Document for recalculation doesn't have tools, data sets of tools are collected and returned with result.
+ * @param task snapshot of pattern.
+ * @return result of recalculation.
+ */
+VPatternRecalculation VPattern::Recalculate(VPatternRecalculation task)
+{
+    VContainer::BeginThreadScope(task.lastId, task.uniqueNames);
+    {
+        VPattern doc(&task.data, &task.mode, task.sceneDraw, task.sceneDetail);
+        doc.SetRecalculationTask(task);
+
+        // Don't show errors here. GUI thread will parse file again and show them.
+        try
+        {
+            doc.Parse(Document::LiteParse);
+            task.success = true;
+        }
+        catch (const VException &e)
+        {
+            Q_UNUSED(e);
+        }
+        catch (const qmu::QmuParserError &e)
+        {
+            Q_UNUSED(e);
+        }
+        catch (const std::bad_alloc &)
+        {
+            task.data = VContainer();
+        }
+        task.toolData = doc.calculatedData;
+    }
+    VContainer::EndThreadScope(task.finalId, task.uniqueNames);
+    task.document = QDomDocument();
+    return task;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief GradeCombination lite parse snapshot of pattern for one size and height. Runs on thread from pool.
+ *
+ * Recalculation runs in own thread scope, so wrong formula throws instead of showing dialog and id counter and unique
+ * names of pattern are not changed. Formulas evaluated in bulk take value of this combination.
+ * @param task snapshot of pattern shared by all combinations.
+ * @param lane index of combination.
+ * @return status of combination.
+ */
+VPatternGrade VPattern::GradeCombination(const QSharedPointer<VPatternGradeTask> &task, int lane)
+{
+    VPatternRecalculation recalculation = task->snapshot;
+    {
+        QMutexLocker locker(&task->mutex);
+        if (task->documents.isEmpty())
+        {
+            recalculation.document = task->snapshot.document.cloneNode(true).toDocument();
+        }
+        else
+        {
+            recalculation.document = task->documents.takeLast();
+        }
+    }
+    const QDomDocument document = recalculation.document;// Lite parsing doesn't change document
+
+    VPatternGrade grade;
+    grade.size = task->sizes.at(lane);
+    grade.height = task->heights.at(lane);
+
+    VContainer::SetThreadGradation(grade.size, grade.height);
+    Calculator::SetThreadLane(&task->lanes, lane);
+    grade.success = Recalculate(recalculation).success;
+    Calculator::ClearThreadLane();
+    VContainer::ClearThreadGradation();
+
+    QMutexLocker locker(&task->mutex);
+    task->documents.append(document);
+    return grade;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief RecalculatePiece lite parse one pattern piece. Runs on thread from pool.
+ * @param piece snapshot of pattern with document that contains only this piece.
+ */
+void VPattern::RecalculatePiece(VPatternRecalculation &piece)
+{
+    VContainer::BeginThreadScope(piece.lastId, piece.uniqueNames);
+    {
+        VPattern doc(&piece.data, &piece.mode, piece.sceneDraw, piece.sceneDetail);
+        doc.SetRecalculationTask(piece);
+        try
+        {
+            doc.ParseDrawElement(doc.documentElement().firstChild(), Document::LiteParse);
+            piece.success = true;
+        }
+        catch (const VException &e)
+        {
+            Q_UNUSED(e);
+        }
+        catch (const qmu::QmuParserError &e)
+        {
+            Q_UNUSED(e);
+        }
+        catch (const std::bad_alloc &)
+        {
+            piece.data = VContainer();
+        }
+        piece.toolData = doc.calculatedData;
+    }
+    VContainer::EndThreadScope(piece.finalId, piece.uniqueNames);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SetRecalculationTask make document copy for recalculation from snapshot of pattern.
+ * @param task snapshot of pattern.
+ */
+void VPattern::SetRecalculationTask(const VPatternRecalculation &task)
+{
+    static_cast<QDomDocument &>(*this) = task.document;
+    calculationOnly = true;
+    parallelPieces = task.independentPieces;
+    sceneRect = task.sceneRect;
+    recalculationCanceled = task.canceled;
+    history = task.history;
+    patternPieces = task.patternPieces;
+    nameActivPP = task.nameActivPP;
+    cursor = task.cursor;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief PiecesAreIndependent check if tools of each pattern piece use only objects of the same piece.
+ * @return true if there are several pattern pieces and they can be recalculated concurrently.
+ */
+bool VPattern::PiecesAreIndependent()
+{
+    if (patternPieces.size() < 2)
+    {
+        return false;
+    }
+
+    if (dependencyHistory != history)
+    {
+        BuildDependencyGraph();
+    }
+
+    QHash<quint32, QString> pieceOfTool;
+    for (qint32 i = 0; i < history.size(); ++i)
+    {
+        pieceOfTool.insert(history.at(i).getId(), history.at(i).getNameDraw());
+    }
+
+    QHash<quint32, QSet<quint32> >::const_iterator i = dependencies.constBegin();
+    while (i != dependencies.constEnd())
+    {
+        const QString piece = pieceOfTool.value(i.key());
+        QSet<quint32>::const_iterator j = i.value().constBegin();
+        while (j != i.value().constEnd())
+        {
+            if (pieceOfTool.value(*j) != piece)
+            {
+                return false;
+            }
+            ++j;
+        }
+        ++i;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ParsePiecesConcurrently lite parse pattern pieces on thread pool and merge results into data container.
+ *
+ * Each piece gets own copy of data container, id counter, unique names and own document with copy of its draw tag.
+ * Pieces share only measurements and increments, those are parsed before.
+ * @param elements draw tags of pattern pieces.
+ */
+void VPattern::ParsePiecesConcurrently(const QVector<QDomElement> &elements)
+{
+    QVector<VPatternRecalculation> pieces;
+    for (qint32 i = 0; i < elements.size(); ++i)
+    {
+        VPatternRecalculation piece;
+        QDomElement root = piece.document.createElement(TagPattern);
+        piece.document.appendChild(root);
+        root.appendChild(piece.document.importNode(elements.at(i), true));
+        piece.data = *data;
+        piece.history = history;
+        piece.patternPieces = patternPieces;
+        piece.nameActivPP = GetParametrString(elements.at(i), AttrName);
+        piece.cursor = cursor;
+        piece.mode = *mode;
+        piece.sceneDraw = sceneDraw;
+        piece.sceneDetail = sceneDetail;
+        piece.sceneRect = sceneRect;
+        piece.lastId = VContainer::getId();
+        piece.uniqueNames = VContainer::UniqueNames();
+        piece.canceled = recalculationCanceled;
+        pieces.append(piece);
     }
-    catch (const VExceptionConversionError &e)
+
+    QtConcurrent::blockingMap(pieces, &VPattern::RecalculatePiece);
+
+    const VContainer base = *data;
+    QSet<quint32> uniqueNames = VContainer::UniqueNames();
+    for (qint32 i = 0; i < pieces.size(); ++i)
     {
-        e.CriticalMessageBox(tr("Error can't convert value."), qApp->getMainWindow());
-        emit SetEnabledGUI(false);
-        return;
+        const VPatternRecalculation &piece = pieces.at(i);
+        if (piece.success == false)
+        {
+            throw VException(tr("Error parsing pattern piece %1.").arg(piece.nameActivPP));
+        }
+        data->MergeChanges(base, piece.data);
+        VContainer::UpdateId(piece.finalId);
+        uniqueNames.unite(piece.uniqueNames);
+
+        QHash<quint32, VContainer>::const_iterator j = piece.toolData.constBegin();
+        while (j != piece.toolData.constEnd())
+        {
+            if (piece.data.DataDetails()->contains(j.key()))
+            {
+                data->UpdateDetail(j.key(), piece.data.GetDetail(j.key()));
+            }
+            calculatedData.insert(j.key(), j.value());
+            ++j;
+        }
     }
-    catch (const VExceptionEmptyParameter &e)
+    VContainer::SetUniqueNames(uniqueNames);
+    nameActivPP = pieces.last().nameActivPP;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief RecalculationFinished apply result of recalculation and update tools in one batch.
+ *
+ * If recalculation failed we parse file on GUI thread, it will show error and allow user fix wrong formula.
+ */
+void VPattern::RecalculationFinished()
+{
+    QFutureWatcher<VPatternRecalculation> *watcher = static_cast<QFutureWatcher<VPatternRecalculation> *>(sender());
+    SCASSERT(watcher != nullptr);
+    watcher->deleteLater();
+    if (watcher != recalculation)
     {
-        e.CriticalMessageBox(tr("Error empty parameter."), qApp->getMainWindow());
-        emit SetEnabledGUI(false);
-        return;
+        return;// Canceled
     }
-    catch (const VExceptionWrongId &e)
-    {
-        e.CriticalMessageBox(tr("Error wrong id."), qApp->getMainWindow());
-        emit SetEnabledGUI(false);
+    recalculation = nullptr;
+    recalculationCanceled.clear();
+
+    const VPatternRecalculation result = watcher->result();
+    if (result.history != history || result.lastId != VContainer::getId())
+    {// Tool was added while we were recalculating
+        StartRecalculation();
         return;
     }
-    catch (VException &e)
+
+    if (result.success == false)
     {
-        e.CriticalMessageBox(tr("Error parsing file."), qApp->getMainWindow());
-        emit SetEnabledGUI(false);
+        LiteParse(Document::LiteParse, QSet<quint32>(), false);
         return;
     }
-    catch (const std::bad_alloc &)
+
+    *data = result.data;
+    VContainer::SetUniqueNames(result.uniqueNames);
+    VContainer::UpdateId(result.finalId);
+    QHash<quint32, VContainer>::const_iterator i = result.toolData.constBegin();
+    while (i != result.toolData.constEnd())
     {
-#ifndef QT_NO_CURSOR
-        QApplication::restoreOverrideCursor();
-#endif
-        QMessageBox::critical(qApp->getMainWindow(), tr("Critical error!"), tr("Error parsing file (std::bad_alloc)."),
-                              QMessageBox::Ok, QMessageBox::Ok);
-#ifndef QT_NO_CURSOR
-        QApplication::setOverrideCursor(Qt::WaitCursor);
-#endif
-        emit SetEnabledGUI(false);
-        return;
+        if (tools.contains(i.key()))
+        {
+            tools.value(i.key())->VDataTool::setData(&i.value());
+        }
+        ++i;
     }
-
-    // Restore name current pattern piece
-    nameActivPP = namePP;
-    setCurrentData();
-    emit FullUpdateFromFile();
-    // Recalculate scene rect
-    VAbstractTool::NewSceneRect(sceneDraw, qApp->getSceneView());
-    VAbstractTool::NewSceneRect(sceneDetail, qApp->getSceneView());
+    RefreshScenes();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -853,6 +1978,7 @@ void VPattern::customEvent(QEvent *event)
  */
 void VPattern::ParseDrawElement(const QDomNode &node, const Document &parse)
 {
+    VFormulaSweep sweep;// Formulas of pattern piece share subexpressions of measurements
     QStringList tags = QStringList() << TagCalculation << TagModeling << TagDetails;
     QDomNode domNode = node.firstChild();
     while (domNode.isNull() == false)
@@ -904,39 +2030,55 @@ void VPattern::ParseDrawMode(const QDomNode &node, const Document &parse, const
     {
         scene = sceneDetail;
     }
-    QStringList tags = QStringList() << TagPoint << TagLine << TagSpline << TagArc << TagTools;
     const QDomNodeList nodeList = node.childNodes();
     const qint32 num = nodeList.size();
     for (qint32 i = 0; i < num; ++i)
     {
+        if (calculationOnly && recalculationCanceled->load() != 0)
+        {
+            throw VException(tr("Recalculation was canceled."));
+        }
         QDomElement domElement = nodeList.at(i).toElement();
         if (domElement.isNull() == false)
         {
-            switch (tags.indexOf(domElement.tagName()))
-            {
-                case 0: // TagPoint
-                    ParsePointElement(scene, domElement, parse, domElement.attribute(AttrType, ""));
-                    break;
-                case 1: // TagLine
-                    ParseLineElement(scene, domElement, parse);
-                    break;
-                case 2: // TagSpline
-                    ParseSplineElement(scene, domElement, parse, domElement.attribute(AttrType, ""));
-                    break;
-                case 3: // TagArc
-                    ParseArcElement(scene, domElement, parse, domElement.attribute(AttrType, ""));
-                    break;
-                case 4: // TagTools
-                    ParseToolsElement(scene, domElement, parse, domElement.attribute(AttrType, ""));
-                    break;
-                default:
-                    qDebug()<<"Wrong tag name"<<Q_FUNC_INFO;
-                    break;
-            }
+            ParseDrawModeElement(scene, domElement, parse);
         }
     }
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ParseDrawModeElement parse one tool tag of draw mode.
+ * @param scene scene.
+ * @param domElement tag in xml tree.
+ * @param parse parser file mode.
+ */
+void VPattern::ParseDrawModeElement(VMainGraphicsScene *scene, QDomElement &domElement, const Document &parse)
+{
+    QStringList tags = QStringList() << TagPoint << TagLine << TagSpline << TagArc << TagTools;
+    switch (tags.indexOf(domElement.tagName()))
+    {
+        case 0: // TagPoint
+            ParsePointElement(scene, domElement, parse, domElement.attribute(AttrType, ""));
+            break;
+        case 1: // TagLine
+            ParseLineElement(scene, domElement, parse);
+            break;
+        case 2: // TagSpline
+            ParseSplineElement(scene, domElement, parse, domElement.attribute(AttrType, ""));
+            break;
+        case 3: // TagArc
+            ParseArcElement(scene, domElement, parse, domElement.attribute(AttrType, ""));
+            break;
+        case 4: // TagTools
+            ParseToolsElement(scene, domElement, parse, domElement.attribute(AttrType, ""));
+            break;
+        default:
+            qDebug()<<"Wrong tag name"<<Q_FUNC_INFO;
+            break;
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief ParseDetailElement parse detail tag.
@@ -2538,6 +3680,8 @@ void VPattern::PrepareForParse(const Document &parse)
         nameActivPP.clear();
         patternPieces.clear();
         tools.clear();
+        objectOwners.clear();
+        ownersData = *data;
         cursor = 0;
         history.clear();
     }
@@ -2797,3 +3941,337 @@ quint32 VPattern::SiblingNodeId(const quint32 &nodeId) const
     }
     return siblingId;
 }
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief BuildDependencyGraph build graph of dependencies between tools of pattern.
+ *
+ * Tool depends on other tool if it uses one of objects that tool creates. Such objects tool reference by id in
+ * attributes or by name of variable in formulas. Because tool can use only objects created before, history order is
+ * always topological order of graph.
+ */
+void VPattern::BuildDependencyGraph()
+{
+    dependents.clear();
+    dependencies.clear();
+    dependencyHistory = history;
+    for (qint32 i = 0; i < history.size(); ++i)
+    {
+        const QDomElement domElement = elementById(QString().setNum(history.at(i).getId()));
+        if (domElement.isNull() == false)
+        {
+            UpdateToolDependencies(domElement);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief UpdateToolDependencies replace tool dependencies by those described in tool tag.
+ * @param domElement tool tag in xml tree.
+ */
+void VPattern::UpdateToolDependencies(const QDomElement &domElement)
+{
+    const quint32 id = GetParametrId(domElement);
+
+    const QSet<quint32> oldDependencies = dependencies.take(id);
+    QSet<quint32>::const_iterator i = oldDependencies.constBegin();
+    while (i != oldDependencies.constEnd())
+    {
+        dependents[*i].remove(id);
+        ++i;
+    }
+
+    QSet<quint32> objects;
+    CollectObjectIds(domElement, objects);
+    CollectFormulaObjectIds(domElement, objects);
+
+    QSet<quint32> toolDependencies;
+    QSet<quint32>::const_iterator j = objects.constBegin();
+    while (j != objects.constEnd())
+    {
+        const quint32 owner = ObjectOwner(*j);
+        if (owner != NULL_ID && owner != id)
+        {
+            toolDependencies.insert(owner);
+            dependents[owner].insert(id);
+        }
+        ++j;
+    }
+    dependencies.insert(id, toolDependencies);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CollectObjectIds collect ids of objects referenced by attributes of tool tag and its children.
+ * @param domElement tag in xml tree.
+ * @param objects set of object ids.
+ */
+void VPattern::CollectObjectIds(const QDomElement &domElement, QSet<quint32> &objects) const
+{
+    const QStringList attributes = QStringList() << VAbstractTool::AttrBasePoint << VAbstractTool::AttrFirstPoint
+                                                 << VAbstractTool::AttrSecondPoint << VAbstractTool::AttrThirdPoint
+                                                 << VAbstractTool::AttrCenter << VAbstractTool::AttrP1Line
+                                                 << VAbstractTool::AttrP2Line << VAbstractTool::AttrP1Line1
+                                                 << VAbstractTool::AttrP2Line1 << VAbstractTool::AttrP1Line2
+                                                 << VAbstractTool::AttrP2Line2 << VAbstractTool::AttrPShoulder
+                                                 << VAbstractTool::AttrPoint1 << VAbstractTool::AttrPoint4
+                                                 << VAbstractTool::AttrPSpline << VAbstractTool::AttrAxisP1
+                                                 << VAbstractTool::AttrAxisP2 << VAbstractTool::AttrCurve
+                                                 << VToolCutSpline::AttrSpline << VToolCutSplinePath::AttrSplinePath
+                                                 << VToolCutArc::AttrArc << VAbstractNode::AttrIdObject
+                                                 << VAbstractNode::AttrIdTool;
+    for (qint32 i = 0; i < attributes.size(); ++i)
+    {
+        if (domElement.hasAttribute(attributes.at(i)))
+        {
+            objects.insert(GetParametrUInt(domElement, attributes.at(i), NULL_ID_STR));
+        }
+    }
+
+    const QDomNodeList nodeList = domElement.childNodes();
+    const qint32 num = nodeList.size();
+    for (qint32 i = 0; i < num; ++i)
+    {
+        const QDomElement element = nodeList.at(i).toElement();
+        if (element.isNull() == false)
+        {
+            CollectObjectIds(element, objects);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief CollectFormulaObjectIds collect ids of objects whose variables formulas of tool tag use.
+ *
+ * Lengths and angles of lines depend on their points, lengths of curves depend on curves and cutting points.
+ * Measurements and increments don't depend on tools.
+ * @param domElement tag in xml tree.
+ * @param objects set of object ids.
+ */
+void VPattern::CollectFormulaObjectIds(const QDomElement &domElement, QSet<quint32> &objects) const
+{
+    const QStringList attributes = QStringList() << VAbstractTool::AttrLength << VAbstractTool::AttrAngle
+                                                 << VAbstractTool::AttrRadius << VAbstractTool::AttrAngle1
+                                                 << VAbstractTool::AttrAngle2;
+    const QHash<quint32, QSharedPointer<VInternalVariable> > *variables = data->DataVariables();
+    for (qint32 i = 0; i < attributes.size(); ++i)
+    {
+        if (domElement.hasAttribute(attributes.at(i)) == false)
+        {
+            continue;
+        }
+
+        QMap<int, QString> tokens;
+        try
+        {
+            Calculator *cal = new Calculator(domElement.attribute(attributes.at(i)), false);
+            tokens = cal->GetTokens();
+            delete cal;
+        }
+        catch (qmu::QmuParserError &e)
+        {
+            Q_UNUSED(e);
+            continue;
+        }
+
+        const QList<QString> names = tokens.values();
+        for (qint32 j = 0; j < names.size(); ++j)
+        {
+            const QSharedPointer<VInternalVariable> variable = variables->value(VNameTable::Find(names.at(j)));
+            if (variable.isNull())
+            {
+                continue;
+            }
+
+            switch (variable->GetType())
+            {
+                case VarType::LineLength:
+                {
+                    const QSharedPointer<VLengthLine> line = qSharedPointerDynamicCast<VLengthLine>(variable);
+                    objects << line->GetP1Id() << line->GetP2Id();
+                    break;
+                }
+                case VarType::LineAngle:
+                {
+                    const QSharedPointer<VLineAngle> angle = qSharedPointerDynamicCast<VLineAngle>(variable);
+                    objects << angle->GetP1Id() << angle->GetP2Id();
+                    break;
+                }
+                case VarType::SplineLength:
+                case VarType::ArcLength:
+                {
+                    const QSharedPointer<VCurveLength> curve = qSharedPointerDynamicCast<VCurveLength>(variable);
+                    objects << curve->GetId() << curve->GetParentId();
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief ObjectOwner find tool that created object.
+ * @param objectId object id or tool id.
+ * @return tool id or NULL_ID if tool not found.
+ */
+quint32 VPattern::ObjectOwner(quint32 objectId) const
+{
+    if (tools.contains(objectId))
+    {
+        return objectId;
+    }
+    return objectOwners.value(objectId, NULL_ID);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief RecordToolObjects remember that objects container got since previous tool was added belong to this tool.
+ *
+ * Lite parsing doesn't add objects, so only full parsing and creating tools record owners.
+ * @param id tool id.
+ */
+void VPattern::RecordToolObjects(const quint32 &id)
+{
+    const QVector<quint32> ids = data->NewGObjects(ownersData);
+    for (qint32 i = 0; i < ids.size(); ++i)
+    {
+        if (objectOwners.contains(ids.at(i)) == false)
+        {
+            objectOwners.insert(ids.at(i), id);
+        }
+    }
+    ownersData = *data;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief RestoreToolData give tools back data sets they had before failed recalculation.
+ * @param ids ids of tools.
+ * @param dataSets data sets of tools in the same order.
+ */
+void VPattern::RestoreToolData(const QVector<quint32> &ids, const QVector<VContainer> &dataSets)
+{
+    for (qint32 i = 0; i < ids.size(); ++i)
+    {
+        VContainer toolData = dataSets.at(i);
+        UpdateToolData(ids.at(i), &toolData);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief IncrementalParse recalculate only changed tools and tools that depend on them.
+ *
+ * Changed tools and their dependents get recalculated in history order in global data container. After this tools
+ * from first recalculated get their own data sets with changed objects replaced. Changed objects are found by
+ * comparing versions of container, unchanged parts are skipped. If recalculation fails container and data sets of
+ * tools are restored.
+ * @param dirty ids of changed tools.
+ * @return false if lite parsing of pattern is needed: recalculation goes outside calculation of active pattern piece
+ * or it changes set of objects or their names.
+ */
+bool VPattern::IncrementalParse(const QSet<quint32> &dirty)
+{
+    if (dirty.isEmpty() || *mode != Draw::Calculation)
+    {
+        return false;
+    }
+
+    if (dependencyHistory != history)
+    {
+        BuildDependencyGraph();
+    }
+
+    // Changed tools could change their dependencies.
+    QVector<quint32> queue;
+    QSet<quint32>::const_iterator i = dirty.constBegin();
+    while (i != dirty.constEnd())
+    {
+        const QDomElement domElement = elementById(QString().setNum(*i));
+        if (domElement.isNull())
+        {
+            return false;
+        }
+        UpdateToolDependencies(domElement);
+        queue.append(*i);
+        ++i;
+    }
+
+    QSet<quint32> cone;
+    while (queue.isEmpty() == false)
+    {
+        const quint32 id = queue.takeLast();
+        if (cone.contains(id) == false)
+        {
+            cone.insert(id);
+            queue << dependents.value(id).toList().toVector();
+        }
+    }
+
+    QVector<QDomElement> elements;
+    QVector<quint32> affected;
+    QVector<VContainer> dataSets;
+    for (qint32 j = 0; j < history.size(); ++j)
+    {
+        const VToolRecord tool = history.at(j);
+        if (cone.contains(tool.getId()))
+        {
+            const QDomElement domElement = elementById(QString().setNum(tool.getId()));
+            if (tool.getNameDraw() != nameActivPP || domElement.isNull() ||
+                domElement.parentNode().toElement().tagName() != TagCalculation)
+            {
+                return false;
+            }
+            elements.append(domElement);
+        }
+        if (elements.isEmpty() == false && tool.getNameDraw() == nameActivPP && tools.contains(tool.getId()))
+        {
+            affected.append(tool.getId());
+            dataSets.append(tools.value(tool.getId())->getData());
+        }
+    }
+    if (elements.size() != cone.size())
+    {
+        return false;
+    }
+
+    const VContainer oldData = *data;
+    QSet<quint32> changedObjects;
+    QSet<quint32> changedVariables;
+    bool success = false;
+    try
+    {
+        VFormulaSweep sweep;
+        for (qint32 j = 0; j < elements.size(); ++j)
+        {
+            ParseDrawModeElement(sceneDraw, elements[j], Document::LiteParse);
+        }
+        success = data->ChangesSince(oldData, changedObjects, changedVariables);
+    }
+    catch (...)
+    {
+        *data = oldData;
+        RestoreToolData(affected, dataSets);
+        throw;
+    }
+
+    if (success == false)
+    {
+        *data = oldData;
+        RestoreToolData(affected, dataSets);
+        return false;
+    }
+
+    for (qint32 j = 0; j < affected.size(); ++j)
+    {
+        VContainer toolData = dataSets.at(j);
+        toolData.UpdateFromContainer(*data, changedObjects, changedVariables);
+        UpdateToolData(affected.at(j), &toolData);
+    }
+    return true;
+}
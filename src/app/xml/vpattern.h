@@ -31,9 +31,19 @@
 
 #include "vdomdocument.h"
 #include "vtoolrecord.h"
+#include "vformulacheck.h"
+
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QRectF>
+#include <QSet>
+#include <QSharedPointer>
 
 class VDataTool;
 class VMainGraphicsScene;
+struct VPatternRecalculation;
+struct VPatternGrade;
+struct VPatternGradeTask;
 
 enum class Document : char { LiteParse, LitePPParse, FullParse };
 enum class LabelType : char {NewPatternPiece, NewLabel};
@@ -78,6 +88,17 @@ public:
     void           setCurrentData();
     void           AddTool(const quint32 &id, VDataTool *tool);
     void           UpdateToolData(const quint32 &id, VContainer *data);
+    void           MarkToolDirty(const quint32 &id);
+    bool           IsRecalculating() const;
+    QRectF         SceneRect() const;
+    QFuture<VPatternGrade> Grade();
+    void           CancelGrade();
+    QVector<VFormulaCheck> ValidateFormulas() const;
+    void           FixFormula(const VFormulaCheck &check, const QString &formula);
+    bool           IsReportedFormula(const quint32 &toolId, const QString &formula) const;
+    QString        DataMemoryReport() const;
+    QStringList    SensitivityReport() const;
+    QStringList    GradeRules() const;
     void           IncrementReferens(quint32 id) const;
     void           DecrementReferens(quint32 id) const;
     void           TestUniqueId() const;
@@ -222,16 +243,25 @@ signals:
     void           SetEnabledGUI(bool enabled);
     void           CheckLayout();
     void           SetCurrentPP(const QString &patterPiece);
+    /**
+     * @brief WrongFormulas emit on opening pattern if some formulas have errors. Receiver can fix them by FixFormula()
+     * before tools are created.
+     * @param errors failed checks of formulas.
+     */
+    void           WrongFormulas(const QVector<VFormulaCheck> &errors);
 public slots:
     void           LiteParseTree(const Document &parse);
     void           haveLiteChange();
     void           ShowHistoryTool(quint32 id, Qt::GlobalColor color, bool enable);
     void           NeedFullParsing();
     void           ClearScene();
+private slots:
+    void           RecalculationFinished();
 protected:
     virtual void   customEvent(QEvent * event);
 private:
     Q_DISABLE_COPY(VPattern)
+    friend struct VPatternGradeLane;
 
     /** @brief nameActivDraw name current pattern peace. */
     QString        nameActivPP;
@@ -254,9 +284,66 @@ private:
     VMainGraphicsScene *sceneDraw;
     VMainGraphicsScene *sceneDetail;
 
+    /** @brief dependents for each tool ids of tools that use its objects. */
+    QHash<quint32, QSet<quint32> > dependents;
+
+    /** @brief dependencies for each tool ids of tools whose objects it uses. */
+    QHash<quint32, QSet<quint32> > dependencies;
+
+    /** @brief dependencyHistory history records dependency graph was built for. */
+    QVector<VToolRecord> dependencyHistory;
+
+    /** @brief dirtyTools tools changed since last parsing. */
+    QSet<quint32>  dirtyTools;
+
+    /** @brief recalculation watcher of running recalculation on worker thread, nullptr if there is no one. */
+    QFutureWatcher<VPatternRecalculation> *recalculation;
+
+    /** @brief recalculationCanceled cancel flag of running recalculation. */
+    QSharedPointer<QAtomicInt> recalculationCanceled;
+
+    /** @brief gradeCanceled cancel flag of running grading. */
+    QSharedPointer<QAtomicInt> gradeCanceled;
+
+    /** @brief calculationOnly document is copy for recalculation on worker thread. It doesn't have tools. */
+    bool           calculationOnly;
+
+    /** @brief calculatedData data sets of tools that recalculation collects instead of updating tools. */
+    QHash<quint32, VContainer> calculatedData;
+
+    /** @brief parallelPieces recalculation parses pattern pieces concurrently. */
+    bool           parallelPieces;
+
+    /** @brief sceneRect rect of current scene when recalculation started. Worker must not read scene. */
+    QRectF         sceneRect;
+
+    /** @brief reportedFormulas wrong formulas by tool id that user already saw in list on opening and didn't fix. */
+    QMultiHash<quint32, QString> reportedFormulas;
+
+    /** @brief objectOwners id of tool that created object by object id. */
+    QHash<quint32, quint32> objectOwners;
+
+    /** @brief ownersData version of container when last tool was added, newer objects belong to next tool. */
+    VContainer     ownersData;
+
     void           SetActivPP(const QString& name);
+    void           LiteParse(const Document &parse, const QSet<quint32> &dirty, bool inBackground);
+    void           RefreshScenes();
+    VPatternRecalculation RecalculationTask() const;
+    void           StartRecalculation();
+    void           CancelRecalculation();
+    static VPatternRecalculation Recalculate(VPatternRecalculation task);
+    static VPatternGrade GradeCombination(const QSharedPointer<VPatternGradeTask> &task, int lane);
+    QHash<QString, QVector<qreal> > GradeFormulas(const QVector<qreal> &sizes, const QVector<qreal> &heights) const;
+    static void    RecalculatePiece(VPatternRecalculation &piece);
+    static void    CheckFormula(VFormulaCheck &check);
+    static void    CollectElements(const QDomElement &element, QVector<QDomElement> &elements);
+    void           SetRecalculationTask(const VPatternRecalculation &task);
+    bool           PiecesAreIndependent();
+    void           ParsePiecesConcurrently(const QVector<QDomElement> &elements);
     void           ParseDrawElement(const QDomNode& node, const Document &parse);
     void           ParseDrawMode(const QDomNode& node, const Document &parse, const Draw &mode);
+    void           ParseDrawModeElement(VMainGraphicsScene *scene, QDomElement &domElement, const Document &parse);
     void           ParseDetailElement(const QDomElement &domElement,
                                       const Document &parse);
     void           ParseDetails(const QDomElement &domElement, const Document &parse);
@@ -288,6 +375,14 @@ private:
     void           CheckTagExists(const QString &tag);
     QString        GetLabelBase(unsigned int index)const;
     void           ToolExists(const quint32 &id) const;
+    void           BuildDependencyGraph();
+    void           UpdateToolDependencies(const QDomElement &domElement);
+    void           CollectObjectIds(const QDomElement &domElement, QSet<quint32> &objects) const;
+    void           CollectFormulaObjectIds(const QDomElement &domElement, QSet<quint32> &objects) const;
+    quint32        ObjectOwner(quint32 objectId) const;
+    void           RecordToolObjects(const quint32 &id);
+    void           RestoreToolData(const QVector<quint32> &ids, const QVector<VContainer> &dataSets);
+    bool           IncrementalParse(const QSet<quint32> &dirty);
 };
 
 //---------------------------------------------------------------------------------------------------------------------
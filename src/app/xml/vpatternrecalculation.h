@@ -0,0 +1,154 @@
+/************************************************************************
+ **
+ **  @file   vpatternrecalculation.h
+ **  @author Roman Telezhynskyi <dismine(at)gmail.com>
+ **  @date   17 10, 2026
+ **
+ **  @brief
+ **  @copyright
+ **  This source code is part of the Valentine project, a pattern making
+ **  program, whose allow create and modeling patterns of clothing.
+ **  Copyright (C) 2014 Valentina project
+ **  <https://bitbucket.org/dismine/valentina> All Rights Reserved.
+ **
+ **  Valentina is free software: you can redistribute it and/or modify
+ **  it under the terms of the GNU General Public License as published by
+ **  the Free Software Foundation, either version 3 of the License, or
+ **  (at your option) any later version.
+ **
+ **  Valentina is distributed in the hope that it will be useful,
+ **  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **  GNU General Public License for more details.
+ **
+ **  You should have received a copy of the GNU General Public License
+ **  along with Valentina.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ *************************************************************************/
+
+#ifndef VPATTERNRECALCULATION_H
+#define VPATTERNRECALCULATION_H
+
+#include "vdomdocument.h"
+#include "vtoolrecord.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QRectF>
+#include <QSet>
+#include <QSharedPointer>
+
+class VMainGraphicsScene;
+
+/**
+ * @brief The VPatternRecalculation struct keeps task and result of pattern recalculation on worker thread.
+ *
+ * GUI thread fills snapshot of pattern: copy of document, data container, history, id counter and unique names. Worker
+ * parses copy of document and returns data container, data sets of tools, id counter and unique names. GUI thread
+ * applies them only if result is accepted. Snapshot doesn't share anything that GUI thread can change.
+ * The same struct describes recalculation of one pattern piece, then document contains only this piece.
+ */
+struct VPatternRecalculation
+{
+    VPatternRecalculation()
+        :document(), data(), history(), patternPieces(), nameActivPP(), cursor(0), mode(Draw::Calculation),
+          sceneDraw(nullptr), sceneDetail(nullptr), sceneRect(), lastId(0), finalId(0), uniqueNames(), canceled(),
+          independentPieces(false), toolData(), success(false)
+    {}
+
+    /** @brief document deep copy of pattern file. */
+    QDomDocument                 document;
+
+    /** @brief data data container. Worker replaces it by recalculated one. */
+    VContainer                   data;
+
+    QVector<VToolRecord>         history;
+    QStringList                  patternPieces;
+    QString                      nameActivPP;
+    quint32                      cursor;
+    Draw                         mode;
+
+    /** @brief sceneDraw scene is needed only for creating tools, recalculation never uses it. */
+    VMainGraphicsScene          *sceneDraw;
+
+    /** @brief sceneDetail scene is needed only for creating tools, recalculation never uses it. */
+    VMainGraphicsScene          *sceneDetail;
+
+    /** @brief sceneRect rect of current scene, tools build axis inside it. */
+    QRectF                       sceneRect;
+
+    /** @brief lastId last object id when recalculation started. */
+    quint32                      lastId;
+
+    /** @brief finalId last object id after recalculation. */
+    quint32                      finalId;
+
+    /** @brief uniqueNames handles of names of objects and variables, worker replaces them by recalculated ones. */
+    QSet<quint32>                uniqueNames;
+
+    /** @brief canceled not zero if GUI doesn't need result anymore. */
+    QSharedPointer<QAtomicInt>   canceled;
+
+    /** @brief independentPieces tools don't use objects of other pattern pieces, pieces can be parsed concurrently. */
+    bool                         independentPieces;
+
+    /** @brief toolData recalculated data sets of tools. */
+    QHash<quint32, VContainer>   toolData;
+
+    /** @brief success false if recalculation failed or was canceled. */
+    bool                         success;
+};
+
+/**
+ * @brief The VPatternGrade struct keeps result of grading pattern for one size and height.
+ */
+struct VPatternGrade
+{
+    VPatternGrade()
+        :size(0), height(0), success(false)
+    {}
+
+    /** @brief size value of size in pattern units. */
+    qreal                        size;
+
+    /** @brief height value of height in pattern units. */
+    qreal                        height;
+
+    /** @brief success false if pattern can't be calculated for this size and height. */
+    bool                         success;
+};
+
+/**
+ * @brief The VPatternGradeTask struct keeps one snapshot of pattern that all combinations of grading share.
+ *
+ * Nobody parses document of snapshot. Each combination takes deep copy of it from documents and puts it back when
+ * finishes, so pattern is copied once per thread, not once per combination.
+ */
+struct VPatternGradeTask
+{
+    VPatternGradeTask()
+        :snapshot(), sizes(), heights(), lanes(), documents(), mutex()
+    {}
+
+    VPatternRecalculation        snapshot;
+
+    /** @brief sizes size of each combination in pattern units. */
+    QVector<qreal>               sizes;
+
+    /** @brief heights height of each combination in pattern units. */
+    QVector<qreal>               heights;
+
+    /** @brief lanes values of formulas that depend only on measurements and increments for all combinations. */
+    QHash<QString, QVector<qreal> > lanes;
+
+    /** @brief documents copies of document that are not used by any combination now. */
+    QVector<QDomDocument>        documents;
+
+    /** @brief mutex guards documents. */
+    QMutex                       mutex;
+private:
+    Q_DISABLE_COPY(VPatternGradeTask)
+};
+
+#endif // VPATTERNRECALCULATION_H
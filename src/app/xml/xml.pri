@@ -4,7 +4,9 @@ HEADERS += \
     xml/vpattern.h \
     xml/vstandardmeasurements.h \
     xml/vindividualmeasurements.h \
-    xml/vabstractmeasurements.h
+    xml/vabstractmeasurements.h \
+    xml/vpatternrecalculation.h \
+    xml/vformulacheck.h
 
 SOURCES += \
     xml/vtoolrecord.cpp \
@@ -316,6 +316,172 @@ void QmuParser::InitOprt()
     DefineInfixOprt("-", UnaryMinus);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+// Derivatives of default functions
+
+static qreal DiffNeg(qreal)
+{
+    return -1;
+}
+
+static qreal DiffSin(qreal v)
+{
+    return qCos(v);
+}
+
+static qreal DiffCos(qreal v)
+{
+    return -qSin(v);
+}
+
+static qreal DiffTan(qreal v)
+{
+    return 1 / (qCos(v) * qCos(v));
+}
+
+static qreal DiffASin(qreal v)
+{
+    return 1 / qSqrt(1 - v * v);
+}
+
+static qreal DiffACos(qreal v)
+{
+    return -1 / qSqrt(1 - v * v);
+}
+
+static qreal DiffATan(qreal v)
+{
+    return 1 / (1 + v * v);
+}
+
+// atan2(y, x) by y
+static qreal DiffATan2Y(qreal y, qreal x)
+{
+    return x / (x * x + y * y);
+}
+
+// atan2(y, x) by x
+static qreal DiffATan2X(qreal y, qreal x)
+{
+    return -y / (x * x + y * y);
+}
+
+static qreal DiffSinh(qreal v)
+{
+    return cosh(v);
+}
+
+static qreal DiffCosh(qreal v)
+{
+    return sinh(v);
+}
+
+static qreal DiffTanh(qreal v)
+{
+    return 1 - tanh(v) * tanh(v);
+}
+
+static qreal DiffASinh(qreal v)
+{
+    return 1 / qSqrt(v * v + 1);
+}
+
+static qreal DiffACosh(qreal v)
+{
+    return 1 / qSqrt(v * v - 1);
+}
+
+static qreal DiffATanh(qreal v)
+{
+    return 1 / (1 - v * v);
+}
+
+static qreal DiffLog2(qreal v)
+{
+    return 1 / (v * log(2.0));
+}
+
+static qreal DiffLog10(qreal v)
+{
+    return 1 / (v * log(10.0));
+}
+
+static qreal DiffLn(qreal v)
+{
+    return 1 / v;
+}
+
+static qreal DiffExp(qreal v)
+{
+    return qExp(v);
+}
+
+static qreal DiffSqrt(qreal v)
+{
+    return 0.5 / qSqrt(v);
+}
+
+static qreal DiffAbs(qreal v)
+{
+    return ((v<0) ? -1 : (v>0) ? 1 : 0);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Initialize derivatives of the default functions and operators.
+ *
+ * Derivative of min and max is derivative of selected argument, it can't be written as bytecode, so formulas that use
+ * them with variable arguments are differentiated only over dual numbers.
+ */
+QmuParserDerivative QmuParser::InitDiff()
+{
+    QmuParserDerivative derivative;
+    derivative.DefineDiff(UnaryMinus, DiffNeg);
+    // trigonometric functions
+    derivative.DefineDiff(qSin,   DiffSin);
+    derivative.DefineDiff(qCos,   DiffCos);
+    derivative.DefineDiff(qTan,   DiffTan);
+    // arcus functions
+    derivative.DefineDiff(qAsin,  DiffASin);
+    derivative.DefineDiff(qAcos,  DiffACos);
+    derivative.DefineDiff(qAtan,  DiffATan);
+    derivative.DefineDiff(qAtan2, DiffATan2Y, DiffATan2X);
+    // hyperbolic functions
+    derivative.DefineDiff(Sinh,   DiffSinh);
+    derivative.DefineDiff(Cosh,   DiffCosh);
+    derivative.DefineDiff(Tanh,   DiffTanh);
+    // arcus hyperbolic functions
+    derivative.DefineDiff(ASinh,  DiffASinh);
+    derivative.DefineDiff(ACosh,  DiffACosh);
+    derivative.DefineDiff(ATanh,  DiffATanh);
+    // Logarithm functions
+    derivative.DefineDiff(Log2,   DiffLog2);
+    derivative.DefineDiff(Log10,  DiffLog10);
+    derivative.DefineDiff(qLn,    DiffLn);
+    // misc
+    derivative.DefineDiff(qExp,   DiffExp);
+    derivative.DefineDiff(qSqrt,  DiffSqrt);
+    derivative.DefineDiff(Sign,   nullptr);
+    derivative.DefineDiff(Rint,   nullptr);
+    derivative.DefineDiff(Abs,    DiffAbs);
+    // Functions with variable number of arguments
+    derivative.DefineSumDiff(Sum, false);
+    derivative.DefineSumDiff(Avg, true);
+    derivative.DefineSelectDiff(Min);
+    derivative.DefineSelectDiff(Max);
+    return derivative;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Rules of differentiation for the default functions, they are initialized once for all parsers.
+ */
+const QmuParserDerivative &QmuParser::DiffRules()
+{
+    static const QmuParserDerivative derivative = InitDiff();
+    return derivative;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void QmuParser::OnDetectVar(const QString &pExpr, int &nStart, int &nEnd)
 {
@@ -382,4 +548,36 @@ qreal QmuParser::Diff(qreal *a_Var, qreal  a_fPos, qreal  a_fEpsilon) const
     fRes = (-f[0] + 8*f[1] - 8*f[2] + f[3]) / (12*fEpsilon);
     return fRes;
 }
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Symbolically differentiate current expression with regard to a variable.
+ *
+ * Unlike Diff() the result is bytecode, so derivative can be evaluated for many values of variables without
+ * evaluating expression again. Expression must be parsed (evaluated at least once) before.
+ * @param [in] a_Var Pointer to the differentiation variable.
+ * @param [out] a_Derivative Bytecode of derivative, can be set to parser by SetByteCode().
+ * @return false if expression can't be differentiated symbolically, use Diff() in this case.
+ */
+bool QmuParser::Derive(const qreal *a_Var, QmuParserByteCode &a_Derivative) const
+{
+    return DiffRules().Derive(GetByteCode(), a_Var, a_Derivative);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Evaluate current expression over dual numbers.
+ *
+ * Forward mode of automatic differentiation: expression returns its value and gradient by two independent variables
+ * in one pass. Each seed gives value of variable and its derivatives by independent variables, for example variable
+ * that is independent itself has gradient (1, 0) or (0, 1). Expression must be parsed (evaluated at least once)
+ * before.
+ * @param [in] a_Seeds dual values of variables by pointer to variable, other variables are constants.
+ * @param [out] a_Result value of expression and its gradient.
+ * @return false if expression can't be evaluated over dual numbers, use Diff() in this case.
+ */
+bool QmuParser::EvalDual(const QHash<const qreal *, QmuDual> &a_Seeds, QmuDual &a_Result) const
+{
+    return DiffRules().EvalDual(GetByteCode(), a_Seeds, a_Result);
+}
 } // namespace qmu
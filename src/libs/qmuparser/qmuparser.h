@@ -25,6 +25,7 @@
 
 #include "qmuparser_global.h"
 #include "qmuparserbase.h"
+#include "qmuparserderivative.h"
 
 /**
  * @file
@@ -53,7 +54,11 @@ namespace qmu
         virtual void InitOprt();
         virtual void OnDetectVar(const QString &pExpr, int &nStart, int &nEnd);
         qreal        Diff(qreal *a_Var, qreal a_fPos, qreal a_fEpsilon = 0) const;
+        bool         Derive(const qreal *a_Var, QmuParserByteCode &a_Derivative) const;
+        bool         EvalDual(const QHash<const qreal *, QmuDual> &a_Seeds, QmuDual &a_Result) const;
     protected:
+        static QmuParserDerivative InitDiff();
+        static const QmuParserDerivative &DiffRules();
         static int   IsVal(const QString &a_szExpr, int *a_iPos, qreal *a_fVal);
         // Trigonometric functions
         static qreal Tan2(qreal, qreal);
@@ -36,9 +36,12 @@ OBJECTS_DIR = obj
 SOURCES += \
     qmuparser.cpp \
     qmuparsertokenreader.cpp \
+    qmuparsercharset.cpp \
     qmuparsererror.cpp \
     qmuparsercallback.cpp \
     qmuparserbytecode.cpp \
+    qmuparserjit.cpp \
+    qmuparserderivative.cpp \
     qmuparserbase.cpp \
     qmuparsertest.cpp \
     stable.cpp
@@ -47,12 +50,15 @@ HEADERS += \
     qmuparser.h\
     qmuparser_global.h \
     qmuparsertokenreader.h \
+    qmuparsercharset.h \
     qmuparsertoken.h \
     qmuparserfixes.h \
     qmuparsererror.h \
     qmuparserdef.h \
     qmuparsercallback.h \
     qmuparserbytecode.h \
+    qmuparserjit.h \
+    qmuparserderivative.h \
     qmuparserbase.h \
     qmuparsertest.h \
     stable.h
@@ -59,7 +59,9 @@ const QStringList QmuParserBase::c_DefaultOprt = QStringList()<< "<=" << ">=" <<
 QmuParserBase::QmuParserBase()
     :m_pParseFormula(&QmuParserBase::ParseString), m_vRPN(), m_vStringBuf(), m_vStringVarBuf(), m_pTokenReader(),
       m_FunDef(), m_PostOprtDef(), m_InfixOprtDef(), m_OprtDef(), m_ConstDef(), m_StrVarDef(), m_VarDef(),
-      m_bBuiltInOp(true), m_sNameChars(), m_sOprtChars(), m_sInfixOprtChars(), m_nIfElseCounter(0), m_vStackBuffer(),
+      m_bBuiltInOp(true), m_bJit(false), m_pJit(), m_vJitVars(), m_sNameChars(), m_sOprtChars(), m_sInfixOprtChars(),
+      m_NameCharSet(), m_OprtCharSet(), m_InfixOprtCharSet(),
+      m_nIfElseCounter(0), m_vStackBuffer(),
       m_nFinalResultIdx(0), m_Tokens(QMap<int, QString>()), m_Numbers(QMap<int, QString>()), allowSubexpressions(true)
 {
     InitTokenReader();
@@ -74,7 +76,9 @@ QmuParserBase::QmuParserBase()
 QmuParserBase::QmuParserBase(const QmuParserBase &a_Parser)
     :m_pParseFormula(&QmuParserBase::ParseString), m_vRPN(), m_vStringBuf(), m_vStringVarBuf(), m_pTokenReader(),
       m_FunDef(), m_PostOprtDef(), m_InfixOprtDef(), m_OprtDef(), m_ConstDef(), m_StrVarDef(), m_VarDef(),
-      m_bBuiltInOp(true), m_sNameChars(), m_sOprtChars(), m_sInfixOprtChars(), m_nIfElseCounter(0), m_vStackBuffer(),
+      m_bBuiltInOp(true), m_bJit(false), m_pJit(), m_vJitVars(), m_sNameChars(), m_sOprtChars(), m_sInfixOprtChars(),
+      m_NameCharSet(), m_OprtCharSet(), m_InfixOprtCharSet(),
+      m_nIfElseCounter(0), m_vStackBuffer(),
       m_nFinalResultIdx(0), m_Tokens(QMap<int, QString>()), m_Numbers(QMap<int, QString>()), allowSubexpressions(true)
 {
     m_pTokenReader.reset(new token_reader_type(this));
@@ -124,6 +128,7 @@ void QmuParserBase::Assign(const QmuParserBase &a_Parser)
     m_ConstDef        = a_Parser.m_ConstDef;         // Copy user define constants
     m_VarDef          = a_Parser.m_VarDef;           // Copy user defined variables
     m_bBuiltInOp      = a_Parser.m_bBuiltInOp;
+    m_bJit            = a_Parser.m_bJit;
     m_vStringBuf      = a_Parser.m_vStringBuf;
     m_vStackBuffer    = a_Parser.m_vStackBuffer;
     m_nFinalResultIdx = a_Parser.m_nFinalResultIdx;
@@ -141,6 +146,9 @@ void QmuParserBase::Assign(const QmuParserBase &a_Parser)
     m_sNameChars      = a_Parser.m_sNameChars;
     m_sOprtChars      = a_Parser.m_sOprtChars;
     m_sInfixOprtChars = a_Parser.m_sInfixOprtChars;
+    m_NameCharSet      = a_Parser.m_NameCharSet;
+    m_OprtCharSet      = a_Parser.m_OprtCharSet;
+    m_InfixOprtCharSet = a_Parser.m_InfixOprtCharSet;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -278,7 +286,7 @@ QString QmuParserBase::GetVersion(EParserVersionInfo eInfo)
  * @brief Add a function or operator callback to the parser.
  */
 void QmuParserBase::AddCallback(const QString &a_strName, const QmuParserCallback &a_Callback,
-                                funmap_type &a_Storage, const QString &a_szCharSet )
+                                funmap_type &a_Storage, const QmuParserCharSet &a_CharSet )
 {
     if (a_Callback.GetAddr()==0)
     {
@@ -308,7 +316,7 @@ void QmuParserBase::AddCallback(const QString &a_strName, const QmuParserCallbac
         Error(ecNAME_CONFLICT, -1, a_strName);
     }
 
-    CheckOprt(a_strName, a_Callback, a_szCharSet);
+    CheckOprt(a_strName, a_Callback, a_CharSet);
     a_Storage[a_strName] = a_Callback;
     ReInit();
 }
@@ -320,13 +328,10 @@ void QmuParserBase::AddCallback(const QString &a_strName, const QmuParserCallbac
  * @throw ParserException if the name contains invalid charakters.
  */
 void QmuParserBase::CheckOprt(const QString &a_sName, const QmuParserCallback &a_Callback,
-                              const QString &a_szCharSet) const
+                              const QmuParserCharSet &a_CharSet) const
 {
-    const std::wstring a_sNameStd = a_sName.toStdWString();
-    const std::wstring a_szCharSetStd = a_szCharSet.toStdWString();
-
-    if ( a_sNameStd.length() == false || (a_sNameStd.find_first_not_of(a_szCharSetStd)!=string_type::npos) ||
-         (a_sNameStd.at(0)>='0' && a_sNameStd.at(0)<='9'))
+    if ( a_sName.isEmpty() || a_CharSet.Span(a_sName, 0) != a_sName.size() ||
+         (a_sName.at(0)>='0' && a_sName.at(0)<='9'))
     {
         switch (a_Callback.GetCode())
         {
@@ -349,13 +354,10 @@ void QmuParserBase::CheckOprt(const QString &a_sName, const QmuParserCallback &a
  *
  * @throw ParserException if the name contains invalid charakters.
  */
-void QmuParserBase::CheckName(const QString &a_sName, const QString &a_szCharSet) const
+void QmuParserBase::CheckName(const QString &a_sName, const QmuParserCharSet &a_CharSet) const
 {
-    std::wstring a_sNameStd = a_sName.toStdWString();
-    std::wstring a_szCharSetStd = a_szCharSet.toStdWString();
-
-    if ( a_sNameStd.length() == false || (a_sNameStd.find_first_not_of(a_szCharSetStd)!=string_type::npos) ||
-         (a_sNameStd[0]>='0' && a_sNameStd[0]<='9'))
+    if ( a_sName.isEmpty() || a_CharSet.Span(a_sName, 0) != a_sName.size() ||
+         (a_sName.at(0)>='0' && a_sName.at(0)<='9'))
     {
         Error(ecINVALID_NAME);
     }
@@ -388,6 +390,25 @@ void QmuParserBase::SetExpr(const QString &a_sExpr)
     ReInit();
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Set finalized bytecode instead of parsing formula string.
+ * @param a_ByteCode bytecode created earlier by this or other parser with the same callbacks.
+ * @param a_nNumResults number of results on the calculation stack (see GetNumResults()).
+ *
+ * Switch parser to bytecode mode, so next call Eval() will skip string parsing. Bytecode must not contain string
+ * functions because string buffer is not part of bytecode. Tokens and numbers of formula are not available after
+ * that.
+ */
+void QmuParserBase::SetByteCode(const QmuParserByteCode &a_ByteCode, int a_nNumResults)
+{
+    ReInit();
+    m_vRPN = a_ByteCode;
+    m_nFinalResultIdx = a_nNumResults;
+    m_vStackBuffer.resize(m_vRPN.GetMaxStackSize() * s_MaxNumOpenMPThreads);
+    SetCmdCodeParser();
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief Virtual function that defines the characters allowed in name identifiers.
@@ -429,7 +450,7 @@ const QString &QmuParserBase::ValidInfixOprtChars() const
 void QmuParserBase::DefinePostfixOprt(const QString &a_sName, fun_type1 a_pFun, bool a_bAllowOpt)
 {
     AddCallback(a_sName, QmuParserCallback(a_pFun, a_bAllowOpt, prPOSTFIX, cmOPRT_POSTFIX), m_PostOprtDef,
-                ValidOprtChars() );
+                OprtCharSet() );
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -460,7 +481,7 @@ void QmuParserBase::Init()
 void QmuParserBase::DefineInfixOprt(const QString &a_sName, fun_type1 a_pFun, int a_iPrec, bool a_bAllowOpt)
 {
     AddCallback(a_sName, QmuParserCallback(a_pFun, a_bAllowOpt, a_iPrec, cmOPRT_INFIX), m_InfixOprtDef,
-                ValidInfixOprtChars() );
+                InfixOprtCharSet() );
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -487,7 +508,7 @@ void QmuParserBase::DefineOprt( const QString &a_sName, fun_type2 a_pFun, unsign
     }
 
     AddCallback(a_sName, QmuParserCallback(a_pFun, a_bAllowOpt, static_cast<int>(a_iPrec), a_eAssociativity), m_OprtDef,
-                ValidOprtChars() );
+                OprtCharSet() );
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -505,7 +526,7 @@ void QmuParserBase::DefineStrConst(const QString &a_strName, const QString &a_st
         Error(ecNAME_CONFLICT);
     }
 
-    CheckName(a_strName, ValidNameChars());
+    CheckName(a_strName, NameCharSet());
 
     m_vStringVarBuf.push_back(a_strVal);           // Store variable string in internal buffer
     m_StrVarDef[a_strName] = m_vStringBuf.size();  // bind buffer index to variable name
@@ -534,7 +555,7 @@ void QmuParserBase::DefineVar(const QString &a_sName, qreal *a_pVar)
         Error(ecNAME_CONFLICT);
     }
 
-    CheckName(a_sName, ValidNameChars());
+    CheckName(a_sName, NameCharSet());
     m_VarDef[a_sName] = a_pVar;
     ReInit();
 }
@@ -549,7 +570,7 @@ void QmuParserBase::DefineVar(const QString &a_sName, qreal *a_pVar)
  */
 void QmuParserBase::DefineConst(const QString &a_sName, qreal a_fVal)
 {
-    CheckName(a_sName, ValidNameChars());
+    CheckName(a_sName, NameCharSet());
     m_ConstDef[a_sName] = a_fVal;
     ReInit();
 }
@@ -938,6 +959,40 @@ qreal QmuParserBase::ParseCmdCode() const
     return ParseCmdCodeBulk(0, 0);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Evaluate native code of bytecode.
+ * @sa SetCmdCodeParser()
+ */
+qreal QmuParserBase::ParseJitCode() const
+{
+    return m_pJit->Eval(m_vStackBuffer.data(), m_vJitVars.constData());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Choose parse routine for finalized bytecode.
+ *
+ * If native code compilation is enabled and bytecode can be compiled we use native code, otherwise interpreter.
+ */
+void QmuParserBase::SetCmdCodeParser() const
+{
+    m_pParseFormula = &QmuParserBase::ParseCmdCode;
+    if (m_bJit)
+    {
+        if (m_pJit == nullptr)
+        {
+            m_pJit.reset(new QmuParserJit());
+        }
+
+        if (m_pJit->Compile(m_vRPN, m_nFinalResultIdx))
+        {
+            m_vJitVars = m_vRPN.GetVarPtrs();
+            m_pParseFormula = &QmuParserBase::ParseJitCode;
+        }
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief Evaluate the RPN.
@@ -1278,6 +1333,401 @@ qreal QmuParserBase::ParseCmdCodeBulk(int nOffset, int nThreadID) const
     return Stack[m_nFinalResultIdx];
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Check if the RPN can be evaluated by the vectorized bulk interpreter.
+ *
+ * If-then-else needs own jump for each lane, assignment writes to one variable and bulk functions expect single
+ * offset, such code is evaluated lane by lane.
+ */
+bool QmuParserBase::IsLanesCode() const
+{
+    for (const SToken *pTok = m_vRPN.GetBase(); pTok->Cmd!=cmEND ; ++pTok)
+    {
+        switch (pTok->Cmd)
+        {
+            case cmLE:
+            case cmGE:
+            case cmNEQ:
+            case cmEQ:
+            case cmLT:
+            case cmGT:
+            case cmADD:
+            case cmSUB:
+            case cmMUL:
+            case cmDIV:
+            case cmPOW:
+            case cmLAND:
+            case cmLOR:
+            case cmVAR:
+            case cmVAL:
+            case cmVARPOW2:
+            case cmVARPOW3:
+            case cmVARPOW4:
+            case cmVARMUL:
+                break;
+            case cmFUNC:
+                if (pTok->Fun.argc > 10)
+                {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Evaluate the RPN for a block of bulk lanes.
+ *
+ * The bytecode is executed once for all lanes of the block. Every stack position holds s_BulkBlockSize values, one
+ * for each lane, so each operator works over continuous arrays and the compiler can vectorize the loops.
+ * @param results array for the results of the lanes.
+ * @param nOffset index of the first lane, added to variable addresses.
+ * @param nLanes number of lanes in the block, not more than s_BulkBlockSize.
+ * @param Stack buffer for GetMaxStackSize() stack positions of s_BulkBlockSize values.
+ */
+void QmuParserBase::ParseCmdCodeLanes(qreal *results, int nOffset, int nLanes, qreal *Stack) const
+{
+    assert(nLanes > 0 && nLanes <= s_BulkBlockSize);
+
+    int sidx(0);
+    for (const SToken *pTok = m_vRPN.GetBase(); pTok->Cmd!=cmEND ; ++pTok)
+    {
+        // x is the top of the stack after the token, y is the next position (second operand of binary operators).
+        qreal *x = nullptr;
+        const qreal *y = nullptr;
+        switch (pTok->Cmd)
+        {
+          // built in binary operators
+            case cmLE:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = x[i] <= y[i];
+                }
+                continue;
+            case cmGE:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = x[i] >= y[i];
+                }
+                continue;
+            case cmNEQ:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = (qFuzzyCompare(x[i], y[i])==false);
+                }
+                continue;
+            case cmEQ:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = qFuzzyCompare(x[i], y[i]);
+                }
+                continue;
+            case cmLT:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = x[i] < y[i];
+                }
+                continue;
+            case cmGT:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = x[i] > y[i];
+                }
+                continue;
+            case cmADD:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] += y[i];
+                }
+                continue;
+            case cmSUB:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] -= y[i];
+                }
+                continue;
+            case cmMUL:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] *= y[i];
+                }
+                continue;
+            case cmDIV:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+    #if defined(MUP_MATH_EXCEPTIONS)
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    if (y[i]==0)
+                    {
+                        Error(ecDIV_BY_ZERO);
+                    }
+                }
+    #endif
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] /= y[i];
+                }
+                continue;
+            case cmPOW:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = qPow(x[i], y[i]);
+                }
+                continue;
+            case cmLAND:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+#ifdef Q_CC_GNU
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wfloat-equal"
+#endif
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = static_cast<bool>(x[i]) && static_cast<bool>(y[i]);
+                }
+#ifdef Q_CC_GNU
+    #pragma GCC diagnostic pop
+#endif
+                continue;
+            case cmLOR:
+                --sidx;
+                x = Stack + sidx * s_BulkBlockSize;
+                y = x + s_BulkBlockSize;
+#ifdef Q_CC_GNU
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wfloat-equal"
+#endif
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = static_cast<bool>(x[i]) || static_cast<bool>(y[i]);
+                }
+#ifdef Q_CC_GNU
+    #pragma GCC diagnostic pop
+#endif
+                continue;
+
+            // value and variable tokens
+            case cmVAR:
+                x = Stack + (++sidx) * s_BulkBlockSize;
+                y = pTok->Val.ptr + nOffset;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = y[i];
+                }
+                continue;
+            case cmVAL:
+            {
+                x = Stack + (++sidx) * s_BulkBlockSize;
+                const qreal val = pTok->Val.data2;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = val;
+                }
+                continue;
+            }
+            case cmVARPOW2:
+                x = Stack + (++sidx) * s_BulkBlockSize;
+                y = pTok->Val.ptr + nOffset;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = y[i]*y[i];
+                }
+                continue;
+            case cmVARPOW3:
+                x = Stack + (++sidx) * s_BulkBlockSize;
+                y = pTok->Val.ptr + nOffset;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = y[i]*y[i]*y[i];
+                }
+                continue;
+            case cmVARPOW4:
+                x = Stack + (++sidx) * s_BulkBlockSize;
+                y = pTok->Val.ptr + nOffset;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = y[i]*y[i]*y[i]*y[i];
+                }
+                continue;
+            case cmVARMUL:
+            {
+                x = Stack + (++sidx) * s_BulkBlockSize;
+                y = pTok->Val.ptr + nOffset;
+                const qreal k = pTok->Val.data;
+                const qreal b = pTok->Val.data2;
+                for (int i = 0; i < nLanes; ++i)
+                {
+                    x[i] = y[i] * k + b;
+                }
+                continue;
+            }
+            // Next is treatment of numeric functions. Function can't be vectorized, but we still save the dispatch
+            // of the bytecode for each lane.
+            case cmFUNC:
+            {
+                int iArgCount = pTok->Fun.argc;
+#ifdef Q_CC_CLANG
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wundefined-reinterpret-cast"
+#endif
+                const int n = iArgCount >= 0 ? iArgCount : -iArgCount;
+                sidx -= n - 1;
+                x = Stack + sidx * s_BulkBlockSize;
+                const int b = s_BulkBlockSize; // distance between arguments of one lane
+
+                // switch according to argument count
+                switch (iArgCount)
+                {
+                    case 0:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type0>(pTok->Fun.ptr))();
+                        }
+                        continue;
+                    case 1:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type1>(pTok->Fun.ptr))(x[i]);
+                        }
+                        continue;
+                    case 2:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type2>(pTok->Fun.ptr))(x[i], x[i+b]);
+                        }
+                        continue;
+                    case 3:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type3>(pTok->Fun.ptr))(x[i], x[i+b], x[i+2*b]);
+                        }
+                        continue;
+                    case 4:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type4>(pTok->Fun.ptr))(x[i], x[i+b], x[i+2*b], x[i+3*b]);
+                        }
+                        continue;
+                    case 5:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type5>(pTok->Fun.ptr))(x[i], x[i+b], x[i+2*b], x[i+3*b],
+                                                                                 x[i+4*b]);
+                        }
+                        continue;
+                    case 6:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type6>(pTok->Fun.ptr))(x[i], x[i+b], x[i+2*b], x[i+3*b],
+                                                                                 x[i+4*b], x[i+5*b]);
+                        }
+                        continue;
+                    case 7:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type7>(pTok->Fun.ptr))(x[i], x[i+b], x[i+2*b], x[i+3*b],
+                                                                                 x[i+4*b], x[i+5*b], x[i+6*b]);
+                        }
+                        continue;
+                    case 8:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type8>(pTok->Fun.ptr))(x[i], x[i+b], x[i+2*b], x[i+3*b],
+                                                                                 x[i+4*b], x[i+5*b], x[i+6*b],
+                                                                                 x[i+7*b]);
+                        }
+                        continue;
+                    case 9:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type9>(pTok->Fun.ptr))(x[i], x[i+b], x[i+2*b], x[i+3*b],
+                                                                                 x[i+4*b], x[i+5*b], x[i+6*b], x[i+7*b],
+                                                                                 x[i+8*b]);
+                        }
+                        continue;
+                    case 10:
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            x[i] = (*reinterpret_cast<fun_type10>(pTok->Fun.ptr))(x[i], x[i+b], x[i+2*b], x[i+3*b],
+                                                                                  x[i+4*b], x[i+5*b], x[i+6*b],
+                                                                                  x[i+7*b], x[i+8*b], x[i+9*b]);
+                        }
+                        continue;
+                    default:
+                    {
+                        if (iArgCount>0) // function with variable arguments store the number as a negative value
+                        {
+                            Error(ecINTERNAL_ERROR, 1);
+                        }
+
+                        // Gather arguments of each lane, function expects them in a row.
+                        QVector<qreal> args(n);
+                        for (int i = 0; i < nLanes; ++i)
+                        {
+                            for (int j = 0; j < n; ++j)
+                            {
+                                args[j] = x[j * s_BulkBlockSize + i];
+                            }
+                            x[i] = (*reinterpret_cast<multfun_type>(pTok->Fun.ptr))(args.data(), n);
+                        }
+                        continue;
+                    }
+                }
+#ifdef Q_CC_CLANG
+    #pragma clang diagnostic pop
+#endif
+            }
+            default:
+                Error(ecINTERNAL_ERROR, 3);
+                return;
+        } // switch CmdCode
+    } // for all bytecode tokens
+
+    const qreal *result = Stack + m_nFinalResultIdx * s_BulkBlockSize;
+    for (int i = 0; i < nLanes; ++i)
+    {
+        results[i] = result[i];
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void QmuParserBase::CreateRPN() const
 {
@@ -1551,7 +2001,7 @@ qreal QmuParserBase::ParseString() const
     try
     {
         CreateRPN();
-        m_pParseFormula = &QmuParserBase::ParseCmdCode;
+        SetCmdCodeParser();
         return (this->*m_pParseFormula)();
     }
     catch (qmu::QmuParserError &exc)
@@ -1686,6 +2136,20 @@ void QmuParserBase::EnableOptimizer(bool a_bIsOn)
     ReInit();
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Enable or disable compilation of bytecode to native code.
+ *
+ * Bytecode that can't be compiled (or platform without native code support) is evaluated by interpreter.
+ * @post Resets the parser to string parser mode.
+ * @throw nothrow
+ */
+void QmuParserBase::EnableJit(bool a_bIsOn)
+{
+    m_bJit = a_bIsOn;
+    ReInit();
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief Enable the dumping of bytecode amd stack content on the console.
@@ -1842,10 +2306,29 @@ qreal* QmuParserBase::Eval(int &nStackSize) const
 }
 
 //---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Evaluate the expression for an array of variable values.
+ *
+ * Each variable points to an array of nBulkSize values, one for each lane. If the bytecode contains only operators,
+ * values and numeric functions it is executed once for blocks of s_BulkBlockSize lanes, otherwise every lane is
+ * evaluated separately.
+ * @param results array of nBulkSize values for the results.
+ * @param nBulkSize number of lanes.
+ */
 void QmuParserBase::Eval(qreal *results, int nBulkSize) const
 {
     CreateRPN();
 
+    if (IsLanesCode())
+    {
+        QVector<qreal> stack(m_vRPN.GetMaxStackSize() * s_BulkBlockSize);
+        for (int lane = 0; lane < nBulkSize; lane += s_BulkBlockSize)
+        {
+            ParseCmdCodeLanes(results + lane, lane, qMin(s_BulkBlockSize, nBulkSize - lane), stack.data());
+        }
+        return;
+    }
+
     int i = 0;
 
     #ifdef QMUP_USE_OPENMP
@@ -1904,6 +2387,9 @@ void QmuParserBase::Eval(qreal *results, int nBulkSize) const
  * @brief Set a function that can create variable pointer for unknown expression variables.
  * @param a_pFactory A pointer to the variable factory.
  * @param pUserData A user defined context pointer.
+ *
+ * The factory can return nullptr if a variable with this name can't exist. Parsing will stop with error
+ * ecUNASSIGNABLE_TOKEN at position of the name.
  */
 // cppcheck-suppress unusedFunction
 void qmu::QmuParserBase::SetVarFactory(facfun_type a_pFactory, void *pUserData)
@@ -30,7 +30,9 @@
 
 #include "qmuparserdef.h"
 #include "qmuparsertokenreader.h"
+#include "qmuparsercharset.h"
 #include "qmuparserbytecode.h"
+#include "qmuparserjit.h"
 
 namespace qmu
 {
@@ -65,11 +67,14 @@ public:
     void               Eval(qreal *results, int nBulkSize) const;
     int                GetNumResults() const;
     void               SetExpr(const QString &a_sExpr);
+    const QmuParserByteCode& GetByteCode() const;
+    void               SetByteCode(const QmuParserByteCode &a_ByteCode, int a_nNumResults);
     void               SetVarFactory(facfun_type a_pFactory, void *pUserData = nullptr);
     void               SetDecSep(char_type cDecSep);
     void               SetThousandsSep(char_type cThousandsSep = 0);
     void               ResetLocale();
     void               EnableOptimizer(bool a_bIsOn=true);
+    void               EnableJit(bool a_bIsOn=true);
     void               EnableBuiltInOprt(bool a_bIsOn=true);
     bool               HasBuiltInOprt() const;
     void               AddValIdent(identfun_type a_pCallback);
@@ -99,11 +104,16 @@ public:
     QMap<int, QString> GetTokens() const;
     QMap<int, QString> GetNumbers() const;
     void               DefineNameChars(const QString &a_szCharset);
+    void               DefineNameChars(const QString &a_szCharset, const QmuParserCharSet &a_CharSet);
     void               DefineOprtChars(const QString &a_szCharset);
+    void               DefineOprtChars(const QString &a_szCharset, const QmuParserCharSet &a_CharSet);
     void               DefineInfixOprtChars(const QString &a_szCharset);
     const QString&     ValidNameChars() const;
     const QString&     ValidOprtChars() const;
     const QString&     ValidInfixOprtChars() const;
+    const QmuParserCharSet& NameCharSet() const;
+    const QmuParserCharSet& OprtCharSet() const;
+    const QmuParserCharSet& InfixOprtCharSet() const;
     void               SetArgSep(char_type cArgSep);
     QChar              GetArgSep() const;
     void Q_NORETURN    Error(EErrorCodes a_iErrc, int a_iPos = -1, const QString &a_strTok = QString() ) const;
@@ -118,7 +128,7 @@ public:
     template<typename T>
     void DefineFun(const QString &a_strName, T a_pFun, bool a_bAllowOpt = true)
     {
-        AddCallback( a_strName, QmuParserCallback(a_pFun, a_bAllowOpt), m_FunDef, ValidNameChars() );
+        AddCallback( a_strName, QmuParserCallback(a_pFun, a_bAllowOpt), m_FunDef, NameCharSet() );
     }
     void setAllowSubexpressions(bool value);
 
@@ -203,6 +213,11 @@ private:
      */
     static const int s_MaxNumOpenMPThreads = 4;
 
+    /**
+     * @brief Number of lanes evaluated together by the vectorized bulk interpreter.
+     */
+    static const int s_BulkBlockSize = 64;
+
     /**
      * @brief Pointer to the parser function.
      *
@@ -224,10 +239,16 @@ private:
     varmap_type  m_VarDef;         ///< user defind variables.
 
     bool m_bBuiltInOp;             ///< Flag that can be used for switching built in operators on and off
+    bool m_bJit;                   ///< Flag that can be used for switching native code compilation on and off
+    mutable std::unique_ptr<QmuParserJit> m_pJit; ///< Native code of bytecode, used if compilation succeeded
+    mutable QVector<qreal*> m_vJitVars;           ///< Variable pointers for native code in bytecode order
 
     QString m_sNameChars;      ///< Charset for names
     QString m_sOprtChars;      ///< Charset for postfix/ binary operator tokens
     QString m_sInfixOprtChars; ///< Charset for infix operator tokens
+    QmuParserCharSet m_NameCharSet;      ///< Lookup table of m_sNameChars
+    QmuParserCharSet m_OprtCharSet;      ///< Lookup table of m_sOprtChars
+    QmuParserCharSet m_InfixOprtCharSet; ///< Lookup table of m_sInfixOprtChars
 
     mutable int m_nIfElseCounter;  ///< Internal counter for keeping track of nested if-then-else clauses
 
@@ -243,7 +264,7 @@ private:
     void               InitTokenReader();
     void               ReInit() const;
     void               AddCallback(const QString &a_strName, const QmuParserCallback &a_Callback,
-                                   funmap_type &a_Storage, const QString &a_szCharSet );
+                                   funmap_type &a_Storage, const QmuParserCharSet &a_CharSet );
     void               ApplyRemainingOprt(QStack<token_type> &a_stOpt, QStack<token_type> &a_stVal) const;
     void               ApplyBinOprt(QStack<token_type> &a_stOpt, QStack<token_type> &a_stVal) const;
     void               ApplyIfElse(QStack<token_type> &a_stOpt, QStack<token_type> &a_stVal) const;
@@ -254,10 +275,14 @@ private:
     void               CreateRPN() const;
     qreal              ParseString() const;
     qreal              ParseCmdCode() const;
+    qreal              ParseJitCode() const;
+    void               SetCmdCodeParser() const;
     qreal              ParseCmdCodeBulk(int nOffset, int nThreadID) const;
-    void               CheckName(const QString &a_strName, const QString &a_CharSet) const;
+    bool               IsLanesCode() const;
+    void               ParseCmdCodeLanes(qreal *results, int nOffset, int nLanes, qreal *Stack) const;
+    void               CheckName(const QString &a_strName, const QmuParserCharSet &a_CharSet) const;
     void               CheckOprt(const QString &a_sName, const QmuParserCallback &a_Callback,
-                                 const QString &a_szCharSet) const;
+                                 const QmuParserCharSet &a_CharSet) const;
     void               StackDump(const QStack<token_type > &a_stVal, const QStack<token_type > &a_stOprt) const;
 };
 
@@ -308,6 +333,17 @@ inline QMap<int, QString> QmuParserBase::GetNumbers() const
     return m_Numbers;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Return the bytecode of the last parsed formula.
+ *
+ * Bytecode is valid only after the formula was evaluated at least once.
+ */
+inline const QmuParserByteCode &QmuParserBase::GetByteCode() const
+{
+    return m_vRPN;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief Define the set of valid characters to be used in names of functions, variables, constants.
@@ -315,6 +351,19 @@ inline QMap<int, QString> QmuParserBase::GetNumbers() const
 inline void QmuParserBase::DefineNameChars(const QString &a_szCharset)
 {
     m_sNameChars = a_szCharset;
+    m_NameCharSet = QmuParserCharSet(a_szCharset);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Define the set of valid characters to be used in names of functions, variables, constants.
+ *
+ * Lookup table is given by caller, it must contain the same characters as a_szCharset.
+ */
+inline void QmuParserBase::DefineNameChars(const QString &a_szCharset, const QmuParserCharSet &a_CharSet)
+{
+    m_sNameChars = a_szCharset;
+    m_NameCharSet = a_CharSet;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -324,6 +373,19 @@ inline void QmuParserBase::DefineNameChars(const QString &a_szCharset)
 inline void QmuParserBase::DefineOprtChars(const QString &a_szCharset)
 {
     m_sOprtChars = a_szCharset;
+    m_OprtCharSet = QmuParserCharSet(a_szCharset);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Define the set of valid characters to be used in names of binary operators and postfix operators.
+ *
+ * Lookup table is given by caller, it must contain the same characters as a_szCharset.
+ */
+inline void QmuParserBase::DefineOprtChars(const QString &a_szCharset, const QmuParserCharSet &a_CharSet)
+{
+    m_sOprtChars = a_szCharset;
+    m_OprtCharSet = a_CharSet;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -333,6 +395,34 @@ inline void QmuParserBase::DefineOprtChars(const QString &a_szCharset)
 inline void QmuParserBase::DefineInfixOprtChars(const QString &a_szCharset)
 {
     m_sInfixOprtChars = a_szCharset;
+    m_InfixOprtCharSet = QmuParserCharSet(a_szCharset);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Return lookup table of characters valid in names.
+ */
+inline const QmuParserCharSet &QmuParserBase::NameCharSet() const
+{
+    return m_NameCharSet;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Return lookup table of characters valid in binary operator and postfix operator names.
+ */
+inline const QmuParserCharSet &QmuParserBase::OprtCharSet() const
+{
+    return m_OprtCharSet;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Return lookup table of characters valid in infix operator names.
+ */
+inline const QmuParserCharSet &QmuParserBase::InfixOprtCharSet() const
+{
+    return m_InfixOprtCharSet;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
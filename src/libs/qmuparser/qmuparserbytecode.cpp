@@ -516,6 +516,71 @@ const SToken* QmuParserByteCode::GetBase() const
     }
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Return pointers of all variables referenced by the bytecode.
+ *
+ * Pointers are returned in the order the tokens appear in the bytecode, one entry per token. A variable used twice
+ * in a formula can appear twice.
+ */
+QVector<qreal *> QmuParserByteCode::GetVarPtrs() const
+{
+    QVector<qreal *> ptrs;
+    for (int i=0; i<m_vRPN.size(); ++i)
+    {
+        switch (m_vRPN.at(i).Cmd)
+        {
+            case cmVAR:
+            case cmVARPOW2:
+            case cmVARPOW3:
+            case cmVARPOW4:
+            case cmVARMUL:
+                ptrs.append(m_vRPN.at(i).Val.ptr);
+                break;
+            case cmASSIGN:
+                ptrs.append(m_vRPN.at(i).Oprt.ptr);
+                break;
+            default:
+                break;
+        }
+    }
+    return ptrs;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Replace pointers of all variables referenced by the bytecode.
+ *
+ * Allow reuse finalized bytecode with other storage of variables. Pointers must be in the same order as
+ * GetVarPtrs() returns them.
+ *
+ * @param a_vPtrs new pointers of variables.
+ */
+void QmuParserByteCode::SetVarPtrs(const QVector<qreal *> &a_vPtrs)
+{
+    int j = 0;
+    for (int i=0; i<m_vRPN.size(); ++i)
+    {
+        switch (m_vRPN.at(i).Cmd)
+        {
+            case cmVAR:
+            case cmVARPOW2:
+            case cmVARPOW3:
+            case cmVARPOW4:
+            case cmVARMUL:
+                Q_ASSERT(j < a_vPtrs.size());
+                m_vRPN[i].Val.ptr = a_vPtrs.at(j++);
+                break;
+            case cmASSIGN:
+                Q_ASSERT(j < a_vPtrs.size());
+                m_vRPN[i].Oprt.ptr = a_vPtrs.at(j++);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief Delete the bytecode.
@@ -23,6 +23,7 @@
 #ifndef QMUPARSERBYTECODE_H
 #define QMUPARSERBYTECODE_H
 
+#include "qmuparser_global.h"
 #include "qmuparserdef.h"
 #include "qmuparsertoken.h"
 
@@ -84,7 +85,7 @@ struct SToken
  *
  * @author (C) 2004-2013 Ingo Berg
  */
-class QmuParserByteCode
+class QMUPARSERSHARED_EXPORT QmuParserByteCode
 {
 public:
     QmuParserByteCode();
@@ -105,6 +106,8 @@ public:
     int           GetMaxStackSize() const;
     int           GetSize() const;
     const SToken* GetBase() const;
+    QVector<qreal*> GetVarPtrs() const;
+    void          SetVarPtrs(const QVector<qreal*> &a_vPtrs);
     void          AsciiDump();
 private:
     /** @brief Token type for internal use only. */
@@ -0,0 +1,125 @@
+/***************************************************************************************************
+ **
+ **  Copyright 2026 Roman Telezhynskyi <dismine(at)gmail.com>
+ **
+ **  Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ **  software and associated documentation files (the "Software"), to deal in the Software
+ **  without restriction, including without limitation the rights to use, copy, modify,
+ **  merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ **  permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ **
+ **  The above copyright notice and this permission notice shall be included in all copies or
+ **  substantial portions of the Software.
+ **
+ **  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ **  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ **  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ **  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ **  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **
+ ******************************************************************************************************/
+
+#include "qmuparsercharset.h"
+
+#include <cassert>
+
+/**
+ * @file
+ * @brief Implementation of the character set used by the token reader.
+ */
+
+namespace qmu
+{
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Constructor of empty set.
+ */
+QmuParserCharSet::QmuParserCharSet()
+    :m_iAscii(), m_vOther(), m_pIndex(nullptr), m_pBlocks(nullptr)
+{
+    m_iAscii[0] = 0;
+    m_iAscii[1] = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Constructor.
+ *
+ * @param a_sChars all characters of set. Duplicates are allowed.
+ */
+QmuParserCharSet::QmuParserCharSet(const QString &a_sChars)
+    :m_iAscii(), m_vOther(), m_pIndex(nullptr), m_pBlocks(nullptr)
+{
+    m_iAscii[0] = 0;
+    m_iAscii[1] = 0;
+    Add(a_sChars);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Constructor of set with static table.
+ *
+ * Tables are not copied and must live while set is used.
+ *
+ * @param a_sChars characters of set in addition to table.
+ * @param a_pIndex index of bitmap in a_pBlocks for each high byte of character (256 items).
+ * @param a_pBlocks bitmaps of low byte of character.
+ */
+QmuParserCharSet::QmuParserCharSet(const QString &a_sChars, const quint8 *a_pIndex, const quint64 (*a_pBlocks)[4])
+    :m_iAscii(), m_vOther(), m_pIndex(a_pIndex), m_pBlocks(a_pBlocks)
+{
+    assert(a_pIndex != nullptr && a_pBlocks != nullptr);
+
+    // ASCII characters are always checked by bitmap
+    m_iAscii[0] = m_pBlocks[m_pIndex[0]][0];
+    m_iAscii[1] = m_pBlocks[m_pIndex[0]][1];
+    Add(a_sChars);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Add characters to set.
+ *
+ * @param a_sChars characters. Duplicates are allowed.
+ */
+void QmuParserCharSet::Add(const QString &a_sChars)
+{
+    for (int i = 0; i < a_sChars.size(); ++i)
+    {
+        const ushort c = a_sChars.at(i).unicode();
+        if (c < 128)
+        {
+            m_iAscii[c >> 6] |= Q_UINT64_C(1) << (c & 63);
+        }
+        else if (InTable(c) == false)
+        {
+            m_vOther.append(c);
+        }
+    }
+
+    std::sort(m_vOther.begin(), m_vOther.end());
+    m_vOther.erase(std::unique(m_vOther.begin(), m_vOther.end()), m_vOther.end());
+    m_vOther.squeeze();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Find end of sequence of characters from set.
+ *
+ * @param a_sStr string.
+ * @param a_iPos position in the string from where to start reading.
+ * @return position of the first character not in set or size of the string.
+ */
+int QmuParserCharSet::Span(const QString &a_sStr, int a_iPos) const
+{
+    const QChar *pStr = a_sStr.constData();
+    const int iSize = a_sStr.size();
+    int i = a_iPos;
+    while (i < iSize && Contains(pStr[i]))
+    {
+        ++i;
+    }
+    return i;
+}
+
+} // namespace qmu
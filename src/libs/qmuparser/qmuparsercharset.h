@@ -0,0 +1,108 @@
+/***************************************************************************************************
+ **
+ **  Copyright 2026 Roman Telezhynskyi <dismine(at)gmail.com>
+ **
+ **  Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ **  software and associated documentation files (the "Software"), to deal in the Software
+ **  without restriction, including without limitation the rights to use, copy, modify,
+ **  merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ **  permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ **
+ **  The above copyright notice and this permission notice shall be included in all copies or
+ **  substantial portions of the Software.
+ **
+ **  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ **  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ **  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ **  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ **  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **
+ ******************************************************************************************************/
+
+#ifndef QMUPARSERCHARSET_H
+#define QMUPARSERCHARSET_H
+
+#include "qmuparser_global.h"
+
+#include <QString>
+#include <QVector>
+
+#include <algorithm>
+
+/**
+ * @file
+ * @brief Definition of the character set used by the token reader.
+ */
+
+namespace qmu
+{
+/**
+ * @brief Set of characters allowed in a kind of token.
+ *
+ * Character sets of parser can be very long (names can contain letters of many alphabets), so searching character in
+ * the string for every character of formula is slow. Set is built once when character set is defined. ASCII characters
+ * are checked by bitmap, other characters by binary search in sorted table.
+ *
+ * Big set can be given as static two-level table: index of bitmap for high byte of character and bitmaps of 256 bits
+ * for low byte. Such table is generated beforehand (see scripts/alphabets.py), check of any character takes constant
+ * time and set doesn't need to be built at runtime.
+ */
+class QMUPARSERSHARED_EXPORT QmuParserCharSet
+{
+public:
+    QmuParserCharSet();
+    explicit QmuParserCharSet(const QString &a_sChars);
+    QmuParserCharSet(const QString &a_sChars, const quint8 *a_pIndex, const quint64 (*a_pBlocks)[4]);
+
+    bool Contains(const QChar &a_cChar) const;
+    int  Span(const QString &a_sStr, int a_iPos) const;
+private:
+    /** @brief Bitmap of ASCII characters. */
+    quint64         m_iAscii[2];
+    /** @brief Sorted table of other characters. */
+    QVector<ushort> m_vOther;
+    /** @brief Index of bitmap in m_pBlocks for high byte of character. Null if set doesn't have static table. */
+    const quint8   *m_pIndex;
+    /** @brief Bitmaps of low byte of character. */
+    const quint64 (*m_pBlocks)[4];
+
+    void            Add(const QString &a_sChars);
+    bool            InTable(ushort a_iChar) const;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Check if character belongs to set.
+ */
+inline bool QmuParserCharSet::Contains(const QChar &a_cChar) const
+{
+    const ushort c = a_cChar.unicode();
+    if (c < 128)
+    {
+        return ((m_iAscii[c >> 6] >> (c & 63)) & 1) != 0;
+    }
+    if (InTable(c))
+    {
+        return true;
+    }
+    return m_vOther.isEmpty() == false && std::binary_search(m_vOther.constBegin(), m_vOther.constEnd(), c);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Check if character is in static table.
+ */
+inline bool QmuParserCharSet::InTable(ushort a_iChar) const
+{
+    if (m_pIndex == nullptr)
+    {
+        return false;
+    }
+    const quint64 *pBlock = m_pBlocks[m_pIndex[a_iChar >> 8]];
+    const int iLow = a_iChar & 0xFF;
+    return ((pBlock[iLow >> 6] >> (iLow & 63)) & 1) != 0;
+}
+
+} // namespace qmu
+
+#endif // QMUPARSERCHARSET_H
@@ -0,0 +1,913 @@
+/***************************************************************************************************
+ **
+ **  Copyright 2026 Roman Telezhynskyi <dismine(at)gmail.com>
+ **
+ **  Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ **  software and associated documentation files (the "Software"), to deal in the Software
+ **  without restriction, including without limitation the rights to use, copy, modify,
+ **  merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ **  permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ **
+ **  The above copyright notice and this permission notice shall be included in all copies or
+ **  substantial portions of the Software.
+ **
+ **  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ **  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ **  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ **  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ **  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **
+ ******************************************************************************************************/
+
+#include "qmuparserderivative.h"
+
+#include <QtCore/qmath.h>
+
+/**
+ * @file
+ * @brief Implementation of the symbolic derivative generator for parser bytecode.
+ */
+
+namespace qmu
+{
+
+/**
+ * @brief Node of expression tree. Arguments are indexes of other nodes.
+ */
+struct QmuDiffNode
+{
+    QmuDiffNode()
+        :Cmd(cmUNKNOWN), Ptr(nullptr), Mul(0), Val(0), Fun(nullptr), Argc(0), Args()
+    {}
+
+    ECmdCode         Cmd;
+    /** @brief Ptr variable of cmVAR, cmVARMUL and cmVARPOW2-4. */
+    qreal           *Ptr;
+    /** @brief Mul multiplier of cmVARMUL. */
+    qreal            Mul;
+    /** @brief Val value of cmVAL, offset of cmVARMUL. */
+    qreal            Val;
+    /** @brief Fun callback of cmFUNC. */
+    generic_fun_type Fun;
+    /** @brief Argc number of arguments of cmFUNC as it is stored in bytecode (negative for multiarg functions). */
+    int              Argc;
+    QVector<int>     Args;
+};
+
+/**
+ * @brief Expression tree of bytecode. Nodes of derivative are appended to the same tree, so they can use nodes of
+ * original expression.
+ */
+struct QmuDiffTree
+{
+    QmuDiffTree()
+        :Nodes(), Var(nullptr), Supported(true)
+    {}
+
+    QVector<QmuDiffNode> Nodes;
+    /** @brief Var variable of differentiation. */
+    const qreal         *Var;
+    /** @brief Supported false if tree has function without rule of differentiation. */
+    bool                 Supported;
+};
+
+/** @brief Index of node for zero derivative. Zeros are not stored, so expressions with them are simplified. */
+static const int iZeroNode = -1;
+
+//---------------------------------------------------------------------------------------------------------------------
+static qreal DiffLn(qreal a_fVal)
+{
+    return qLn(a_fVal);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static int AddNode(QmuDiffTree &a_Tree, const QmuDiffNode &a_Node)
+{
+    a_Tree.Nodes.append(a_Node);
+    return a_Tree.Nodes.size() - 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static int Value(QmuDiffTree &a_Tree, qreal a_fVal)
+{
+    QmuDiffNode node;
+    node.Cmd = cmVAL;
+    node.Val = a_fVal;
+    return AddNode(a_Tree, node);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static int Variable(QmuDiffTree &a_Tree, ECmdCode a_iCmd, qreal *a_pVar)
+{
+    QmuDiffNode node;
+    node.Cmd = a_iCmd;
+    node.Ptr = a_pVar;
+    return AddNode(a_Tree, node);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static int Operator(QmuDiffTree &a_Tree, ECmdCode a_iCmd, int a_iLeft, int a_iRight)
+{
+    QmuDiffNode node;
+    node.Cmd = a_iCmd;
+    node.Args << a_iLeft << a_iRight;
+    return AddNode(a_Tree, node);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static int Function(QmuDiffTree &a_Tree, generic_fun_type a_pFun, int a_iArgc, const QVector<int> &a_vArgs)
+{
+    QmuDiffNode node;
+    node.Cmd = cmFUNC;
+    node.Fun = a_pFun;
+    node.Argc = a_iArgc;
+    node.Args = a_vArgs;
+    return AddNode(a_Tree, node);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static bool IsValue(const QmuDiffTree &a_Tree, int a_iNode, qreal a_fVal)
+{
+    return a_iNode != iZeroNode && a_Tree.Nodes.at(a_iNode).Cmd == cmVAL
+            && qFuzzyCompare(a_Tree.Nodes.at(a_iNode).Val + 1, a_fVal + 1);
+}
+
+// Operators for nodes of derivative. They skip zeros and multiplication by one.
+
+//---------------------------------------------------------------------------------------------------------------------
+static int Add(QmuDiffTree &a_Tree, int a_iLeft, int a_iRight)
+{
+    if (a_iLeft == iZeroNode)
+    {
+        return a_iRight;
+    }
+    if (a_iRight == iZeroNode)
+    {
+        return a_iLeft;
+    }
+    return Operator(a_Tree, cmADD, a_iLeft, a_iRight);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static int Mul(QmuDiffTree &a_Tree, int a_iLeft, int a_iRight)
+{
+    if (a_iLeft == iZeroNode || a_iRight == iZeroNode)
+    {
+        return iZeroNode;
+    }
+    if (IsValue(a_Tree, a_iLeft, 1))
+    {
+        return a_iRight;
+    }
+    if (IsValue(a_Tree, a_iRight, 1))
+    {
+        return a_iLeft;
+    }
+    return Operator(a_Tree, cmMUL, a_iLeft, a_iRight);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static int Sub(QmuDiffTree &a_Tree, int a_iLeft, int a_iRight)
+{
+    if (a_iRight == iZeroNode)
+    {
+        return a_iLeft;
+    }
+    if (a_iLeft == iZeroNode)
+    {
+        return Mul(a_Tree, Value(a_Tree, -1), a_iRight);
+    }
+    return Operator(a_Tree, cmSUB, a_iLeft, a_iRight);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static int Div(QmuDiffTree &a_Tree, int a_iLeft, int a_iRight)
+{
+    if (a_iLeft == iZeroNode)
+    {
+        return iZeroNode;
+    }
+    return Operator(a_Tree, cmDIV, a_iLeft, a_iRight);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Convert bytecode to expression tree.
+ * @return index of root node or iZeroNode if bytecode has unsupported tokens or more than one result.
+ */
+static int BuildTree(const QmuParserByteCode &a_ByteCode, QmuDiffTree &a_Tree)
+{
+    QVector<int> stack;
+    for (const SToken *pTok = a_ByteCode.GetBase(); pTok->Cmd != cmEND; ++pTok)
+    {
+        switch (pTok->Cmd)
+        {
+            case cmVAL:
+                stack.append(Value(a_Tree, pTok->Val.data2));
+                break;
+            case cmVAR:
+            case cmVARPOW2:
+            case cmVARPOW3:
+            case cmVARPOW4:
+                stack.append(Variable(a_Tree, pTok->Cmd, pTok->Val.ptr));
+                break;
+            case cmVARMUL:
+            {
+                QmuDiffNode node;
+                node.Cmd = cmVARMUL;
+                node.Ptr = pTok->Val.ptr;
+                node.Mul = pTok->Val.data;
+                node.Val = pTok->Val.data2;
+                stack.append(AddNode(a_Tree, node));
+                break;
+            }
+            case cmLE:
+            case cmGE:
+            case cmNEQ:
+            case cmEQ:
+            case cmLT:
+            case cmGT:
+            case cmADD:
+            case cmSUB:
+            case cmMUL:
+            case cmDIV:
+            case cmPOW:
+            case cmLAND:
+            case cmLOR:
+            {
+                if (stack.size() < 2)
+                {
+                    return iZeroNode;
+                }
+                const int iRight = stack.takeLast();
+                const int iLeft = stack.takeLast();
+                stack.append(Operator(a_Tree, pTok->Cmd, iLeft, iRight));
+                break;
+            }
+            case cmFUNC:
+            {
+                const int iArgCount = (pTok->Fun.argc >= 0) ? pTok->Fun.argc : -pTok->Fun.argc;
+                if (stack.size() < iArgCount)
+                {
+                    return iZeroNode;
+                }
+                const QVector<int> args = stack.mid(stack.size() - iArgCount);
+                stack.resize(stack.size() - iArgCount);
+                stack.append(Function(a_Tree, pTok->Fun.ptr, pTok->Fun.argc, args));
+                break;
+            }
+            default:
+                return iZeroNode;
+        }
+    }
+    return (stack.size() == 1) ? stack.first() : iZeroNode;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Write subtree to bytecode.
+ */
+static void Emit(const QmuDiffTree &a_Tree, int a_iNode, QmuParserByteCode &a_ByteCode)
+{
+    const QmuDiffNode &node = a_Tree.Nodes.at(a_iNode);
+    switch (node.Cmd)
+    {
+        case cmVAL:
+            a_ByteCode.AddVal(node.Val);
+            break;
+        case cmVAR:
+            a_ByteCode.AddVar(node.Ptr);
+            break;
+        case cmVARPOW2:
+        case cmVARPOW3:
+        case cmVARPOW4:
+            // Optimizer of bytecode makes the same token again
+            a_ByteCode.AddVar(node.Ptr);
+            a_ByteCode.AddVal(node.Cmd - cmVARPOW2 + 2);
+            a_ByteCode.AddOp(cmPOW);
+            break;
+        case cmVARMUL:
+            a_ByteCode.AddVar(node.Ptr);
+            a_ByteCode.AddVal(node.Mul);
+            a_ByteCode.AddOp(cmMUL);
+            a_ByteCode.AddVal(node.Val);
+            a_ByteCode.AddOp(cmADD);
+            break;
+        case cmFUNC:
+            for (int i = 0; i < node.Args.size(); ++i)
+            {
+                Emit(a_Tree, node.Args.at(i), a_ByteCode);
+            }
+            a_ByteCode.AddFun(node.Fun, node.Argc);
+            break;
+        default:
+            Emit(a_Tree, node.Args.at(0), a_ByteCode);
+            Emit(a_Tree, node.Args.at(1), a_ByteCode);
+            a_ByteCode.AddOp(node.Cmd);
+            break;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Calculate comparison or logical operator the same way parser does.
+ */
+static qreal Compare(ECmdCode a_iCmd, qreal a_fLeft, qreal a_fRight)
+{
+    switch (a_iCmd)
+    {
+        case cmLE:
+            return a_fLeft <= a_fRight;
+        case cmGE:
+            return a_fLeft >= a_fRight;
+        case cmNEQ:
+            return qFuzzyCompare(a_fLeft, a_fRight) == false;
+        case cmEQ:
+            return qFuzzyCompare(a_fLeft, a_fRight);
+        case cmLT:
+            return a_fLeft < a_fRight;
+        case cmGT:
+            return a_fLeft > a_fRight;
+#ifdef Q_CC_GNU
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wfloat-equal"
+#endif
+        case cmLAND:
+            return static_cast<bool>(a_fLeft) && static_cast<bool>(a_fRight);
+        case cmLOR:
+            return static_cast<bool>(a_fLeft) || static_cast<bool>(a_fRight);
+#ifdef Q_CC_GNU
+    #pragma GCC diagnostic pop
+#endif
+        default:
+            return 0;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Call callback of numeric function.
+ * @param a_iArgc number of arguments as it is stored in bytecode (negative for multiarg functions).
+ */
+static qreal CallFunction(generic_fun_type a_pFun, int a_iArgc, const qreal *a_afArg)
+{
+#ifdef Q_CC_CLANG
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wundefined-reinterpret-cast"
+#endif
+    switch (a_iArgc)
+    {
+        case 0:
+            return (*reinterpret_cast<fun_type0>(a_pFun))();
+        case 1:
+            return (*reinterpret_cast<fun_type1>(a_pFun))(a_afArg[0]);
+        case 2:
+            return (*reinterpret_cast<fun_type2>(a_pFun))(a_afArg[0], a_afArg[1]);
+        case 3:
+            return (*reinterpret_cast<fun_type3>(a_pFun))(a_afArg[0], a_afArg[1], a_afArg[2]);
+        case 4:
+            return (*reinterpret_cast<fun_type4>(a_pFun))(a_afArg[0], a_afArg[1], a_afArg[2], a_afArg[3]);
+        case 5:
+            return (*reinterpret_cast<fun_type5>(a_pFun))(a_afArg[0], a_afArg[1], a_afArg[2], a_afArg[3],
+                                                          a_afArg[4]);
+        case 6:
+            return (*reinterpret_cast<fun_type6>(a_pFun))(a_afArg[0], a_afArg[1], a_afArg[2], a_afArg[3],
+                                                          a_afArg[4], a_afArg[5]);
+        case 7:
+            return (*reinterpret_cast<fun_type7>(a_pFun))(a_afArg[0], a_afArg[1], a_afArg[2], a_afArg[3],
+                                                          a_afArg[4], a_afArg[5], a_afArg[6]);
+        case 8:
+            return (*reinterpret_cast<fun_type8>(a_pFun))(a_afArg[0], a_afArg[1], a_afArg[2], a_afArg[3],
+                                                          a_afArg[4], a_afArg[5], a_afArg[6], a_afArg[7]);
+        case 9:
+            return (*reinterpret_cast<fun_type9>(a_pFun))(a_afArg[0], a_afArg[1], a_afArg[2], a_afArg[3],
+                                                          a_afArg[4], a_afArg[5], a_afArg[6], a_afArg[7], a_afArg[8]);
+        case 10:
+            return (*reinterpret_cast<fun_type10>(a_pFun))(a_afArg[0], a_afArg[1], a_afArg[2], a_afArg[3],
+                                                           a_afArg[4], a_afArg[5], a_afArg[6], a_afArg[7], a_afArg[8],
+                                                           a_afArg[9]);
+        default:
+            return (*reinterpret_cast<multfun_type>(a_pFun))(a_afArg, -a_iArgc);
+    }
+#ifdef Q_CC_CLANG
+    #pragma clang diagnostic pop
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+QmuParserDerivative::QmuParserDerivative()
+    :m_vRules()
+{}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Define derivative of function with one argument.
+ * @param a_pFun callback of function.
+ * @param a_pDiff callback that calculates derivative of function, nullptr if derivative is zero.
+ */
+void QmuParserDerivative::DefineDiff(fun_type1 a_pFun, fun_type1 a_pDiff)
+{
+    SDiffRule rule;
+    rule.Fun = reinterpret_cast<generic_fun_type>(a_pFun);
+    rule.Argc = 1;
+    rule.Diff[0] = reinterpret_cast<generic_fun_type>(a_pDiff);
+    rule.Diff[1] = nullptr;
+    rule.Sum = false;
+    rule.Mean = false;
+    rule.Select = false;
+    m_vRules.append(rule);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Define derivative of function with two arguments.
+ * @param a_pFun callback of function.
+ * @param a_pDiff1 callback of partial derivative by first argument, nullptr if it is zero.
+ * @param a_pDiff2 callback of partial derivative by second argument, nullptr if it is zero.
+ */
+void QmuParserDerivative::DefineDiff(fun_type2 a_pFun, fun_type2 a_pDiff1, fun_type2 a_pDiff2)
+{
+    SDiffRule rule;
+    rule.Fun = reinterpret_cast<generic_fun_type>(a_pFun);
+    rule.Argc = 2;
+    rule.Diff[0] = reinterpret_cast<generic_fun_type>(a_pDiff1);
+    rule.Diff[1] = reinterpret_cast<generic_fun_type>(a_pDiff2);
+    rule.Sum = false;
+    rule.Mean = false;
+    rule.Select = false;
+    m_vRules.append(rule);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Define derivative of function with any number of arguments that is sum or mean of arguments.
+ * @param a_pFun callback of function.
+ * @param a_bMean true if function calculates mean value.
+ */
+void QmuParserDerivative::DefineSumDiff(multfun_type a_pFun, bool a_bMean)
+{
+    SDiffRule rule;
+    rule.Fun = reinterpret_cast<generic_fun_type>(a_pFun);
+    rule.Argc = -1;
+    rule.Diff[0] = nullptr;
+    rule.Diff[1] = nullptr;
+    rule.Sum = true;
+    rule.Mean = a_bMean;
+    rule.Select = false;
+    m_vRules.append(rule);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Define derivative of function with any number of arguments that returns one of arguments (like min or max).
+ *
+ * Derivative of such function is derivative of selected argument. It is used only by EvalDual(), Derive() returns
+ * false if arguments depend on variable.
+ * @param a_pFun callback of function.
+ */
+void QmuParserDerivative::DefineSelectDiff(multfun_type a_pFun)
+{
+    SDiffRule rule;
+    rule.Fun = reinterpret_cast<generic_fun_type>(a_pFun);
+    rule.Argc = -1;
+    rule.Diff[0] = nullptr;
+    rule.Diff[1] = nullptr;
+    rule.Sum = false;
+    rule.Mean = false;
+    rule.Select = true;
+    m_vRules.append(rule);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Generate bytecode of derivative with regard to a variable.
+ *
+ * Derivative bytecode uses the same variable pointers as a_ByteCode, it is finalized and can be evaluated by parser
+ * (see QmuParserBase::SetByteCode()) or compiled to native code.
+ * @param [in] a_ByteCode finalized bytecode of expression with one result.
+ * @param [in] a_pVar pointer to the differentiation variable.
+ * @param [out] a_Derivative bytecode of derivative.
+ * @return false if expression can't be differentiated symbolically, a_Derivative is not changed.
+ */
+bool QmuParserDerivative::Derive(const QmuParserByteCode &a_ByteCode, const qreal *a_pVar,
+                                 QmuParserByteCode &a_Derivative) const
+{
+    QmuDiffTree tree;
+    tree.Var = a_pVar;
+
+    const int iRoot = BuildTree(a_ByteCode, tree);
+    if (iRoot == iZeroNode)
+    {
+        return false;
+    }
+
+    const int iDiff = Diff(tree, iRoot);
+    if (tree.Supported == false)
+    {
+        return false;
+    }
+
+    a_Derivative.clear();
+    a_Derivative.EnableOptimizer(true);
+    if (iDiff == iZeroNode)
+    {
+        a_Derivative.AddVal(0);
+    }
+    else
+    {
+        Emit(tree, iDiff, a_Derivative);
+    }
+    a_Derivative.Finalize();
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Evaluate bytecode over dual numbers.
+ *
+ * Each value of stack keeps its gradient, operators and functions apply rules of differentiation to gradients of
+ * arguments. Formula is evaluated once, there is no derivative bytecode. Variables without seed are constants.
+ * @param [in] a_ByteCode finalized bytecode of expression with one result.
+ * @param [in] a_Seeds dual values of independent variables by pointer to variable, value of seed replaces value of
+ * variable.
+ * @param [out] a_Result value of expression and its gradient.
+ * @return false if bytecode has function without rule of differentiation with variable arguments, string or bulk
+ * functions, assignments or more than one result. a_Result is not changed.
+ */
+bool QmuParserDerivative::EvalDual(const QmuParserByteCode &a_ByteCode, const QHash<const qreal *, QmuDual> &a_Seeds,
+                                   QmuDual &a_Result) const
+{
+    QVector<QmuDual> stack(a_ByteCode.GetMaxStackSize() + 1);
+    QVector<qreal> args;
+    int sidx = 0;
+    for (const SToken *pTok = a_ByteCode.GetBase(); pTok->Cmd != cmEND; ++pTok)
+    {
+        switch (pTok->Cmd)
+        {
+            case cmLE:
+            case cmGE:
+            case cmNEQ:
+            case cmEQ:
+            case cmLT:
+            case cmGT:
+            case cmLAND:
+            case cmLOR:
+            {
+                // Piecewise constant, parser calculates value
+                --sidx;
+                const qreal fLeft = stack.at(sidx).Val;
+                const qreal fRight = stack.at(sidx + 1).Val;
+                stack[sidx] = QmuDual(Compare(pTok->Cmd, fLeft, fRight));
+                break;
+            }
+            case cmADD:
+            case cmSUB:
+            {
+                --sidx;
+                const qreal fSign = (pTok->Cmd == cmADD) ? 1 : -1;
+                QmuDual &left = stack[sidx];
+                const QmuDual &right = stack.at(sidx + 1);
+                left.Val += fSign * right.Val;
+                for (int k = 0; k < QmuDual::Dim; ++k)
+                {
+                    left.Grad[k] += fSign * right.Grad[k];
+                }
+                break;
+            }
+            case cmMUL:
+            {
+                --sidx;
+                QmuDual &left = stack[sidx];
+                const QmuDual &right = stack.at(sidx + 1);
+                for (int k = 0; k < QmuDual::Dim; ++k)
+                {
+                    left.Grad[k] = left.Grad[k] * right.Val + left.Val * right.Grad[k];
+                }
+                left.Val *= right.Val;
+                break;
+            }
+            case cmDIV:
+            {
+                --sidx;
+                QmuDual &left = stack[sidx];
+                const QmuDual &right = stack.at(sidx + 1);
+                left.Val /= right.Val;
+                for (int k = 0; k < QmuDual::Dim; ++k)
+                {
+                    left.Grad[k] = (left.Grad[k] - left.Val * right.Grad[k]) / right.Val;
+                }
+                break;
+            }
+            case cmPOW:
+            {
+                --sidx;
+                QmuDual &left = stack[sidx];
+                const QmuDual &right = stack.at(sidx + 1);
+                const qreal fPow = qPow(left.Val, right.Val);
+                for (int k = 0; k < QmuDual::Dim; ++k)
+                {
+                    // (u^v)' = v*u^(v-1)*u' + u^v*ln(u)*v', terms with zero derivative are skipped to avoid NaN.
+                    qreal fGrad = 0;
+                    if (qFuzzyIsNull(left.Grad[k]) == false)
+                    {
+                        fGrad += right.Val * qPow(left.Val, right.Val - 1) * left.Grad[k];
+                    }
+                    if (qFuzzyIsNull(right.Grad[k]) == false)
+                    {
+                        fGrad += fPow * qLn(left.Val) * right.Grad[k];
+                    }
+                    left.Grad[k] = fGrad;
+                }
+                left.Val = fPow;
+                break;
+            }
+            case cmIF:
+                if (qFuzzyCompare(stack.at(sidx--).Val + 1, 1 + 0))
+                {
+                    pTok += pTok->Oprt.offset;
+                }
+                break;
+            case cmELSE:
+                pTok += pTok->Oprt.offset;
+                break;
+            case cmENDIF:
+                break;
+            case cmVAL:
+                stack[++sidx] = QmuDual(pTok->Val.data2);
+                break;
+            case cmVAR:
+            case cmVARPOW2:
+            case cmVARPOW3:
+            case cmVARPOW4:
+            case cmVARMUL:
+            {
+                QmuDual var = a_Seeds.value(pTok->Val.ptr, QmuDual(*pTok->Val.ptr));
+                qreal fDiff = 1;// Derivative of token by variable
+                switch (pTok->Cmd)
+                {
+                    case cmVARPOW2:
+                        fDiff = 2 * var.Val;
+                        var.Val = var.Val * var.Val;
+                        break;
+                    case cmVARPOW3:
+                        fDiff = 3 * var.Val * var.Val;
+                        var.Val = var.Val * var.Val * var.Val;
+                        break;
+                    case cmVARPOW4:
+                        fDiff = 4 * var.Val * var.Val * var.Val;
+                        var.Val = var.Val * var.Val * var.Val * var.Val;
+                        break;
+                    case cmVARMUL:
+                        fDiff = pTok->Val.data;
+                        var.Val = var.Val * pTok->Val.data + pTok->Val.data2;
+                        break;
+                    default:
+                        break;
+                }
+                for (int k = 0; k < QmuDual::Dim; ++k)
+                {
+                    var.Grad[k] *= fDiff;
+                }
+                stack[++sidx] = var;
+                break;
+            }
+            case cmFUNC:
+            {
+                const int iArgCount = (pTok->Fun.argc >= 0) ? pTok->Fun.argc : -pTok->Fun.argc;
+                sidx -= iArgCount - 1;
+                args.resize(iArgCount);
+                bool bConst = true;
+                for (int i = 0; i < iArgCount; ++i)
+                {
+                    args[i] = stack.at(sidx + i).Val;
+                    for (int k = 0; k < QmuDual::Dim; ++k)
+                    {
+                        bConst = bConst && qFuzzyIsNull(stack.at(sidx + i).Grad[k]);
+                    }
+                }
+
+                QmuDual result(CallFunction(pTok->Fun.ptr, pTok->Fun.argc, args.constData()));
+                if (bConst == false && DualFunction(pTok->Fun.ptr, pTok->Fun.argc, &stack[sidx], result) == false)
+                {
+                    return false;
+                }
+                stack[sidx] = result;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    if (sidx != 1)
+    {
+        return false;
+    }
+    a_Result = stack.at(sidx);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Calculate gradient of function result by rule of differentiation.
+ * @param a_pFun callback of function.
+ * @param a_iArgc number of arguments as it is stored in bytecode.
+ * @param a_pArgs dual values of arguments.
+ * @param a_Result result of function, gradient is set here.
+ * @return false if function has no rule of differentiation.
+ */
+bool QmuParserDerivative::DualFunction(generic_fun_type a_pFun, int a_iArgc, const QmuDual *a_pArgs,
+                                       QmuDual &a_Result) const
+{
+    const SDiffRule *pRule = FindRule(a_pFun);
+    if (pRule == nullptr || ((pRule->Sum || pRule->Select) == false && pRule->Argc != a_iArgc))
+    {
+        return false;
+    }
+
+    const int iArgCount = (a_iArgc >= 0) ? a_iArgc : -a_iArgc;
+    if (pRule->Select)
+    {
+        for (int i = 0; i < iArgCount; ++i)
+        {
+            if (qFuzzyCompare(a_pArgs[i].Val + 1, a_Result.Val + 1))
+            {
+                for (int k = 0; k < QmuDual::Dim; ++k)
+                {
+                    a_Result.Grad[k] = a_pArgs[i].Grad[k];
+                }
+                break;
+            }
+        }
+        return true;
+    }
+
+    for (int i = 0; i < iArgCount; ++i)
+    {
+        qreal fPartial = 1;
+        if (pRule->Sum)
+        {
+            fPartial = pRule->Mean ? 1.0 / iArgCount : 1;
+        }
+        else if (pRule->Diff[i] == nullptr)
+        {
+            fPartial = 0;
+        }
+        else if (iArgCount == 1)
+        {
+            fPartial = (*reinterpret_cast<fun_type1>(pRule->Diff[i]))(a_pArgs[0].Val);
+        }
+        else
+        {
+            fPartial = (*reinterpret_cast<fun_type2>(pRule->Diff[i]))(a_pArgs[0].Val, a_pArgs[1].Val);
+        }
+
+        for (int k = 0; k < QmuDual::Dim; ++k)
+        {
+            a_Result.Grad[k] += fPartial * a_pArgs[i].Grad[k];
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+const QmuParserDerivative::SDiffRule *QmuParserDerivative::FindRule(generic_fun_type a_pFun) const
+{
+    for (int i = 0; i < m_vRules.size(); ++i)
+    {
+        if (m_vRules.at(i).Fun == a_pFun)
+        {
+            return &m_vRules.at(i);
+        }
+    }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Differentiate subtree.
+ * @param a_Tree expression tree, nodes of derivative are appended to it.
+ * @param a_iNode root of subtree.
+ * @return node of derivative or iZeroNode if derivative is zero.
+ */
+int QmuParserDerivative::Diff(QmuDiffTree &a_Tree, int a_iNode) const
+{
+    const QmuDiffNode node = a_Tree.Nodes.at(a_iNode);// Copy, tree grows
+    const bool bVar = (node.Ptr == a_Tree.Var);
+    switch (node.Cmd)
+    {
+        case cmVAL:
+            return iZeroNode;
+        case cmVAR:
+            return bVar ? Value(a_Tree, 1) : iZeroNode;
+        case cmVARMUL:
+            return bVar ? Value(a_Tree, node.Mul) : iZeroNode;
+        case cmVARPOW2:
+            return bVar ? Mul(a_Tree, Value(a_Tree, 2), Variable(a_Tree, cmVAR, node.Ptr)) : iZeroNode;
+        case cmVARPOW3:
+            return bVar ? Mul(a_Tree, Value(a_Tree, 3), Variable(a_Tree, cmVARPOW2, node.Ptr)) : iZeroNode;
+        case cmVARPOW4:
+            return bVar ? Mul(a_Tree, Value(a_Tree, 4), Variable(a_Tree, cmVARPOW3, node.Ptr)) : iZeroNode;
+        case cmADD:
+            return Add(a_Tree, Diff(a_Tree, node.Args.at(0)), Diff(a_Tree, node.Args.at(1)));
+        case cmSUB:
+            return Sub(a_Tree, Diff(a_Tree, node.Args.at(0)), Diff(a_Tree, node.Args.at(1)));
+        case cmMUL:
+        {
+            const int iLeft = node.Args.at(0);
+            const int iRight = node.Args.at(1);
+            const int iDiffLeft = Diff(a_Tree, iLeft);
+            const int iDiffRight = Diff(a_Tree, iRight);
+            return Add(a_Tree, Mul(a_Tree, iDiffLeft, iRight), Mul(a_Tree, iLeft, iDiffRight));
+        }
+        case cmDIV:
+        {
+            // (u/v)' = u'/v - u*v'/v^2
+            const int iLeft = node.Args.at(0);
+            const int iRight = node.Args.at(1);
+            const int iDiffLeft = Diff(a_Tree, iLeft);
+            const int iDiffRight = Diff(a_Tree, iRight);
+            return Sub(a_Tree, Div(a_Tree, iDiffLeft, iRight),
+                       Div(a_Tree, Mul(a_Tree, iLeft, iDiffRight), Mul(a_Tree, iRight, iRight)));
+        }
+        case cmPOW:
+        {
+            const int iLeft = node.Args.at(0);
+            const int iRight = node.Args.at(1);
+            const int iDiffLeft = Diff(a_Tree, iLeft);
+            const int iDiffRight = Diff(a_Tree, iRight);
+            if (iDiffRight == iZeroNode)
+            {
+                // (u^c)' = c*u^(c-1)*u'
+                const int iPow = Operator(a_Tree, cmPOW, iLeft, Operator(a_Tree, cmSUB, iRight, Value(a_Tree, 1)));
+                return Mul(a_Tree, Mul(a_Tree, iRight, iPow), iDiffLeft);
+            }
+            // (u^v)' = u^v*(v'*ln(u) + v*u'/u)
+            const QVector<int> args = QVector<int>() << iLeft;
+            const int iLn = Function(a_Tree, reinterpret_cast<generic_fun_type>(DiffLn), 1, args);
+            return Mul(a_Tree, Operator(a_Tree, cmPOW, iLeft, iRight),
+                       Add(a_Tree, Mul(a_Tree, iDiffRight, iLn),
+                           Div(a_Tree, Mul(a_Tree, iRight, iDiffLeft), iLeft)));
+        }
+        case cmLE:
+        case cmGE:
+        case cmNEQ:
+        case cmEQ:
+        case cmLT:
+        case cmGT:
+        case cmLAND:
+        case cmLOR:
+            return iZeroNode;// Piecewise constant
+        case cmFUNC:
+        {
+            QVector<int> diffs(node.Args.size());
+            bool bConst = true;
+            for (int i = 0; i < node.Args.size(); ++i)
+            {
+                diffs[i] = Diff(a_Tree, node.Args.at(i));
+                bConst = bConst && diffs.at(i) == iZeroNode;
+            }
+            if (bConst)
+            {
+                return iZeroNode;
+            }
+
+            const SDiffRule *pRule = FindRule(node.Fun);
+            if (pRule == nullptr || pRule->Select || (pRule->Sum == false && pRule->Argc != node.Argc))
+            {
+                a_Tree.Supported = false;
+                return iZeroNode;
+            }
+
+            int iResult = iZeroNode;
+            if (pRule->Sum)
+            {
+                for (int i = 0; i < diffs.size(); ++i)
+                {
+                    iResult = Add(a_Tree, iResult, diffs.at(i));
+                }
+                if (pRule->Mean)
+                {
+                    iResult = Div(a_Tree, iResult, Value(a_Tree, diffs.size()));
+                }
+                return iResult;
+            }
+
+            // Chain rule: sum of partial derivatives multiplied by derivatives of arguments
+            for (int i = 0; i < diffs.size(); ++i)
+            {
+                if (diffs.at(i) != iZeroNode && pRule->Diff[i] != nullptr)
+                {
+                    const int iPartial = Function(a_Tree, pRule->Diff[i], node.Argc, node.Args);
+                    iResult = Add(a_Tree, iResult, Mul(a_Tree, iPartial, diffs.at(i)));
+                }
+            }
+            return iResult;
+        }
+        default:
+            a_Tree.Supported = false;
+            return iZeroNode;
+    }
+}
+
+} // namespace qmu
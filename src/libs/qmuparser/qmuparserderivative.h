@@ -0,0 +1,121 @@
+/***************************************************************************************************
+ **
+ **  Copyright 2026 Roman Telezhynskyi <dismine(at)gmail.com>
+ **
+ **  Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ **  software and associated documentation files (the "Software"), to deal in the Software
+ **  without restriction, including without limitation the rights to use, copy, modify,
+ **  merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ **  permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ **
+ **  The above copyright notice and this permission notice shall be included in all copies or
+ **  substantial portions of the Software.
+ **
+ **  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ **  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ **  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ **  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ **  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **
+ ******************************************************************************************************/
+
+#ifndef QMUPARSERDERIVATIVE_H
+#define QMUPARSERDERIVATIVE_H
+
+#include "qmuparser_global.h"
+#include "qmuparserbytecode.h"
+
+#include <QHash>
+#include <QVector>
+
+/**
+ * @file
+ * @brief Definition of the symbolic derivative generator for parser bytecode.
+ */
+
+namespace qmu
+{
+struct QmuDiffTree;
+
+/**
+ * @brief Dual number: value with its gradient by two independent variables.
+ *
+ * Bytecode evaluated over dual numbers (see QmuParserDerivative::EvalDual()) returns value of formula and its partial
+ * derivatives in one pass.
+ */
+struct QmuDual
+{
+    enum { Dim = 2 };
+
+    QmuDual()
+        :Val(0), Grad()
+    {}
+
+    explicit QmuDual(qreal a_fVal, qreal a_fGrad1 = 0, qreal a_fGrad2 = 0)
+        :Val(a_fVal), Grad()
+    {
+        Grad[0] = a_fGrad1;
+        Grad[1] = a_fGrad2;
+    }
+
+    qreal Val;
+    qreal Grad[Dim];
+};
+
+/**
+ * @brief Generator of derivative bytecode.
+ *
+ * Bytecode in reverse polish notation is converted to expression tree, tree is differentiated by chain rule and
+ * result is written back as new bytecode with the same variable pointers. Derivative of formula is calculated by one
+ * evaluation of its bytecode instead of two evaluations of formula for numeric differences.
+ *
+ * Functions are known only by address of callback, so generator has to know derivative of each function (see
+ * DefineDiff()). Derivative of unknown function is zero if its arguments don't depend on variable, otherwise
+ * Derive() returns false. Formulas with if-then-else, string and bulk functions are not supported.
+ *
+ * The same rules are used by EvalDual() that runs bytecode over dual numbers instead of generating new bytecode. It
+ * follows branch of if-then-else and argument selected by min or max (see DefineSelectDiff()), so it supports more
+ * formulas, but gives values only for current values of variables.
+ */
+class QMUPARSERSHARED_EXPORT QmuParserDerivative
+{
+public:
+    QmuParserDerivative();
+
+    void DefineDiff(fun_type1 a_pFun, fun_type1 a_pDiff);
+    void DefineDiff(fun_type2 a_pFun, fun_type2 a_pDiff1, fun_type2 a_pDiff2);
+    void DefineSumDiff(multfun_type a_pFun, bool a_bMean);
+    void DefineSelectDiff(multfun_type a_pFun);
+    bool Derive(const QmuParserByteCode &a_ByteCode, const qreal *a_pVar, QmuParserByteCode &a_Derivative) const;
+    bool EvalDual(const QmuParserByteCode &a_ByteCode, const QHash<const qreal *, QmuDual> &a_Seeds,
+                  QmuDual &a_Result) const;
+private:
+    /**
+     * @brief Rule of differentiation for function.
+     *
+     * Derivative of function with one or two arguments is sum of partial derivatives (Diff) multiplied by
+     * derivatives of arguments. Null partial derivative means zero. Derivative of sum is sum of derivatives of
+     * arguments, derivative of mean is divided by number of arguments. Function that selects one of arguments has
+     * derivative of this argument, it can't be written as bytecode.
+     */
+    struct SDiffRule
+    {
+        generic_fun_type Fun;
+        int              Argc;
+        generic_fun_type Diff[2];
+        bool             Sum;
+        bool             Mean;
+        bool             Select;
+    };
+
+    QVector<SDiffRule> m_vRules;
+
+    const SDiffRule *FindRule(generic_fun_type a_pFun) const;
+    int              Diff(QmuDiffTree &a_Tree, int a_iNode) const;
+    bool             DualFunction(generic_fun_type a_pFun, int a_iArgc, const QmuDual *a_pArgs,
+                                  QmuDual &a_Result) const;
+};
+
+} // namespace qmu
+
+#endif // QMUPARSERDERIVATIVE_H
@@ -0,0 +1,539 @@
+/***************************************************************************************************
+ **
+ **  Copyright 2026 Roman Telezhynskyi <dismine(at)gmail.com>
+ **
+ **  Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ **  software and associated documentation files (the "Software"), to deal in the Software
+ **  without restriction, including without limitation the rights to use, copy, modify,
+ **  merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ **  permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ **
+ **  The above copyright notice and this permission notice shall be included in all copies or
+ **  substantial portions of the Software.
+ **
+ **  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ **  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ **  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ **  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ **  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **
+ ******************************************************************************************************/
+
+#include "qmuparserjit.h"
+
+#include <QtCore/qmath.h>
+#include <cstring>
+
+#if defined(Q_PROCESSOR_X86_64) && (defined(Q_OS_WIN) || defined(Q_OS_UNIX))
+#   define QMUP_JIT_X86_64
+#endif
+
+#if defined(QMUP_JIT_X86_64)
+#   if defined(Q_OS_WIN)
+#       include <windows.h>
+#   else
+#       include <sys/mman.h>
+#   endif
+#endif
+
+/**
+ * @file
+ * @brief Implementation of the native code compiler for parser bytecode.
+ */
+
+namespace qmu
+{
+
+// Operators that don't have short machine code are called like functions with two arguments.
+
+//---------------------------------------------------------------------------------------------------------------------
+static qreal JitPow(qreal a_fVal1, qreal a_fVal2)
+{
+    return qPow(a_fVal1, a_fVal2);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static qreal JitEqual(qreal a_fVal1, qreal a_fVal2)
+{
+    return qFuzzyCompare(a_fVal1, a_fVal2);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static qreal JitNotEqual(qreal a_fVal1, qreal a_fVal2)
+{
+    return (qFuzzyCompare(a_fVal1, a_fVal2)==false);
+}
+
+#ifdef Q_CC_GNU
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wfloat-equal"
+#endif
+
+//---------------------------------------------------------------------------------------------------------------------
+static qreal JitAnd(qreal a_fVal1, qreal a_fVal2)
+{
+    return static_cast<bool>(a_fVal1) && static_cast<bool>(a_fVal2);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+static qreal JitOr(qreal a_fVal1, qreal a_fVal2)
+{
+    return static_cast<bool>(a_fVal1) || static_cast<bool>(a_fVal2);
+}
+
+#ifdef Q_CC_GNU
+    #pragma GCC diagnostic pop
+#endif
+
+// SSE2 opcodes of scalar double instructions (prefix F2 0F).
+static const int opMOVSD_LOAD  = 0x10;
+static const int opMOVSD_STORE = 0x11;
+static const int opADDSD       = 0x58;
+static const int opMULSD       = 0x59;
+static const int opSUBSD       = 0x5C;
+static const int opDIVSD       = 0x5E;
+static const int opCMPSD       = 0xC2;
+
+// Predicates of CMPSD.
+static const int cmpLT = 1;
+static const int cmpLE = 2;
+
+//---------------------------------------------------------------------------------------------------------------------
+QmuParserJit::QmuParserJit()
+    :m_pCode(nullptr), m_iCodeSize(0), m_pFun(nullptr), m_iStackSize(0), m_vBuf()
+{}
+
+//---------------------------------------------------------------------------------------------------------------------
+QmuParserJit::~QmuParserJit()
+{
+    Release();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Return true if native code can be generated for current platform.
+ */
+bool QmuParserJit::IsSupported()
+{
+#if defined(QMUP_JIT_X86_64)
+    return true;
+#else
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Compile bytecode to native code.
+ *
+ * Compiled function gets pointer to stack buffer and pointer to array of variable pointers. Stack position of every
+ * token is known while compilation, so code addresses stack directly. Registers rbx and r12 keep both pointers
+ * while functions are called.
+ * @param a_ByteCode finalized bytecode.
+ * @param a_nFinalResultIdx stack position of result.
+ * @return true if code was compiled. If false, bytecode must be evaluated by interpreter.
+ */
+bool QmuParserJit::Compile(const QmuParserByteCode &a_ByteCode, int a_nFinalResultIdx)
+{
+    Release();
+    if (IsSupported() == false)
+    {
+        return false;
+    }
+
+    m_vBuf.clear();
+    m_vBuf.reserve(a_ByteCode.GetSize() * 24 + 32);
+
+    EmitByte(0x53);                           // push rbx
+    EmitBytes("\x41\x54", 2);                 // push r12
+    EmitBytes("\x48\x83\xEC\x28", 4);         // sub rsp, 40 (Win64 shadow space, keeps rsp aligned to 16 bytes)
+#if defined(Q_OS_WIN)
+    EmitBytes("\x48\x89\xCB", 3);             // mov rbx, rcx
+    EmitBytes("\x49\x89\xD4", 3);             // mov r12, rdx
+#else
+    EmitBytes("\x48\x89\xFB", 3);             // mov rbx, rdi
+    EmitBytes("\x49\x89\xF4", 3);             // mov r12, rsi
+#endif
+
+    int sidx = 0;
+    int iVar = 0;
+#ifdef Q_CC_CLANG
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wundefined-reinterpret-cast"
+#endif
+    for (const SToken *pTok = a_ByteCode.GetBase(); pTok->Cmd!=cmEND ; ++pTok)
+    {
+        switch (pTok->Cmd)
+        {
+            // built in binary operators
+            case cmLE:
+            case cmLT:
+                --sidx;
+                EmitLoadStack(0, sidx);
+                EmitLoadStack(1, sidx+1);
+                EmitArith(opCMPSD, 0, 1);
+                EmitByte(pTok->Cmd == cmLE ? cmpLE : cmpLT);
+                EmitLoadConst(1, 1);
+                EmitBytes("\x66\x0F\x54\xC1", 4); // andpd xmm0, xmm1 (mask to 1.0 or 0.0)
+                EmitStoreStack(0, sidx);
+                continue;
+            case cmGE:
+            case cmGT:
+                // a >= b is b <= a, NaN gives false like in interpreter
+                --sidx;
+                EmitLoadStack(0, sidx+1);
+                EmitLoadStack(1, sidx);
+                EmitArith(opCMPSD, 0, 1);
+                EmitByte(pTok->Cmd == cmGE ? cmpLE : cmpLT);
+                EmitLoadConst(1, 1);
+                EmitBytes("\x66\x0F\x54\xC1", 4); // andpd xmm0, xmm1
+                EmitStoreStack(0, sidx);
+                continue;
+            case cmADD:
+            case cmSUB:
+            case cmMUL:
+            case cmDIV:
+            {
+    #if defined(MUP_MATH_EXCEPTIONS)
+                if (pTok->Cmd == cmDIV)
+                {
+                    return false;// Interpreter checks division by zero
+                }
+    #endif
+                int iOpcode = opADDSD;
+                switch (pTok->Cmd)
+                {
+                    case cmSUB:
+                        iOpcode = opSUBSD;
+                        break;
+                    case cmMUL:
+                        iOpcode = opMULSD;
+                        break;
+                    case cmDIV:
+                        iOpcode = opDIVSD;
+                        break;
+                    default:
+                        break;
+                }
+                --sidx;
+                EmitLoadStack(0, sidx);
+                EmitLoadStack(1, sidx+1);
+                EmitArith(iOpcode, 0, 1);
+                EmitStoreStack(0, sidx);
+                continue;
+            }
+            case cmPOW:
+            case cmEQ:
+            case cmNEQ:
+            case cmLAND:
+            case cmLOR:
+            {
+                quintptr pFun = reinterpret_cast<quintptr>(&JitPow);
+                switch (pTok->Cmd)
+                {
+                    case cmEQ:
+                        pFun = reinterpret_cast<quintptr>(&JitEqual);
+                        break;
+                    case cmNEQ:
+                        pFun = reinterpret_cast<quintptr>(&JitNotEqual);
+                        break;
+                    case cmLAND:
+                        pFun = reinterpret_cast<quintptr>(&JitAnd);
+                        break;
+                    case cmLOR:
+                        pFun = reinterpret_cast<quintptr>(&JitOr);
+                        break;
+                    default:
+                        break;
+                }
+                --sidx;
+                EmitLoadStack(0, sidx);
+                EmitLoadStack(1, sidx+1);
+                EmitCall(pFun);
+                EmitStoreStack(0, sidx);
+                continue;
+            }
+            case cmASSIGN:
+                --sidx;
+                EmitLoadStack(0, sidx+1);
+                EmitStoreVar(0, iVar++);
+                EmitStoreStack(0, sidx);
+                continue;
+
+            // value and variable tokens
+            case cmVAR:
+                EmitLoadVar(0, iVar++);
+                EmitStoreStack(0, ++sidx);
+                continue;
+            case cmVAL:
+                EmitLoadConst(0, pTok->Val.data2);
+                EmitStoreStack(0, ++sidx);
+                continue;
+            case cmVARPOW2:
+                EmitLoadVar(0, iVar++);
+                EmitArith(opMULSD, 0, 0);
+                EmitStoreStack(0, ++sidx);
+                continue;
+            case cmVARPOW3:
+            case cmVARPOW4:
+                EmitLoadVar(0, iVar++);
+                EmitBytes("\x66\x0F\x28\xC8", 4); // movapd xmm1, xmm0
+                EmitArith(opMULSD, 0, 1);
+                EmitArith(opMULSD, 0, 1);
+                if (pTok->Cmd == cmVARPOW4)
+                {
+                    EmitArith(opMULSD, 0, 1);
+                }
+                EmitStoreStack(0, ++sidx);
+                continue;
+            case cmVARMUL:
+                EmitLoadVar(0, iVar++);
+                EmitLoadConst(1, pTok->Val.data);
+                EmitArith(opMULSD, 0, 1);
+                EmitLoadConst(1, pTok->Val.data2);
+                EmitArith(opADDSD, 0, 1);
+                EmitStoreStack(0, ++sidx);
+                continue;
+
+            // Numeric functions. Arguments of type double go to xmm0-xmm3 in both calling conventions.
+            case cmFUNC:
+            {
+                const int iArgCount = pTok->Fun.argc;
+                const quintptr pFun = reinterpret_cast<quintptr>(pTok->Fun.ptr);
+                if (iArgCount > 4)
+                {
+                    return false;
+                }
+
+                if (iArgCount >= 0)
+                {
+                    sidx -= iArgCount - 1;
+                    for (int i = 0; i < iArgCount; ++i)
+                    {
+                        EmitLoadStack(i, sidx + i);
+                    }
+                }
+                else
+                {
+                    // function with variable arguments gets pointer to arguments and their number
+                    sidx -= -iArgCount - 1;
+#if defined(Q_OS_WIN)
+                    EmitBytes("\x48\x8D\x8B", 3); // lea rcx, [rbx+disp32]
+                    EmitInt32(sidx * static_cast<int>(sizeof(qreal)));
+                    EmitByte(0xBA);               // mov edx, imm32
+#else
+                    EmitBytes("\x48\x8D\xBB", 3); // lea rdi, [rbx+disp32]
+                    EmitInt32(sidx * static_cast<int>(sizeof(qreal)));
+                    EmitByte(0xBE);               // mov esi, imm32
+#endif
+                    EmitInt32(-iArgCount);
+                }
+                EmitCall(pFun);
+                EmitStoreStack(0, sidx);
+                continue;
+            }
+            default:
+                // if-then-else, string and bulk functions stay with interpreter
+                return false;
+        } // switch CmdCode
+    } // for all bytecode tokens
+#ifdef Q_CC_CLANG
+    #pragma clang diagnostic pop
+#endif
+
+    EmitLoadStack(0, a_nFinalResultIdx);
+    EmitBytes("\x48\x83\xC4\x28", 4);         // add rsp, 40
+    EmitBytes("\x41\x5C", 2);                 // pop r12
+    EmitByte(0x5B);                           // pop rbx
+    EmitByte(0xC3);                           // ret
+
+    m_iStackSize = a_ByteCode.GetMaxStackSize();
+    return Finalize();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Free executable memory.
+ */
+void QmuParserJit::Release()
+{
+#if defined(QMUP_JIT_X86_64)
+    if (m_pCode != nullptr)
+    {
+    #if defined(Q_OS_WIN)
+        VirtualFree(m_pCode, 0, MEM_RELEASE);
+    #else
+        munmap(m_pCode, static_cast<size_t>(m_iCodeSize));
+    #endif
+    }
+#endif
+    m_pCode = nullptr;
+    m_iCodeSize = 0;
+    m_pFun = nullptr;
+    m_iStackSize = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Copy code from buffer to executable memory.
+ *
+ * Memory is never writable and executable at the same time.
+ * @return true if success.
+ */
+bool QmuParserJit::Finalize()
+{
+#if defined(QMUP_JIT_X86_64)
+    const size_t size = static_cast<size_t>(m_vBuf.size());
+    #if defined(Q_OS_WIN)
+    void *pMem = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (pMem == nullptr)
+    {
+        return false;
+    }
+    memcpy(pMem, m_vBuf.constData(), size);
+    DWORD oldProtect;
+    if (VirtualProtect(pMem, size, PAGE_EXECUTE_READ, &oldProtect) == 0)
+    {
+        VirtualFree(pMem, 0, MEM_RELEASE);
+        return false;
+    }
+    FlushInstructionCache(GetCurrentProcess(), pMem, size);
+    #else
+    void *pMem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pMem == MAP_FAILED)
+    {
+        return false;
+    }
+    memcpy(pMem, m_vBuf.constData(), size);
+    if (mprotect(pMem, size, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(pMem, size);
+        return false;
+    }
+    #endif
+    m_pCode = pMem;
+    m_iCodeSize = m_vBuf.size();
+    m_pFun = reinterpret_cast<jitfun_type>(reinterpret_cast<quintptr>(m_pCode));
+    m_vBuf.clear();
+    return true;
+#else
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void QmuParserJit::EmitByte(int a_iByte)
+{
+    m_vBuf.append(static_cast<char>(a_iByte));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void QmuParserJit::EmitBytes(const char *a_pBytes, int a_iSize)
+{
+    m_vBuf.append(a_pBytes, a_iSize);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void QmuParserJit::EmitInt32(qint32 a_iVal)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        EmitByte((a_iVal >> (i * 8)) & 0xFF);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void QmuParserJit::EmitInt64(qint64 a_iVal)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        EmitByte(static_cast<int>((a_iVal >> (i * 8)) & 0xFF));
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Emit movsd xmmN, [rbx + pos*8].
+ */
+void QmuParserJit::EmitLoadStack(int a_iXmm, int a_iPos)
+{
+    EmitBytes("\xF2\x0F", 2);
+    EmitByte(opMOVSD_LOAD);
+    EmitByte(0x83 | (a_iXmm << 3));
+    EmitInt32(a_iPos * static_cast<int>(sizeof(qreal)));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Emit movsd [rbx + pos*8], xmmN.
+ */
+void QmuParserJit::EmitStoreStack(int a_iXmm, int a_iPos)
+{
+    EmitBytes("\xF2\x0F", 2);
+    EmitByte(opMOVSD_STORE);
+    EmitByte(0x83 | (a_iXmm << 3));
+    EmitInt32(a_iPos * static_cast<int>(sizeof(qreal)));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Emit mov rax, [r12 + var*8]; movsd xmmN, [rax].
+ */
+void QmuParserJit::EmitLoadVar(int a_iXmm, int a_iVar)
+{
+    EmitBytes("\x49\x8B\x84\x24", 4);
+    EmitInt32(a_iVar * static_cast<int>(sizeof(qreal *)));
+    EmitBytes("\xF2\x0F", 2);
+    EmitByte(opMOVSD_LOAD);
+    EmitByte(a_iXmm << 3);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Emit mov rax, [r12 + var*8]; movsd [rax], xmmN.
+ */
+void QmuParserJit::EmitStoreVar(int a_iXmm, int a_iVar)
+{
+    EmitBytes("\x49\x8B\x84\x24", 4);
+    EmitInt32(a_iVar * static_cast<int>(sizeof(qreal *)));
+    EmitBytes("\xF2\x0F", 2);
+    EmitByte(opMOVSD_STORE);
+    EmitByte(a_iXmm << 3);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Emit mov rax, imm64; movq xmmN, rax.
+ */
+void QmuParserJit::EmitLoadConst(int a_iXmm, qreal a_fVal)
+{
+    qint64 iBits = 0;
+    memcpy(&iBits, &a_fVal, sizeof(iBits));
+    EmitBytes("\x48\xB8", 2);
+    EmitInt64(iBits);
+    EmitBytes("\x66\x48\x0F\x6E", 4);
+    EmitByte(0xC0 | (a_iXmm << 3));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Emit scalar double instruction between two registers.
+ */
+void QmuParserJit::EmitArith(int a_iOpcode, int a_iDst, int a_iSrc)
+{
+    EmitBytes("\xF2\x0F", 2);
+    EmitByte(a_iOpcode);
+    EmitByte(0xC0 | (a_iDst << 3) | a_iSrc);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Emit mov rax, imm64; call rax.
+ */
+void QmuParserJit::EmitCall(quintptr a_pFun)
+{
+    EmitBytes("\x48\xB8", 2);
+    EmitInt64(static_cast<qint64>(a_pFun));
+    EmitBytes("\xFF\xD0", 2);
+}
+} // namespace qmu
@@ -0,0 +1,120 @@
+/***************************************************************************************************
+ **
+ **  Copyright 2026 Roman Telezhynskyi <dismine(at)gmail.com>
+ **
+ **  Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ **  software and associated documentation files (the "Software"), to deal in the Software
+ **  without restriction, including without limitation the rights to use, copy, modify,
+ **  merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ **  permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ **
+ **  The above copyright notice and this permission notice shall be included in all copies or
+ **  substantial portions of the Software.
+ **
+ **  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ **  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ **  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ **  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ **  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ **
+ ******************************************************************************************************/
+
+#ifndef QMUPARSERJIT_H
+#define QMUPARSERJIT_H
+
+#include "qmuparser_global.h"
+#include "qmuparserbytecode.h"
+
+#include <QByteArray>
+
+/**
+ * @file
+ * @brief Definition of the native code compiler for parser bytecode.
+ */
+
+namespace qmu
+{
+/**
+ * @brief Compiler of finalized bytecode to native code.
+ *
+ * Each token of bytecode becomes straight-line machine code with precalculated stack positions, so evaluation doesn't
+ * dispatch tokens anymore. Compiled code doesn't contain addresses of variables, they are passed to Eval() in
+ * GetVarPtrs() order. This allows to reuse code after variables were rebound.
+ *
+ * Only x86-64 is supported. Compile() returns false if platform is not supported or bytecode contains tokens
+ * without native implementation (if-then-else, string and bulk functions, functions with more than four arguments),
+ * in this case caller must use the interpreter.
+ */
+class QMUPARSERSHARED_EXPORT QmuParserJit
+{
+public:
+    QmuParserJit();
+    ~QmuParserJit();
+
+    static bool IsSupported();
+
+    bool        Compile(const QmuParserByteCode &a_ByteCode, int a_nFinalResultIdx);
+    bool        IsCompiled() const;
+    int         GetStackSize() const;
+    qreal       Eval(qreal *a_pStack, qreal *const *a_pVars) const;
+private:
+    Q_DISABLE_COPY(QmuParserJit)
+
+    /** @brief Type of compiled function. */
+    typedef qreal (*jitfun_type)(qreal *, qreal *const *);
+
+    /** @brief Executable memory with compiled code. */
+    void       *m_pCode;
+    int         m_iCodeSize;
+    jitfun_type m_pFun;
+    int         m_iStackSize;
+
+    /** @brief Buffer for code while compilation. */
+    QByteArray  m_vBuf;
+
+    void        Release();
+    bool        Finalize();
+
+    void        EmitByte(int a_iByte);
+    void        EmitBytes(const char *a_pBytes, int a_iSize);
+    void        EmitInt32(qint32 a_iVal);
+    void        EmitInt64(qint64 a_iVal);
+    void        EmitLoadStack(int a_iXmm, int a_iPos);
+    void        EmitStoreStack(int a_iXmm, int a_iPos);
+    void        EmitLoadVar(int a_iXmm, int a_iVar);
+    void        EmitStoreVar(int a_iXmm, int a_iVar);
+    void        EmitLoadConst(int a_iXmm, qreal a_fVal);
+    void        EmitArith(int a_iOpcode, int a_iDst, int a_iSrc);
+    void        EmitCall(quintptr a_pFun);
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+inline bool QmuParserJit::IsCompiled() const
+{
+    return m_pFun != nullptr;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Return number of values stack buffer for Eval() must have.
+ */
+inline int QmuParserJit::GetStackSize() const
+{
+    return m_iStackSize;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Run compiled code.
+ * @param a_pStack stack buffer of GetStackSize() values.
+ * @param a_pVars pointers to values of variables in QmuParserByteCode::GetVarPtrs() order.
+ * @return result of expression.
+ */
+inline qreal QmuParserJit::Eval(qreal *a_pStack, qreal *const *a_pVars) const
+{
+    Q_ASSERT(IsCompiled());
+    return m_pFun(a_pStack, a_pVars);
+}
+} // namespace qmu
+
+#endif // QMUPARSERJIT_H
@@ -24,6 +24,7 @@
 
 #include <QString>
 #include <QDebug>
+#include <QElapsedTimer>
 #include "qmuparsererror.h"
 #include <QtCore/qmath.h>
 #include <stdexcept>
@@ -57,6 +58,8 @@ QmuParserTester::QmuParserTester()
     AddTest ( &QmuParserTester::TestBinOprt );
     AddTest ( &QmuParserTester::TestException );
     AddTest ( &QmuParserTester::TestStrArg );
+    AddTest ( &QmuParserTester::TestBulkMode );
+    AddTest ( &QmuParserTester::TestDerivative );
 
     QmuParserTester::c_iCount = 0;
 }
@@ -123,6 +126,65 @@ int QmuParserTester::TestInterface()
         // failure is expected...
     }
 
+    // Test reuse of finalized bytecode with other variables
+    try
+    {
+        qreal afOther[2] = {10, 20};
+        p.DefineVar ( "c", &afVal[2] );
+        p.SetExpr ( "a*a+b*2-a" );
+        p.Eval();
+
+        QmuParserByteCode byteCode = p.GetByteCode();
+        QVector<qreal*> ptrs = byteCode.GetVarPtrs();
+        for (int i = 0; i < ptrs.size(); ++i)
+        {
+            ptrs[i] = (ptrs.at(i) == &afVal[0]) ? &afOther[0] : &afOther[1];
+        }
+        byteCode.SetVarPtrs(ptrs);
+
+        QmuParser p2;
+        p2.SetByteCode(byteCode, p.GetNumResults());
+        if ( qFuzzyCompare ( p2.Eval(), 130 ) == false )
+        {
+            iStat += 1;
+        }
+    }
+    catch ( ... )
+    {
+        iStat += 1;  // this is not supposed to happen
+    }
+
+    // Test variable factory that refuses unknown names
+    qreal fKnown = 5;
+    QmuParser p3;
+    p3.SetVarFactory ( KnownVarFactory, &fKnown );
+    try
+    {
+        p3.SetExpr ( "known*2" );
+        if ( qFuzzyCompare ( p3.Eval(), 10 ) == false )
+        {
+            iStat += 1;
+        }
+    }
+    catch ( ... )
+    {
+        iStat += 1;  // this is not supposed to happen
+    }
+
+    try
+    {
+        p3.SetExpr ( "known*unknown" );
+        p3.Eval();
+        iStat += 1;  // not supposed to reach this, factory doesn't know variable "unknown"
+    }
+    catch ( const QmuParserError &e )
+    {
+        if ( e.GetCode() != ecUNASSIGNABLE_TOKEN || e.GetPos() != 6 )
+        {
+            iStat += 1;
+        }
+    }
+
     if ( iStat == 0 )
     {
         qWarning() << "TestInterface passed";
@@ -294,6 +356,16 @@ int QmuParserTester::TestNames()
     PARSER_THROWCHECK ( Var, true,  "a_min0", &a )
     PARSER_THROWCHECK ( Var, true,  "a_min9", &a )
     PARSER_THROWCHECK ( Var, false, "a_min9", 0 )
+    // names with letters of other alphabets
+    p.DefineNameChars ( p.ValidNameChars() + QStringLiteral ( "\u0430\u0431\u0432" ) );
+    PARSER_THROWCHECK ( Var, true,  QStringLiteral ( "\u0430\u0431" ), &a )
+    PARSER_THROWCHECK ( Var, true,  QStringLiteral ( "a_\u0432" ), &a )
+    PARSER_THROWCHECK ( Var, false, QStringLiteral ( "\u0430\u0431?" ), &a )
+    PARSER_THROWCHECK ( Var, false, QStringLiteral ( "\u0430\u0433" ), &a )
+    a = 2;
+    p.SetExpr ( QStringLiteral ( "\u0430\u0431*3+a_\u0432" ) );
+    QmuParserTester::c_iCount++;
+    iStat += qFuzzyCompare ( p.Eval(), 8 ) ? 0 : 1;
     // Postfix operators
     // fail
     PARSER_THROWCHECK ( PostfixOprt, false, "(k", f1of1 )
@@ -958,6 +1030,86 @@ int QmuParserTester::TestIfThenElse()
     return iStat;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+int QmuParserTester::TestBulkMode()
+{
+    int iStat = 0;
+    qWarning() << "testing bulkmode...";
+
+    // vectorized interpreter
+    iStat += EqnTestBulk ( "a" );
+    iStat += EqnTestBulk ( "1.5" );
+    iStat += EqnTestBulk ( "a+b" );
+    iStat += EqnTestBulk ( "c*(a+b)" );
+    iStat += EqnTestBulk ( "a-b*c/a" );
+    iStat += EqnTestBulk ( "2*a+1" );
+    iStat += EqnTestBulk ( "a^2+b^3-c^4" );
+    iStat += EqnTestBulk ( "a^b" );
+    iStat += EqnTestBulk ( "(a<b) + (a<=b) + (a>c) + (a>=c) + (b==c) + (b!=c)" );
+    iStat += EqnTestBulk ( "a>b && b<c || c==0" );
+    iStat += EqnTestBulk ( "sin(a)+cos(b)" );
+    iStat += EqnTestBulk ( "min(a,b)+max(b,c)" );
+    iStat += EqnTestBulk ( "f5of5(a,b,c,1,a*b)" );
+    iStat += EqnTestBulk ( "sum(a,b,c,a*c)" );
+    iStat += EqnTestBulk ( "1, a+b" );
+    // lane by lane fallback
+    iStat += EqnTestBulk ( "(a<b) ? a : b" );
+    iStat += EqnTestBulk ( "b>0 ? a+c : b*2" );
+
+    if ( iStat == 0 )
+    {
+        qWarning() << "TestBulkMode passed";
+    }
+    else
+    {
+        qWarning() << "\n TestBulkMode failed with " << iStat << " errors";
+    }
+
+    return iStat;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int QmuParserTester::TestDerivative()
+{
+    int iStat = 0;
+    qWarning() << "testing symbolic and dual number derivatives...";
+
+    iStat += EqnTestDiff ( "a" );
+    iStat += EqnTestDiff ( "1.5" );
+    iStat += EqnTestDiff ( "a*b+c" );
+    iStat += EqnTestDiff ( "2*a+1" );
+    iStat += EqnTestDiff ( "a/b-c/a" );
+    iStat += EqnTestDiff ( "a^2+b^3-c^4" );
+    iStat += EqnTestDiff ( "a^b" );
+    iStat += EqnTestDiff ( "-a*(b-c)" );
+    iStat += EqnTestDiff ( "sin(a*b)+cos(c)/tan(a)" );
+    iStat += EqnTestDiff ( "sqrt(a^2+b^2)" );
+    iStat += EqnTestDiff ( "atan2(b,a)+atan(c)" );
+    iStat += EqnTestDiff ( "exp(a/10)*ln(c)+log10(a)" );
+    iStat += EqnTestDiff ( "sum(a,b*c,a^2)+avg(a,c)" );
+    iStat += EqnTestDiff ( "(a<b)*c" );
+    iStat += EqnTestDiff ( "max(b,c)*a" );// arguments of max don't depend on a
+    iStat += EqnTestDiff ( "(a<b) ? a : b", false );
+
+    iStat += EqnTestDual ( "a*b+c" );
+    iStat += EqnTestDual ( "a^b/c-sqrt(a)" );
+    iStat += EqnTestDual ( "sin(a*b)+atan2(b,a)" );
+    iStat += EqnTestDual ( "avg(a,b,c)*2" );
+    iStat += EqnTestDual ( "min(a,b)+max(a*c,b)" );
+    iStat += EqnTestDual ( "(a<b) ? a^2 : b*c" );
+
+    if ( iStat == 0 )
+    {
+        qWarning() << "TestDerivative passed";
+    }
+    else
+    {
+        qWarning() << "\n TestDerivative failed with " << iStat << " errors";
+    }
+
+    return iStat;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 int QmuParserTester::TestException()
 {
@@ -1155,7 +1307,127 @@ int QmuParserTester::ThrowTest ( const QString &a_str, int a_iErrc, bool a_bFail
 
 //---------------------------------------------------------------------------------------------------------------------
 /**
- * @brief Evaluate a tet expression.
+ * @brief Compare symbolic derivative of a test expression with numeric one for each variable.
+ *
+ * @param a_bSymbolic false if expression can't be differentiated symbolically.
+ * @return 1 in case of a failure, 0 otherwise.
+ */
+int QmuParserTester::EqnTestDiff ( const QString &a_str, bool a_bSymbolic )
+{
+    QmuParserTester::c_iCount++;
+
+    try
+    {
+        qreal afVal[3] = {1.3, 0.7, 2.1};
+        QmuParser p;
+        p.DefineVar ( "a", &afVal[0] );
+        p.DefineVar ( "b", &afVal[1] );
+        p.DefineVar ( "c", &afVal[2] );
+        p.SetExpr ( a_str );
+        p.Eval();
+
+        const QmuParserByteCode byteCode = p.GetByteCode();
+        for ( int i = 0; i < 3; ++i )
+        {
+            QmuParserByteCode derivative;
+            if ( p.Derive ( &afVal[i], derivative ) != a_bSymbolic )
+            {
+                throw std::runtime_error ( "unexpected result of symbolic differentiation" );
+            }
+
+            if ( a_bSymbolic )
+            {
+                const qreal fNumeric = p.Diff ( &afVal[i], afVal[i] );
+                p.SetByteCode ( derivative, 1 );
+                const qreal fSymbolic = p.Eval();
+                p.SetByteCode ( byteCode, 1 );
+                if ( fabs ( fSymbolic - fNumeric ) > 0.00001 * qMax ( static_cast<qreal>(1), fabs ( fNumeric ) ) )
+                {
+                    throw std::runtime_error ( "symbolic / numeric derivative mismatch" );
+                }
+            }
+        }
+    }
+    catch ( QmuParserError &e )
+    {
+        qWarning() << "\n  fail: " << a_str << " (" << e.GetMsg() << ")";
+        return 1;
+    }
+    catch ( std::exception &e )
+    {
+        qWarning() << "\n  fail: " << a_str << " (" << e.what() << ")";
+        return 1;  // always return a failure since this exception is not expected
+    }
+    catch ( ... )
+    {
+        qWarning() << "\n  fail: " << a_str <<  " (unexpected exception)";
+        return 1;  // exceptions other than ParserException are not allowed
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Compare value and gradient of a test expression over dual numbers with numeric derivatives.
+ *
+ * Variables a and b are independent, c is constant.
+ * @return 1 in case of a failure, 0 otherwise.
+ */
+int QmuParserTester::EqnTestDual ( const QString &a_str )
+{
+    QmuParserTester::c_iCount++;
+
+    try
+    {
+        qreal afVal[3] = {1.3, 0.7, 2.1};
+        QmuParser p;
+        p.DefineVar ( "a", &afVal[0] );
+        p.DefineVar ( "b", &afVal[1] );
+        p.DefineVar ( "c", &afVal[2] );
+        p.SetExpr ( a_str );
+        const qreal fVal = p.Eval();
+
+        QHash<const qreal *, QmuDual> seeds;
+        seeds.insert ( &afVal[0], QmuDual ( afVal[0], 1, 0 ) );
+        seeds.insert ( &afVal[1], QmuDual ( afVal[1], 0, 1 ) );
+
+        QmuDual result;
+        if ( p.EvalDual ( seeds, result ) == false )
+        {
+            throw std::runtime_error ( "expression can't be evaluated over dual numbers" );
+        }
+
+        const qreal afNumeric[3] = {fVal, p.Diff ( &afVal[0], afVal[0] ), p.Diff ( &afVal[1], afVal[1] )};
+        const qreal afDual[3] = {result.Val, result.Grad[0], result.Grad[1]};
+        for ( int i = 0; i < 3; ++i )
+        {
+            if ( fabs ( afDual[i] - afNumeric[i] ) > 0.00001 * qMax ( static_cast<qreal>(1), fabs ( afNumeric[i] ) ) )
+            {
+                throw std::runtime_error ( "dual / numeric result mismatch" );
+            }
+        }
+    }
+    catch ( QmuParserError &e )
+    {
+        qWarning() << "\n  fail: " << a_str << " (" << e.GetMsg() << ")";
+        return 1;
+    }
+    catch ( std::exception &e )
+    {
+        qWarning() << "\n  fail: " << a_str << " (" << e.what() << ")";
+        return 1;  // always return a failure since this exception is not expected
+    }
+    catch ( ... )
+    {
+        qWarning() << "\n  fail: " << a_str <<  " (unexpected exception)";
+        return 1;  // exceptions other than ParserException are not allowed
+    }
+
+    return 0;
+}
+
+
  *
  * @return 1 in case of a failure, 0 otherwise.
  */
@@ -1210,6 +1482,76 @@ int QmuParserTester::EqnTestWithVarChange ( const QString &a_str, double a_fVar1
     return 0;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Evaluate a test expression in bulk mode and compare each lane with a single evaluation.
+ *
+ * @return 1 in case of a failure, 0 otherwise.
+ */
+int QmuParserTester::EqnTestBulk ( const QString &a_str )
+{
+    QmuParserTester::c_iCount++;
+    const int nBulkSize = 150; // more than two blocks of the bulk interpreter
+
+    try
+    {
+        QVector<qreal> vA(nBulkSize), vB(nBulkSize), vC(nBulkSize), vResults(nBulkSize);
+        for ( int i = 0; i < nBulkSize; ++i )
+        {
+            vA[i] = i + 1;
+            vB[i] = ( i % 7 ) - 3;
+            vC[i] = 0.5 * i;
+        }
+
+        QmuParser pBulk;
+        pBulk.DefineVar ( "a", vA.data() );
+        pBulk.DefineVar ( "b", vB.data() );
+        pBulk.DefineVar ( "c", vC.data() );
+        pBulk.DefineFun ( "f5of5", f5of5 );
+        pBulk.DefineFun ( "sum", Sum );
+        pBulk.SetExpr ( a_str );
+        pBulk.Eval ( vResults.data(), nBulkSize );
+
+        qreal a = 0, b = 0, c = 0;
+        QmuParser p;
+        p.DefineVar ( "a", &a );
+        p.DefineVar ( "b", &b );
+        p.DefineVar ( "c", &c );
+        p.DefineFun ( "f5of5", f5of5 );
+        p.DefineFun ( "sum", Sum );
+        p.SetExpr ( a_str );
+
+        for ( int i = 0; i < nBulkSize; ++i )
+        {
+            a = vA.at(i);
+            b = vB.at(i);
+            c = vC.at(i);
+            const qreal fVal = p.Eval();
+            if ( fabs ( fVal - vResults.at(i) ) > fabs ( fVal * 0.0000000001 ) )
+            {
+                throw std::runtime_error ( "bulk / single evaluation mismatch" );
+            }
+        }
+    }
+    catch ( QmuParserError &e )
+    {
+        qWarning() << "\n  fail: " << a_str << " (" << e.GetMsg() << ")";
+        return 1;
+    }
+    catch ( std::exception &e )
+    {
+        qWarning() << "\n  fail: " << a_str << " (" << e.what() << ")";
+        return 1;  // always return a failure since this exception is not expected
+    }
+    catch ( ... )
+    {
+        qWarning() << "\n  fail: " << a_str <<  " (unexpected exception)";
+        return 1;  // exceptions other than ParserException are not allowed
+    }
+
+    return 0;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief Evaluate a tet expression.
@@ -1220,7 +1562,7 @@ int QmuParserTester::EqnTest ( const QString &a_str, double a_fRes, bool a_fPass
 {
     QmuParserTester::c_iCount++;
     int iRet ( 0 );
-    qreal fVal[5] = { -999, -998, -997, -996, -995}; // initially should be different
+    qreal fVal[6] = { -999, -998, -997, -996, -995, -994}; // initially should be different
 
     try
     {
@@ -1334,6 +1676,12 @@ int QmuParserTester::EqnTest ( const QString &a_str, double a_fRes, bool a_fPass
             int nNum;
             qreal *v = p2.Eval ( nNum );
             fVal[4] = v[nNum - 1];
+
+            // Test native code, bytecode that can't be compiled falls back to interpreter
+            qmu::QmuParser p4;
+            p4 = p2;
+            p4.EnableJit ( true );
+            fVal[5] = p4.Eval();
         }
         catch ( std::exception &e )
         {
@@ -1373,7 +1721,8 @@ int QmuParserTester::EqnTest ( const QString &a_str, double a_fRes, bool a_fPass
                      << fVal[1] << ","
                      << fVal[2] << ","
                      << fVal[3] << ","
-                     << fVal[4] << ").";
+                     << fVal[4] << ","
+                     << fVal[5] << ").";
         }
     }
     catch ( QmuParserError &e )
@@ -1406,6 +1755,72 @@ int QmuParserTester::EqnTest ( const QString &a_str, double a_fRes, bool a_fPass
     return iRet;
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief Compare speed of interpreter and native code on expressions from test suite.
+ *
+ * Each expression is evaluated many times with changing variable, time is reported per evaluation.
+ */
+void QmuParserTester::Benchmark()
+{
+    const QStringList expressions = QStringList()
+            << "a+b*c"
+            << "3*b+b"
+            << "1+2-3*4/5^6"
+            << "-(a+b)^2"
+            << "(a<b) + (b>=c)"
+            << "a<b && b<c"
+            << "sqrt(a+(3))"
+            << "(cos(2.41)/b)"
+            << "sin(a)*cos(b)+sqrt(c)"
+            << "2*sum(-1,2,-(-a))+2"
+            << "min(a,b)+max(b,c)"
+            << "a^2+b^3+c^4+2*a*b"
+            << "1+2-3*4/5^6*(2*(1-5+(3*7^9)*(4+6*7-3)))+12"
+            << "(a<b) ? a : b";// if-then-else is evaluated by interpreter
+
+    const int iterations = 1000000;
+    qWarning() << "benchmark (ns per evaluation, interpreter / native code)...";
+
+    for (int i = 0; i < expressions.size(); ++i)
+    {
+        try
+        {
+            qreal a = 1, b = 2, c = 3;
+            QmuParser p;
+            p.DefineVar ( "a", &a );
+            p.DefineVar ( "b", &b );
+            p.DefineVar ( "c", &c );
+
+            qint64 time[2] = {0, 0};
+            qreal fSum[2] = {0, 0};
+            for (int j = 0; j < 2; ++j)
+            {
+                p.EnableJit ( j == 1 );
+                p.SetExpr ( expressions.at(i) );
+                p.Eval(); // create bytecode
+
+                QElapsedTimer timer;
+                timer.start();
+                for (int k = 0; k < iterations; ++k)
+                {
+                    a = k % 100;
+                    fSum[j] += p.Eval();
+                }
+                time[j] = timer.nsecsElapsed();
+            }
+
+            qWarning() << expressions.at(i) << ":" << static_cast<qreal>(time[0]) / iterations << "/"
+                       << static_cast<qreal>(time[1]) / iterations
+                       << (qFuzzyCompare(fSum[0], fSum[1]) ? "" : "(results differ!)");
+        }
+        catch ( QmuParserError &e )
+        {
+            qWarning() << "\n  fail: " << expressions.at(i) << " (" << e.GetMsg() << ")";
+        }
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 /**
  * @brief Internal error in test class Test is going to be aborted.
@@ -52,6 +52,7 @@ public:
 
     QmuParserTester();
     void Run();
+    static void Benchmark();
 private:
     QVector<testfun_type> m_vTestFun;
     static int c_iCount;
@@ -63,6 +64,9 @@ private:
     static int EqnTestWithVarChange ( const QString &a_str, double a_fRes1, double a_fVar1, double a_fRes2,
                                       double a_fVar2 );
     static int ThrowTest ( const QString &a_str, int a_iErrc, bool a_bFail = true );
+    static int EqnTestBulk ( const QString &a_str );
+    static int EqnTestDiff ( const QString &a_str, bool a_bSymbolic = true );
+    static int EqnTestDual ( const QString &a_str );
 
     // Multiarg callbacks
     static qreal f1of1 ( qreal v )
@@ -275,6 +279,16 @@ private:
         return a_fVal / static_cast<qreal>( 1e3 );
     }
 
+    // Variable factory callback, knows only variable "known"
+    static qreal* KnownVarFactory ( const QString &a_szName, void *a_pUserData )
+    {
+        if ( a_szName == "known" )
+        {
+            return static_cast<qreal*>( a_pUserData );
+        }
+        return nullptr;
+    }
+
     // Custom value recognition
     static int IsHexVal ( const QString &a_szExpr, int *a_iPos, qreal *a_fVal );
 
@@ -302,6 +316,9 @@ private:
     int TestStrArg();
     // cppcheck-suppress functionStatic
     int TestIfThenElse();
+    // cppcheck-suppress functionStatic
+    int TestBulkMode();
+    int TestDerivative();
 
     static void Q_NORETURN Abort();
 };
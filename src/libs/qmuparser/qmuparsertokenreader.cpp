@@ -44,7 +44,7 @@ class QmuParserBase;
  * @throw nothrow
  */
 QmuParserTokenReader::QmuParserTokenReader ( const QmuParserTokenReader &a_Reader )
-    :m_pParser( a_Reader.m_pParser ), m_strFormula( a_Reader.m_strFormula ), m_iPos( a_Reader.m_iPos ),
+    :m_pParser( a_Reader.m_pParser ), m_strFormula( a_Reader.m_strFormula ), m_strTok(), m_iPos( a_Reader.m_iPos ),
       m_iSynFlags( a_Reader.m_iSynFlags ), m_bIgnoreUndefVar( a_Reader.m_bIgnoreUndefVar ),
       m_pFunDef( a_Reader.m_pFunDef ), m_pPostOprtDef( a_Reader.m_pPostOprtDef ),
       m_pInfixOprtDef( a_Reader.m_pInfixOprtDef ), m_pOprtDef( a_Reader.m_pOprtDef),
@@ -117,7 +117,7 @@ void QmuParserTokenReader::Assign ( const QmuParserTokenReader &a_Reader )
  * @param a_pParent Parent parser object of the token reader.
  */
 QmuParserTokenReader::QmuParserTokenReader ( QmuParserBase *a_pParent )
-    : m_pParser ( a_pParent ), m_strFormula(), m_iPos ( 0 ), m_iSynFlags ( 0 ), m_bIgnoreUndefVar ( false ),
+    : m_pParser ( a_pParent ), m_strFormula(), m_strTok(), m_iPos ( 0 ), m_iSynFlags ( 0 ), m_bIgnoreUndefVar ( false ),
       m_pFunDef ( nullptr ), m_pPostOprtDef ( nullptr ), m_pInfixOprtDef ( nullptr ), m_pOprtDef ( nullptr ),
       m_pConstDef ( nullptr ), m_pStrVarDef ( nullptr ), m_pVarDef ( nullptr ), m_pFactory ( nullptr ),
       m_pFactoryData ( nullptr ), m_vIdentFun(), m_UsedVar(), m_fZero ( 0 ), m_iBrackets ( 0 ), m_lastTok(),
@@ -211,7 +211,8 @@ QmuParserTokenReader::token_type QmuParserTokenReader::ReadNextToken()
     token_type tok;
 
     // Ignore all non printable characters when reading the expression
-    while ( m_strFormula.data()[m_iPos] > 0 && m_strFormula.data()[m_iPos] <= 0x20 )
+    const QChar *pFormula = m_strFormula.constData();
+    while ( pFormula[m_iPos] > 0 && pFormula[m_iPos] <= 0x20 )
     {
         ++m_iPos;
     }
@@ -277,11 +278,10 @@ QmuParserTokenReader::token_type QmuParserTokenReader::ReadNextToken()
     //
     // !!! From this point on there is no exit without an exception possible...
     //
-    QString strTok;
-    int iEnd = ExtractToken ( m_pParser->ValidNameChars(), strTok, m_iPos );
+    int iEnd = ExtractToken ( m_pParser->NameCharSet(), m_strTok, m_iPos );
     if ( iEnd != m_iPos )
     {
-        Error ( ecUNASSIGNABLE_TOKEN, m_iPos, strTok );
+        Error ( ecUNASSIGNABLE_TOKEN, m_iPos, QString ( m_strTok.constData(), m_strTok.size() ) );
     }
 
     Error ( ecUNASSIGNABLE_TOKEN, m_iPos, m_strFormula.mid ( m_iPos ) );
@@ -305,29 +305,23 @@ void QmuParserTokenReader::SetParent ( QmuParserBase *a_pParent )
 /**
  * @brief Extract all characters that belong to a certain charset.
  *
- * @param a_szCharSet [in] Const char array of the characters allowed in the token.
- * @param a_sTok [out]  The string that consists entirely of characters listed in a_szCharSet.
+ * Token string doesn't copy characters, it shows part of formula. It is valid only until next token is extracted, so
+ * make a copy if token string must be saved.
+ *
+ * @param a_CharSet [in] Characters allowed in the token.
+ * @param a_sTok [out]  The string that consists entirely of characters from a_CharSet.
  * @param a_iPos [in] Position in the string from where to start reading.
- * @return The Position of the first character not listed in a_szCharSet.
+ * @return The Position of the first character not listed in a_CharSet.
  * @throw nothrow
  */
-int QmuParserTokenReader::ExtractToken ( const QString &a_szCharSet, QString &a_sTok, int a_iPos ) const
+int QmuParserTokenReader::ExtractToken ( const QmuParserCharSet &a_CharSet, QString &a_sTok, int a_iPos ) const
 {
-    const std::wstring m_strFormulaStd = m_strFormula.toStdWString();
-    const std::wstring a_szCharSetStd = a_szCharSet.toStdWString();
-
-    int iEnd = static_cast<int>(m_strFormulaStd.find_first_not_of ( a_szCharSetStd, static_cast<std::size_t>(a_iPos) ));
-
-    if ( iEnd == static_cast<int>(string_type::npos) )
-    {
-        iEnd = static_cast<int>(m_strFormulaStd.length());
-    }
+    const int iEnd = a_CharSet.Span ( m_strFormula, a_iPos );
 
     // Assign token string if there was something found
     if ( a_iPos != iEnd )
     {
-        a_sTok = QString().fromStdWString ( std::wstring ( m_strFormulaStd.begin() + a_iPos,
-                                                           m_strFormulaStd.begin() + iEnd ) );
+        a_sTok.setRawData ( m_strFormula.constData() + a_iPos, iEnd - a_iPos );
     }
 
     return iEnd;
@@ -343,27 +337,17 @@ int QmuParserTokenReader::ExtractToken ( const QString &a_szCharSet, QString &a_
  */
 int QmuParserTokenReader::ExtractOperatorToken ( QString &a_sTok, int a_iPos ) const
 {
-    const std::wstring m_strFormulaStd = m_strFormula.toStdWString();
-    const std::wstring oprtCharsStd = m_pParser->ValidInfixOprtChars().toStdWString();
-
-    int iEnd = static_cast<int>( m_strFormulaStd.find_first_not_of ( oprtCharsStd, static_cast<std::size_t>(a_iPos) ) );
-    if ( iEnd == static_cast<int>( string_type::npos ) )
-    {
-        iEnd = static_cast<int>( m_strFormulaStd.length() );
-    }
-
-    // Assign token string if there was something found
+    const int iEnd = ExtractToken ( m_pParser->InfixOprtCharSet(), a_sTok, a_iPos );
     if ( a_iPos != iEnd )
     {
-        a_sTok = QString().fromStdWString ( string_type ( m_strFormulaStd.begin() + a_iPos,
-                                            m_strFormulaStd.begin() + iEnd ) );
         return iEnd;
     }
     else
     {
         // There is still the chance of having to deal with an operator consisting exclusively
         // of alphabetic characters.
-        return ExtractToken ( QMUP_CHARS, a_sTok, a_iPos );
+        static const QmuParserCharSet alphaChars ( QMUP_CHARS );
+        return ExtractToken ( alphaChars, a_sTok, a_iPos );
     }
 }
 
@@ -375,14 +359,14 @@ int QmuParserTokenReader::ExtractOperatorToken ( QString &a_sTok, int a_iPos ) c
  */
 bool QmuParserTokenReader::IsBuiltIn ( token_type &a_Tok )
 {
-    const QStringList pOprtDef = m_pParser->GetOprtDef();
+    const QStringList &pOprtDef = m_pParser->GetOprtDef();
 
     // Compare token with function and operator strings
     // check string for operator/function
     for ( int i = 0; i < pOprtDef.size(); ++i )
     {
         int len = pOprtDef.at ( i ).length();
-        if ( pOprtDef.at ( i ) == m_strFormula.mid ( m_iPos, len ) )
+        if ( m_strFormula.midRef ( m_iPos, len ) == pOprtDef.at ( i ) )
         {
             if (i >= cmLE && i <= cmASSIGN)
             {
@@ -514,7 +498,7 @@ bool QmuParserTokenReader::IsArgSep ( token_type &a_Tok )
 bool QmuParserTokenReader::IsEOF ( token_type &a_Tok )
 {
     // check for EOF
-    if ( m_strFormula.data()[m_iPos] == false /*|| szFormula[m_iPos] == '\n'*/ )
+    if ( m_strFormula.constData()[m_iPos] == false /*|| szFormula[m_iPos] == '\n'*/ )
     {
         if ( m_iSynFlags & noEND )
         {
@@ -549,8 +533,7 @@ bool QmuParserTokenReader::IsEOF ( token_type &a_Tok )
  */
 bool QmuParserTokenReader::IsInfixOpTok ( token_type &a_Tok )
 {
-    QString sTok;
-    int iEnd = ExtractToken ( m_pParser->ValidInfixOprtChars(), sTok, m_iPos );
+    int iEnd = ExtractToken ( m_pParser->InfixOprtCharSet(), m_strTok, m_iPos );
     if ( iEnd == m_iPos )
     {
         return false;
@@ -560,7 +543,7 @@ bool QmuParserTokenReader::IsInfixOpTok ( token_type &a_Tok )
     auto it = m_pInfixOprtDef->rbegin();
     for ( ; it != m_pInfixOprtDef->rend(); ++it )
     {
-        if ( sTok.indexOf ( it->first ) != 0 )
+        if ( m_strTok.startsWith ( it->first ) == false )
         {
             continue;
         }
@@ -601,14 +584,13 @@ bool QmuParserTokenReader::IsInfixOpTok ( token_type &a_Tok )
  */
 bool QmuParserTokenReader::IsFunTok ( token_type &a_Tok )
 {
-    QString strTok;
-    int iEnd = ExtractToken ( m_pParser->ValidNameChars(), strTok, m_iPos );
+    int iEnd = ExtractToken ( m_pParser->NameCharSet(), m_strTok, m_iPos );
     if ( iEnd == m_iPos )
     {
         return false;
     }
 
-    funmap_type::const_iterator item = m_pFunDef->find ( strTok );
+    funmap_type::const_iterator item = m_pFunDef->find ( m_strTok );
     if ( item == m_pFunDef->end() )
     {
         return false;
@@ -620,7 +602,7 @@ bool QmuParserTokenReader::IsFunTok ( token_type &a_Tok )
         return false;
     }
 
-    a_Tok.Set ( item->second, strTok );
+    a_Tok.Set ( item->second, item->first );
 
     m_iPos = iEnd;
     if ( m_iSynFlags & noFUN )
@@ -640,21 +622,19 @@ bool QmuParserTokenReader::IsFunTok ( token_type &a_Tok )
  */
 bool QmuParserTokenReader::IsOprt ( token_type &a_Tok )
 {
-    QString strTok;
-
-    int iEnd = ExtractOperatorToken ( strTok, m_iPos );
+    int iEnd = ExtractOperatorToken ( m_strTok, m_iPos );
     if ( iEnd == m_iPos )
     {
         return false;
     }
 
     // Check if the operator is a built in operator, if so ignore it here
-    const QStringList pOprtDef = m_pParser->GetOprtDef();
+    const QStringList &pOprtDef = m_pParser->GetOprtDef();
     QStringList::const_iterator constIterator;
     for ( constIterator = pOprtDef.constBegin(); m_pParser->HasBuiltInOprt() && constIterator != pOprtDef.constEnd();
             ++constIterator )
     {
-        if ( ( *constIterator ) == strTok )
+        if ( ( *constIterator ) == m_strTok )
         {
             return false;
         }
@@ -670,9 +650,9 @@ bool QmuParserTokenReader::IsOprt ( token_type &a_Tok )
     for ( ; it != m_pOprtDef->rend(); ++it )
     {
         const QString &sID = it->first;
-        if ( sID == m_strFormula.mid ( m_iPos, sID.length() ) )
+        if ( m_strFormula.midRef ( m_iPos, sID.length() ) == sID )
         {
-            a_Tok.Set ( it->second, strTok );
+            a_Tok.Set ( it->second, QString ( m_strTok.constData(), m_strTok.size() ) );
 
             // operator was found
             if ( m_iSynFlags & noOPT )
@@ -731,8 +711,7 @@ bool QmuParserTokenReader::IsPostOpTok ( token_type &a_Tok )
     // token readers.
 
     // Test if there could be a postfix operator
-    QString sTok;
-    int iEnd = ExtractToken ( m_pParser->ValidOprtChars(), sTok, m_iPos );
+    int iEnd = ExtractToken ( m_pParser->OprtCharSet(), m_strTok, m_iPos );
     if ( iEnd == m_iPos )
     {
         return false;
@@ -742,12 +721,12 @@ bool QmuParserTokenReader::IsPostOpTok ( token_type &a_Tok )
     auto it = m_pPostOprtDef->rbegin();
     for ( ; it != m_pPostOprtDef->rend(); ++it )
     {
-        if ( sTok.indexOf ( it->first ) != 0 )
+        if ( m_strTok.startsWith ( it->first ) == false )
         {
             continue;
         }
 
-        a_Tok.Set ( it->second, sTok );
+        a_Tok.Set ( it->second, QString ( m_strTok.constData(), m_strTok.size() ) );
         m_iPos += it->first.length();
 
         m_iSynFlags = noVAL | noVAR | noFUN | noBO | noPOSTOP | noSTR | noASSIGN;
@@ -771,24 +750,23 @@ bool QmuParserTokenReader::IsValTok ( token_type &a_Tok )
     assert ( m_pConstDef );
     assert ( m_pParser );
 
-    QString strTok;
     qreal fVal ( 0 );
     int iEnd ( 0 );
 
     // 2.) Check for user defined constant
     // Read everything that could be a constant name
-    iEnd = ExtractToken ( m_pParser->ValidNameChars(), strTok, m_iPos );
+    iEnd = ExtractToken ( m_pParser->NameCharSet(), m_strTok, m_iPos );
     if ( iEnd != m_iPos )
     {
-        valmap_type::const_iterator item = m_pConstDef->find ( strTok );
+        valmap_type::const_iterator item = m_pConstDef->find ( m_strTok );
         if ( item != m_pConstDef->end() )
         {
             m_iPos = iEnd;
-            a_Tok.SetVal ( item->second, strTok );
+            a_Tok.SetVal ( item->second, item->first );
 
             if ( m_iSynFlags & noVAL )
             {
-                Error ( ecUNEXPECTED_VAL, m_iPos - strTok.length(), strTok );
+                Error ( ecUNEXPECTED_VAL, m_iPos - item->first.length(), item->first );
             }
 
             m_iSynFlags = noVAL | noVAR | noFUN | noBO | noINFIXOP | noSTR | noASSIGN;
@@ -802,10 +780,11 @@ bool QmuParserTokenReader::IsValTok ( token_type &a_Tok )
     for ( item = m_vIdentFun.begin(); item != m_vIdentFun.end(); ++item )
     {
         int iStart = m_iPos;
-        if ( ( *item ) ( m_strFormula.mid ( m_iPos ), &m_iPos, &fVal ) == 1 )
+        m_strTok.setRawData ( m_strFormula.constData() + m_iPos, m_strFormula.size() - m_iPos );
+        if ( ( *item ) ( m_strTok, &m_iPos, &fVal ) == 1 )
         {
             // 2013-11-27 Issue 2:  https://code.google.com/p/muparser/issues/detail?id=2
-            strTok = m_strFormula.mid ( iStart, m_iPos-iStart );
+            const QString strTok = m_strFormula.mid ( iStart, m_iPos-iStart );
             if ( m_iSynFlags & noVAL )
             {
                 Error ( ecUNEXPECTED_VAL, m_iPos - strTok.length(), strTok );
@@ -833,14 +812,13 @@ bool QmuParserTokenReader::IsVarTok ( token_type &a_Tok )
         return false;
     }
 
-    QString strTok;
-    int iEnd = ExtractToken ( m_pParser->ValidNameChars(), strTok, m_iPos );
+    int iEnd = ExtractToken ( m_pParser->NameCharSet(), m_strTok, m_iPos );
     if ( iEnd == m_iPos )
     {
         return false;
     }
 
-    varmap_type::const_iterator item =  m_pVarDef->find ( strTok );
+    varmap_type::const_iterator item =  m_pVarDef->find ( m_strTok );
     if ( item == m_pVarDef->end() )
     {
         return false;
@@ -848,13 +826,13 @@ bool QmuParserTokenReader::IsVarTok ( token_type &a_Tok )
 
     if ( m_iSynFlags & noVAR )
     {
-        Error ( ecUNEXPECTED_VAR, m_iPos, strTok );
+        Error ( ecUNEXPECTED_VAR, m_iPos, item->first );
     }
 
     m_pParser->OnDetectVar ( m_strFormula, m_iPos, iEnd );
 
     m_iPos = iEnd;
-    a_Tok.SetVar ( item->second, strTok );
+    a_Tok.SetVar ( item->second, item->first );
     m_UsedVar[item->first] = item->second;  // Add variable to used-var-list
 
     m_iSynFlags = noVAL | noVAR | noFUN | noBO | noINFIXOP | noSTR;
@@ -872,14 +850,13 @@ bool QmuParserTokenReader::IsStrVarTok ( token_type &a_Tok )
         return false;
     }
 
-    QString strTok;
-    int iEnd = ExtractToken ( m_pParser->ValidNameChars(), strTok, m_iPos );
+    int iEnd = ExtractToken ( m_pParser->NameCharSet(), m_strTok, m_iPos );
     if ( iEnd == m_iPos )
     {
         return false;
     }
 
-    strmap_type::const_iterator item =  m_pStrVarDef->find ( strTok );
+    strmap_type::const_iterator item =  m_pStrVarDef->find ( m_strTok );
     if ( item == m_pStrVarDef->end() )
     {
         return false;
@@ -887,7 +864,7 @@ bool QmuParserTokenReader::IsStrVarTok ( token_type &a_Tok )
 
     if ( m_iSynFlags & noSTR )
     {
-        Error ( ecUNEXPECTED_VAR, m_iPos, strTok );
+        Error ( ecUNEXPECTED_VAR, m_iPos, item->first );
     }
 
     m_iPos = iEnd;
@@ -913,12 +890,13 @@ bool QmuParserTokenReader::IsStrVarTok ( token_type &a_Tok )
  */
 bool QmuParserTokenReader::IsUndefVarTok ( token_type &a_Tok )
 {
-    QString strTok;
-    int iEnd ( ExtractToken ( m_pParser->ValidNameChars(), strTok, m_iPos ) );
+    int iEnd ( ExtractToken ( m_pParser->NameCharSet(), m_strTok, m_iPos ) );
     if ( iEnd == m_iPos )
     {
         return false;
     }
+    // New variable keeps its name, so here we need a copy
+    const QString strTok ( m_strTok.constData(), m_strTok.size() );
 
     if ( m_iSynFlags & noVAR )
     {
@@ -933,6 +911,11 @@ bool QmuParserTokenReader::IsUndefVarTok ( token_type &a_Tok )
     if ( m_pFactory )
     {
         qreal *fVar = m_pFactory ( strTok, m_pFactoryData );
+        if ( fVar == nullptr )
+        {
+            // The factory refused to create variable with this name
+            Error ( ecUNASSIGNABLE_TOKEN, m_iPos, strTok );
+        }
         a_Tok.SetVar ( fVar, strTok );
 
         // Do not use m_pParser->DefineVar( strTok, fVar );
@@ -1020,6 +1003,7 @@ bool QmuParserTokenReader::IsString ( token_type &a_Tok )
  */
 void Q_NORETURN QmuParserTokenReader::Error ( EErrorCodes a_iErrc, int a_iPos, const QString &a_sTok ) const
 {
-    m_pParser->Error ( a_iErrc, a_iPos, a_sTok );
+    // Token can show characters of formula, exception must have own copy
+    m_pParser->Error ( a_iErrc, a_iPos, QString ( a_sTok.constData(), a_sTok.size() ) );
 }
 } // namespace qmu
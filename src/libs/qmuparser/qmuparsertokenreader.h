@@ -25,6 +25,7 @@
 
 #include "qmuparserdef.h"
 #include "qmuparsertoken.h"
+#include "qmuparsercharset.h"
 
 /**
  * @file
@@ -93,7 +94,7 @@ private:
     void            Assign(const QmuParserTokenReader &a_Reader);
 
     void            SetParent(QmuParserBase *a_pParent);
-    int             ExtractToken(const QString &a_szCharSet, QString &a_strTok, int a_iPos) const;
+    int             ExtractToken(const QmuParserCharSet &a_CharSet, QString &a_sTok, int a_iPos) const;
     int             ExtractOperatorToken(QString &a_sTok, int a_iPos) const;
 
     bool            IsBuiltIn(token_type &a_Tok);
@@ -114,6 +115,7 @@ private:
 
     QmuParserBase     *m_pParser;
     QString            m_strFormula;
+    QString            m_strTok;          ///< Last extracted token, shows characters of m_strFormula without copy
     int                m_iPos;
     int                m_iSynFlags;
     bool               m_bIgnoreUndefVar;
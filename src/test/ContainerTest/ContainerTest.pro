@@ -0,0 +1,86 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2026-10-17T12:00:00
+#
+#-------------------------------------------------
+
+# Build tests of pattern data containers.
+
+# File with common stuff for whole project
+include(../../../Valentina.pri)
+
+# We use many core functions.
+QT       += core concurrent
+
+# Consol application doesn't need gui.
+QT       -= gui
+
+# Name of binary file.
+TARGET = ContainerTest
+
+# Console application, we use C++11 standard.
+CONFIG   += console c++11
+
+# Use out-of-source builds (shadow builds)
+CONFIG   -= app_bundle debug_and_release debug_and_release_target
+
+# We want create executable file
+TEMPLATE = app
+
+# directory for executable file
+DESTDIR = bin
+
+# objecs files
+OBJECTS_DIR = obj
+
+HEADERS += \
+    stable.h
+
+SOURCES += \
+    main.cpp \
+    stable.cpp
+
+# Set using ccache. Function enable_ccache() defined in Valentina.pri.
+$$enable_ccache()
+
+# Set precompiled headers. Function set_PCH() defined in Valentina.pri.
+$$set_PCH()
+
+CONFIG(debug, debug|release){
+    # Debug mode
+    unix {
+        #Turn on compilers warnings.
+        *-g++{
+        QMAKE_CXXFLAGS += \
+            $$GCC_DEBUG_CXXFLAGS # See Valentina.pri for more details.
+        }
+        clang*{
+        QMAKE_CXXFLAGS += \
+            $$CLANG_DEBUG_CXXFLAGS # See Valentina.pri for more details.
+        }
+    } else {
+        *-g++{
+        QMAKE_CXXFLAGS += $$GCC_DEBUG_CXXFLAGS # See Valentina.pri for more details.
+        }
+    }
+
+}else{
+    # Release mode
+    DEFINES += QT_NO_DEBUG_OUTPUT
+
+    # Turn on debug symbols in release mode on Unix systems.
+    # On Mac OS X temporarily disabled. Need find way how to strip binary file.
+    unix:!macx:QMAKE_CXXFLAGS_RELEASE += -g -gdwarf-3
+}
+
+INCLUDEPATH += $$PWD/../../app/container
+
+# Strip after you link all libaries.
+CONFIG(release, debug|release){
+    unix:!macx{
+        # Strip debug symbols.
+        QMAKE_POST_LINK += objcopy --only-keep-debug $(TARGET) $(TARGET).debug &&
+        QMAKE_POST_LINK += strip --strip-debug --strip-unneeded $(TARGET) &&
+        QMAKE_POST_LINK += objcopy --add-gnu-debuglink $(TARGET).debug $(TARGET)
+    }
+}
@@ -0,0 +1,175 @@
+/************************************************************************
+ **
+ **  @file   main.cpp
+ **  @author Roman Telezhynskyi <dismine(at)gmail.com>
+ **  @date   17 10, 2026
+ **
+ **  @brief
+ **  @copyright
+ **  This source code is part of the Valentine project, a pattern making
+ **  program, whose allow create and modeling patterns of clothing.
+ **  Copyright (C) 2014 Valentina project
+ **  <https://bitbucket.org/dismine/valentina> All Rights Reserved.
+ **
+ **  Valentina is free software: you can redistribute it and/or modify
+ **  it under the terms of the GNU General Public License as published by
+ **  the Free Software Foundation, either version 3 of the License, or
+ **  (at your option) any later version.
+ **
+ **  Valentina is distributed in the hope that it will be useful,
+ **  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **  GNU General Public License for more details.
+ **
+ **  You should have received a copy of the GNU General Public License
+ **  along with Valentina.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ *************************************************************************/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSharedPointer>
+#include <QtConcurrent>
+#include <QtGlobal>
+#include "vversionedhash.h"
+
+typedef VVersionedHash<quint32, QSharedPointer<int> > TestHash;
+
+/**
+ * @brief The TestPiece struct copy of base hash that one pattern piece changes. Pieces change only keys of own class
+ * (key % pieces == index), like tools of independent pattern pieces change only own objects.
+ */
+struct TestPiece
+{
+    TestPiece() :hash(), index(0), pieces(1), seed(1), range(1), edits(0) {}
+    TestHash hash;
+    quint32  index;
+    quint32  pieces;
+    quint32  seed;
+    quint32  range;
+    int      edits;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+quint32 NextRandom(quint32 &seed)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 8) & 0xffffff;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void EditPiece(TestHash &hash, const TestPiece &piece)
+{
+    quint32 seed = piece.seed;
+    for (int i = 0; i < piece.edits; ++i)
+    {
+        const quint32 key = NextRandom(seed) % piece.range / piece.pieces * piece.pieces + piece.index;
+        if (NextRandom(seed) % 3 == 0)
+        {
+            hash.remove(key);
+        }
+        else
+        {
+            hash.insert(key, QSharedPointer<int>(new int(static_cast<int>(NextRandom(seed)))));
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void RecalculatePiece(TestPiece &piece)
+{
+    EditPiece(piece.hash, piece);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief SameHash compare keys and values. Sequential path creates own values, so pointers can't be compared.
+ */
+bool SameHash(const TestHash &hash, const TestHash &expected)
+{
+    int count = 0;
+    for (TestHash::const_iterator i = hash.constBegin(); i != hash.constEnd(); ++i)
+    {
+        const QSharedPointer<int> *value = expected.Find(i.key());
+        if (value == nullptr || **value != *i.value())
+        {
+            return false;
+        }
+        ++count;
+    }
+    return count == hash.size() && count == expected.size();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+/**
+ * @brief TestMerge check that pieces changed concurrently and merged to base give the same hash as changing it
+ * sequentially.
+ * @return count of failed rounds.
+ */
+int TestMerge()
+{
+    int failed = 0;
+    quint32 seed = 17;
+    for (int round = 0; round < 200; ++round)
+    {
+        const quint32 range = 1 + NextRandom(seed) % 5000;
+        TestHash base;
+        const int count = static_cast<int>(NextRandom(seed) % 3000);
+        for (int i = 0; i < count; ++i)
+        {
+            base.insert(NextRandom(seed) % range, QSharedPointer<int>(new int(i)));
+        }
+
+        QVector<TestPiece> pieces(1 + static_cast<int>(NextRandom(seed) % 4));
+        for (int i = 0; i < pieces.size(); ++i)
+        {
+            pieces[i].hash = base;
+            pieces[i].index = static_cast<quint32>(i);
+            pieces[i].pieces = static_cast<quint32>(pieces.size());
+            pieces[i].seed = NextRandom(seed);
+            pieces[i].range = range;
+            pieces[i].edits = static_cast<int>(NextRandom(seed) % 300);
+        }
+        QtConcurrent::blockingMap(pieces, &RecalculatePiece);
+
+        TestHash merged = base;
+        TestHash sequential = base;
+        for (int i = 0; i < pieces.size(); ++i)
+        {
+            merged.Merge(base, pieces.at(i).hash);
+            EditPiece(sequential, pieces.at(i));
+        }
+
+        if (SameHash(merged, sequential) == false)
+        {
+            qWarning() << "Merge failed in round" << round;
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    Q_UNUSED(a)
+
+    qWarning() << "-----------------------------------------------------------";
+    qWarning() << "Running test suite:\n";
+
+    const int failed = TestMerge();
+    if (failed == 0)
+    {
+        qWarning() << "TestMerge passed";
+    }
+    else
+    {
+        qWarning() << "TestMerge failed with" << failed << "errors";
+    }
+
+    qWarning() << "Done.";
+    qWarning() << "-----------------------------------------------------------";
+
+    return failed == 0 ? 0 : 1;
+}
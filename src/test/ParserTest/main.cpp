@@ -72,6 +72,11 @@ int main(int argc, char *argv[])
     qmu::Test::QmuParserTester pt;
     pt.Run();
 
+    if (a.arguments().contains("--benchmark"))
+    {
+        qmu::Test::QmuParserTester::Benchmark();
+    }
+
     qWarning() << "Done.";
     qWarning() << "-----------------------------------------------------------";
 